@@ -4,30 +4,76 @@
 //this code organizes vertex and index data for rendering our shapes
 
 #pragma once
+#include <vector>
 #include "Vertex.h"
+#include "boundingVolume.h"
 #include <glad/glad.h>
 
+/**
+ * Vertices and triangle list indices of a generated shape. Storage is owned by the vectors, so
+ * nothing has to be freed by hand. Indices are 16-bit whenever the vertex count allows it and
+ * 32-bit otherwise, indexType tells which of the two index vectors is in use.
+ */
 struct ShapeData
 {
-	ShapeData() :
-		vertices(0), numVertices(0),
-		indices(0), numIndices(0) {}
-	Vertex* vertices;
-	GLuint numVertices;
-	GLushort* indices;
-	GLuint numIndices;
-	GLsizeiptr vertexBufferSize() const
+	ShapeData() = default;
+	ShapeData(GLuint numVertices, GLuint numIndices) :
+		vertices(numVertices),
+		indexType(chooseIndexType(numVertices))
 	{
-		return numVertices * sizeof(Vertex);
+		if (indexType == GL_UNSIGNED_SHORT)
+			shortIndices.resize(numIndices);
+		else
+			intIndices.resize(numIndices);
 	}
-	GLsizeiptr indexBufferSize() const
+
+	std::vector<Vertex> vertices;
+	std::vector<GLushort> shortIndices; // indices when indexType is GL_UNSIGNED_SHORT
+	std::vector<GLuint> intIndices; // indices when indexType is GL_UNSIGNED_INT
+	GLenum indexType = GL_UNSIGNED_SHORT;
+	Bounds bounds; // local box and sphere of the positions, filled in by the generators
+
+	// recomputes bounds after the vertices are written
+	void computeBounds()
+	{
+		bounds = Bounds::fromPositions(vertices.empty() ? nullptr : &vertices[0].position, vertices.size(), sizeof(Vertex));
+	}
+
+	// 16-bit indices can address vertices 0 - 65535
+	static GLenum chooseIndexType(GLuint numVertices)
+	{
+		return numVertices <= 0x10000u ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	}
+	static GLsizeiptr indexByteSize(GLenum type)
 	{
-		return numIndices * sizeof(GLushort);
+		return type == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
 	}
-	void cleanup()
+	GLuint numVertices() const
+	{
+		return GLuint(vertices.size());
+	}
+	GLuint numIndices() const
+	{
+		return GLuint(indexType == GL_UNSIGNED_SHORT ? shortIndices.size() : intIndices.size());
+	}
+	GLuint index(size_t i) const
+	{
+		return indexType == GL_UNSIGNED_SHORT ? shortIndices[i] : intIndices[i];
+	}
+	const void* indexData() const
+	{
+		return indexType == GL_UNSIGNED_SHORT ? (const void*)shortIndices.data() : (const void*)intIndices.data();
+	}
+	void* indexData()
+	{
+		return indexType == GL_UNSIGNED_SHORT ? (void*)shortIndices.data() : (void*)intIndices.data();
+	}
+	GLsizeiptr vertexBufferSize() const
+	{
+		return numVertices() * sizeof(Vertex);
+	}
+	GLsizeiptr indexBufferSize() const
 	{
-		delete[] vertices;
-		delete[] indices;
-		numVertices = numIndices = 0;
+		return numIndices() * indexByteSize(indexType);
 	}
 };
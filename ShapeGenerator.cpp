@@ -3,7 +3,12 @@
 //version 2.1
 // this code provides a utility for creating basic shapes like planes and spheres. 
 
+#include <cassert>
+#include <iostream>
+#include <map>
+#include <utility>
 #include "ShapeGenerator.h"
+#include "jobSystem.h"
 //#include <glm\glm.hpp>
 //#include <glm\gtc\matrix_transform.hpp>
 #include "Vertex.h"
@@ -14,95 +19,308 @@ using glm::mat4;
 using glm::mat3;
 #define NUM_ARRAY_ELEMENTS(a) sizeof(a) / sizeof(*a)
 
-glm::vec3 randomColor()
+// rows of a plane generated by one job, big planes are split into blocks of rows over the job system
+const uint PLANE_ROWS_PER_JOB = 64;
+
+// random looking color of a vertex, hashed from its index - unlike rand() it is safe on several threads at once
+glm::vec3 randomColor(uint vertexIndex)
 {
+	uint hash = vertexIndex * 2654435761u;
+	hash ^= hash >> 16;
+	hash *= 0x45d9f3bu;
+	hash ^= hash >> 16;
 	glm::vec3 ret;
-	ret.x = rand() / (float)RAND_MAX;
-	ret.y = rand() / (float)RAND_MAX;
-	ret.z = rand() / (float)RAND_MAX;
+	ret.x = (hash & 0xFF) / 255.0f;
+	ret.y = ((hash >> 8) & 0xFF) / 255.0f;
+	ret.z = ((hash >> 16) & 0xFF) / 255.0f;
 	return ret;
 }
 
-//make plane verts
-ShapeData ShapeGenerator::makePlaneVerts(uint dimensions)
+namespace
 {
-	ShapeData ret;
-	ret.numVertices = dimensions * dimensions;
-	int half = dimensions / 2;
-	ret.vertices = new Vertex[ret.numVertices];
-	for (int i = 0; i < dimensions; i++)
+	// writes one index of a triangle list stored as 16-bit or 32-bit indices
+	struct IndexWriter
+	{
+		void* data;
+		GLenum type;
+		void operator()(size_t i, GLuint value) const
+		{
+			if (type == GL_UNSIGNED_SHORT)
+				static_cast<GLushort*>(data)[i] = (GLushort)value;
+			else
+				static_cast<GLuint*>(data)[i] = value;
+		}
+	};
+
+	// reserves ranges of the mesh in the pool, maps them and lets the generator write straight into them
+	template<typename Generator>
+	GeometryHandle streamShape(GLuint numVertices, GLuint numIndices, GeometryPool& pool, Generator generate)
 	{
-		for (int j = 0; j < dimensions; j++)
+		if (pool.getVertexStride() != sizeof(Vertex))
+		{
+			std::cerr << "Shapes can be streamed only into a geometry pool of ShapeData vertices!" << std::endl;
+			return GeometryHandle();
+		}
+
+		GeometryHandle mesh = pool.reserve(numVertices, numIndices);
+		void* vertices = nullptr;
+		void* indices = nullptr;
+		if (!mesh.isValid() || !pool.mapMesh(mesh, vertices, indices))
+		{
+			std::cerr << "Failed to reserve shape with " << numVertices << " vertices in the geometry pool!" << std::endl;
+			pool.remove(mesh);
+			return GeometryHandle();
+		}
+		generate(static_cast<Vertex*>(vertices), IndexWriter{ indices, pool.getIndexType() });
+
+		// unmapping fails when the buffer contents got lost while mapped (display mode change), data is then undefined
+		if (!pool.unmapMesh())
 		{
-			Vertex& thisVert = ret.vertices[i * dimensions + j];
-			thisVert.position.x = j - half;
-			thisVert.position.z = i - half;
-			thisVert.position.y = 0;
-			thisVert.normal = glm::vec3(0.0f, 1.0f, 0.0f);
-			thisVert.color = randomColor();
+			std::cerr << "Failed to stream shape with " << numVertices << " vertices into the geometry pool!" << std::endl;
+			pool.remove(mesh);
+			return GeometryHandle();
 		}
+		return mesh;
 	}
-	return ret;
 }
+
+GLuint ShapeGenerator::planeVertexCount(uint dimensions)
+{
+	return dimensions * dimensions;
+}
+
+GLuint ShapeGenerator::planeIndexCount(uint dimensions)
+{
+	return (dimensions - 1) * (dimensions - 1) * 2 * 3; // 2 triangles per square, 3 indices per triangle
+}
+
+//make plane verts - every vertex is written once and in order, so this is fine for write-combined mapped memory too
+void ShapeGenerator::writePlaneVerts(uint dimensions, Vertex* vertices)
+{
+	int half = dimensions / 2;
+	JobSystem::parallelFor(dimensions, PLANE_ROWS_PER_JOB, [=](size_t firstRow, size_t lastRow) {
+		for (uint i = uint(firstRow); i < lastRow; i++)
+		{
+			for (uint j = 0; j < dimensions; j++)
+			{
+				Vertex thisVert;
+				thisVert.position = vec3(float(int(j) - half), 0.0f, float(int(i) - half));
+				thisVert.normal = glm::vec3(0.0f, 1.0f, 0.0f);
+				thisVert.color = randomColor(i * dimensions + j);
+				vertices[i * dimensions + j] = thisVert;
+			}
+		}
+	});
+}
+
 //make plane indices
-ShapeData ShapeGenerator::makePlaneIndices(uint dimensions)
+template<typename IndexSink>
+void ShapeGenerator::writePlaneIndices(uint dimensions, IndexSink indices)
 {
-	ShapeData ret;
-	ret.numIndices = (dimensions - 1) * (dimensions - 1) * 2 * 3; // 2 triangles per square, 3 indices per triangle
-	ret.indices = new unsigned short[ret.numIndices];
-	int runner = 0;
-	for (int row = 0; row < dimensions - 1; row++)
-	{
-		for (int col = 0; col < dimensions - 1; col++)
+	// every row of squares owns a fixed range of indices, so blocks of rows can be written independently
+	JobSystem::parallelFor(dimensions - 1, PLANE_ROWS_PER_JOB, [=](size_t firstRow, size_t lastRow) {
+		size_t runner = firstRow * (dimensions - 1) * 6;
+		for (uint row = uint(firstRow); row < lastRow; row++)
 		{
-			ret.indices[runner++] = dimensions * row + col;
-			ret.indices[runner++] = dimensions * row + col + dimensions;
-			ret.indices[runner++] = dimensions * row + col + dimensions + 1;
+			for (uint col = 0; col < dimensions - 1; col++)
+			{
+				indices(runner++, dimensions * row + col);
+				indices(runner++, dimensions * row + col + dimensions);
+				indices(runner++, dimensions * row + col + dimensions + 1);
 
-			ret.indices[runner++] = dimensions * row + col;
-			ret.indices[runner++] = dimensions * row + col + dimensions + 1;
-			ret.indices[runner++] = dimensions * row + col + 1;
+				indices(runner++, dimensions * row + col);
+				indices(runner++, dimensions * row + col + dimensions + 1);
+				indices(runner++, dimensions * row + col + 1);
+			}
 		}
-	}
-	assert(runner = ret.numIndices);
-	return ret;
+		assert(runner == lastRow * (dimensions - 1) * 6);
+	});
 }
 
 
 ShapeData ShapeGenerator::makePlane(uint dimensions)
 {
-	ShapeData ret = makePlaneVerts(dimensions);
-	ShapeData ret2 = makePlaneIndices(dimensions);
-	ret.numIndices = ret2.numIndices;
-	ret.indices = ret2.indices;
+	ShapeData ret(planeVertexCount(dimensions), planeIndexCount(dimensions));
+	writePlaneVerts(dimensions, ret.vertices.data());
+	writePlaneIndices(dimensions, IndexWriter{ ret.indexData(), ret.indexType });
+	ret.computeBounds();
 	return ret;
 }
 
+Bounds ShapeGenerator::planeBounds(uint dimensions)
+{
+	// same corners as writePlaneVerts
+	const int half = dimensions / 2;
+	BoundingBox box;
+	box.expand(vec3(float(-half), 0.0f, float(-half)));
+	box.expand(vec3(float(int(dimensions) - 1 - half), 0.0f, float(int(dimensions) - 1 - half)));
+	return Bounds::fromBox(box);
+}
+
+GeometryHandle ShapeGenerator::streamPlane(uint dimensions, GeometryPool& pool)
+{
+	return streamShape(planeVertexCount(dimensions), planeIndexCount(dimensions), pool,
+		[dimensions](Vertex* vertices, IndexWriter indices) {
+			writePlaneVerts(dimensions, vertices);
+			writePlaneIndices(dimensions, indices);
+		});
+}
+
 //make sphere
 ShapeData ShapeGenerator::makeSphere(uint tesselation)
 {
-	ShapeData ret = makePlaneVerts(tesselation);
-	ShapeData ret2 = makePlaneIndices(tesselation);
-	ret.indices = ret2.indices;
-	ret.numIndices = ret2.numIndices;
+	// used to be the plane grid wrapped around, which left a row of vertices on each pole and a doubled seam
+	return makeUVSphere(tesselation, tesselation);
+}
+
+GLuint ShapeGenerator::uvSphereVertexCount(uint rings, uint segments)
+{
+	return 2 + (rings - 1) * segments;
+}
+
+GLuint ShapeGenerator::uvSphereIndexCount(uint rings, uint segments)
+{
+	// fan around each pole plus two triangles per quad of every band between inner rings
+	return (segments * 2 + (rings - 2) * segments * 2) * 3;
+}
+
+//make uv sphere - north pole, inner rings from north to south, south pole
+template<typename IndexSink>
+void ShapeGenerator::writeUVSphere(uint rings, uint segments, Vertex* vertices, IndexSink indices)
+{
+	const uint southPole = uvSphereVertexCount(rings, segments) - 1;
+	const auto writeVertex = [vertices](uint index, vec3 position) {
+		Vertex v;
+		v.position = position;
+		v.normal = position;
+		v.color = randomColor(index);
+		vertices[index] = v;
+	};
+
+	writeVertex(0, vec3(0.0f, 1.0f, 0.0f));
+	for (uint ring = 1; ring < rings; ring++)
+	{
+		const double theta = PI * ring / rings;
+		for (uint segment = 0; segment < segments; segment++)
+		{
+			const double phi = 2.0 * PI * segment / segments;
+			writeVertex(1 + (ring - 1) * segments + segment, vec3(float(sin(theta) * cos(phi)), float(cos(theta)), float(sin(theta) * sin(phi))));
+		}
+	}
+	writeVertex(southPole, vec3(0.0f, -1.0f, 0.0f));
 
-	uint dimensions = tesselation;
-	const float RADIUS = 1.0f;
-	const double CIRCLE = PI * 2;
-	const double SLICE_ANGLE = CIRCLE / (dimensions - 1);
-	for (size_t col = 0; col < dimensions; col++)
+	size_t runner = 0;
+	const auto ringVertex = [segments](uint ring, uint segment) { return 1 + (ring - 1) * segments + segment % segments; };
+	for (uint segment = 0; segment < segments; segment++)
 	{
-		double phi = -SLICE_ANGLE * col;
-		for (size_t row = 0; row < dimensions; row++)
+		indices(runner++, 0);
+		indices(runner++, ringVertex(1, segment + 1));
+		indices(runner++, ringVertex(1, segment));
+	}
+	for (uint ring = 1; ring < rings - 1; ring++)
+	{
+		for (uint segment = 0; segment < segments; segment++)
 		{
-			double theta = -(SLICE_ANGLE / 2.0) * row;
-			size_t vertIndex = col * dimensions + row;
-			Vertex& v = ret.vertices[vertIndex];
-			v.position.x = RADIUS * cos(phi) * sin(theta);
-			v.position.y = RADIUS * sin(phi) * sin(theta);
-			v.position.z = RADIUS * cos(theta);
-			v.normal = glm::normalize(v.position);
+			indices(runner++, ringVertex(ring, segment));
+			indices(runner++, ringVertex(ring, segment + 1));
+			indices(runner++, ringVertex(ring + 1, segment));
+
+			indices(runner++, ringVertex(ring + 1, segment));
+			indices(runner++, ringVertex(ring, segment + 1));
+			indices(runner++, ringVertex(ring + 1, segment + 1));
 		}
 	}
+	for (uint segment = 0; segment < segments; segment++)
+	{
+		indices(runner++, southPole);
+		indices(runner++, ringVertex(rings - 1, segment));
+		indices(runner++, ringVertex(rings - 1, segment + 1));
+	}
+	assert(runner == uvSphereIndexCount(rings, segments));
+}
+
+ShapeData ShapeGenerator::makeUVSphere(uint rings, uint segments)
+{
+	rings = rings < 2 ? 2 : rings;
+	segments = segments < 3 ? 3 : segments;
+
+	ShapeData ret(uvSphereVertexCount(rings, segments), uvSphereIndexCount(rings, segments));
+	writeUVSphere(rings, segments, ret.vertices.data(), IndexWriter{ ret.indexData(), ret.indexType });
+	ret.computeBounds();
+	return ret;
+}
+
+GeometryHandle ShapeGenerator::streamUVSphere(uint rings, uint segments, GeometryPool& pool)
+{
+	rings = rings < 2 ? 2 : rings;
+	segments = segments < 3 ? 3 : segments;
+
+	return streamShape(uvSphereVertexCount(rings, segments), uvSphereIndexCount(rings, segments), pool,
+		[rings, segments](Vertex* vertices, IndexWriter indices) {
+			writeUVSphere(rings, segments, vertices, indices);
+		});
+}
+
+//make icosphere
+ShapeData ShapeGenerator::makeIcosphere(uint subdivisions)
+{
+	// icosahedron from three golden rectangles
+	const float t = float((1.0 + sqrt(5.0)) / 2.0);
+	std::vector<vec3> positions = {
+		vec3(-1, t, 0), vec3(1, t, 0), vec3(-1, -t, 0), vec3(1, -t, 0),
+		vec3(0, -1, t), vec3(0, 1, t), vec3(0, -1, -t), vec3(0, 1, -t),
+		vec3(t, 0, -1), vec3(t, 0, 1), vec3(-t, 0, -1), vec3(-t, 0, 1)
+	};
+	std::vector<uint> triangles = {
+		0, 11, 5,	0, 5, 1,	0, 1, 7,	0, 7, 10,	0, 10, 11,
+		1, 5, 9,	5, 11, 4,	11, 10, 2,	10, 7, 6,	7, 1, 8,
+		3, 9, 4,	3, 4, 2,	3, 2, 6,	3, 6, 8,	3, 8, 9,
+		4, 9, 5,	2, 4, 11,	6, 2, 10,	8, 6, 7,	9, 8, 1
+	};
+	for (auto& position : positions) {
+		position = glm::normalize(position);
+	}
+
+	// every edge is split once - the midpoint is remembered so both triangles along the edge share it
+	for (uint level = 0; level < subdivisions; level++)
+	{
+		std::map<std::pair<uint, uint>, uint> midpoints;
+		const auto midpoint = [&positions, &midpoints](uint a, uint b) {
+			const auto key = a < b ? std::make_pair(a, b) : std::make_pair(b, a);
+			const auto it = midpoints.find(key);
+			if (it != midpoints.end()) {
+				return it->second;
+			}
+			positions.push_back(glm::normalize(positions[a] + positions[b]));
+			const auto index = uint(positions.size() - 1);
+			midpoints[key] = index;
+			return index;
+		};
+
+		std::vector<uint> subdivided;
+		subdivided.reserve(triangles.size() * 4);
+		for (size_t i = 0; i < triangles.size(); i += 3)
+		{
+			const uint a = triangles[i], b = triangles[i + 1], c = triangles[i + 2];
+			const uint ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+			const uint children[] = { a, ab, ca,	b, bc, ab,	c, ca, bc,	ab, bc, ca };
+			subdivided.insert(subdivided.end(), children, children + 12);
+		}
+		triangles.swap(subdivided);
+	}
+
+	ShapeData ret(GLuint(positions.size()), GLuint(triangles.size()));
+	for (uint i = 0; i < ret.numVertices(); i++)
+	{
+		ret.vertices[i].position = positions[i];
+		ret.vertices[i].normal = positions[i];
+		ret.vertices[i].color = randomColor(i);
+	}
+
+	const IndexWriter indices{ ret.indexData(), ret.indexType };
+	for (size_t i = 0; i < triangles.size(); i++) {
+		indices(i, triangles[i]);
+	}
+	ret.computeBounds();
 	return ret;
 }
@@ -4,13 +4,19 @@
 //this code is to make our shape data for our plane and sphere verts and indices
 
 #pragma once
+#include <vector>
 #include "ShapeData.h"
+#include "geometryPool.h"
 typedef unsigned int uint;
 
 class ShapeGenerator
 {
-	static ShapeData makePlaneVerts(uint dimensions);
-	static ShapeData makePlaneIndices(uint dimensions);
+	// generators write into memory given by the caller - ShapeData vectors or mapped GPU buffers
+	static void writePlaneVerts(uint dimensions, Vertex* vertices);
+	template<typename IndexSink>
+	static void writePlaneIndices(uint dimensions, IndexSink indices);
+	template<typename IndexSink>
+	static void writeUVSphere(uint rings, uint segments, Vertex* vertices, IndexSink indices);
 
 
 public:
@@ -18,4 +24,51 @@ public:
 	static ShapeData makePlane(uint dimensions = 10);
 	static ShapeData makeSphere(uint tesselation = 20);
 
+	/**
+	 * Unit UV sphere - one vertex per pole with triangle fans around it, rings in between.
+	 * There are no texture coordinates, so the seam column is not duplicated.
+	 *
+	 * @param rings     Number of latitude bands (at least 2)
+	 * @param segments  Number of longitude segments (at least 3)
+	 */
+	static ShapeData makeUVSphere(uint rings, uint segments);
+
+	/**
+	 * Unit icosphere - icosahedron with every triangle split into four, subdivisions times.
+	 * Triangles are nearly equal in size, so it needs fewer of them than a UV sphere for the same roundness.
+	 *
+	 * @param subdivisions  0 gives the icosahedron (20 triangles), every level multiplies triangles by 4
+	 */
+	static ShapeData makeIcosphere(uint subdivisions);
+
+	/**
+	 * Vertex / index counts of generated shapes, for sizing buffers before generating.
+	 */
+	static GLuint planeVertexCount(uint dimensions);
+	static GLuint planeIndexCount(uint dimensions);
+	static GLuint uvSphereVertexCount(uint rings, uint segments);
+	static GLuint uvSphereIndexCount(uint rings, uint segments);
+
+	/**
+	 * Local bounds of makePlane / streamPlane, without generating the plane.
+	 */
+	static Bounds planeBounds(uint dimensions);
+
+	/**
+	 * Generates plane straight into its ranges of a geometry pool - they are mapped and written by the
+	 * generator, so planes with millions of vertices never need a copy in system memory.
+	 * Planes above 65536 vertices need a pool with 32-bit indices.
+	 *
+	 * @param dimensions  Number of vertices along each side
+	 * @param pool        Pool of VertexFormat::shapeData vertices
+	 *
+	 * @return Handle of the plane in the pool, invalid if it could not be written.
+	 */
+	static GeometryHandle streamPlane(uint dimensions, GeometryPool& pool);
+
+	/**
+	 * Generates UV sphere straight into a geometry pool, works like streamPlane.
+	 */
+	static GeometryHandle streamUVSphere(uint rings, uint segments, GeometryPool& pool);
+
 };
@@ -16,22 +16,61 @@
 #include "shader.h"
 #include "camera.h"
 #include "cylinder.h"
+#include "meshRegistry.h"
+#include "gpuResourceTracker.h"
+#include "uniformBlocks.h"
+#include "clusteredLightGrid.h"
+#include "profiler.h"
+#include "benchmark.h"
 #include "ShapeGenerator.h"
 #include "ShapeData.h"
-
-
-
+#include "geometryPool.h"
+#include "sphereLodChain.h"
+#include "jobSystem.h"
+#include "textureManager.h"
+#include "textureCooker.h"
+#include "materialArray.h"
+#include "renderQueue.h"
+#include "glStateCache.h"
+#include "frustumCuller.h"
+#include "occlusionCuller.h"
+#include "gpuDrivenScene.h"
+#include "streamingBuffer.h"
+
+
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iomanip>
+#include <cstdlib>
 #include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow *window);
-unsigned int loadTexture(const char *path);
+LightsBlock makeSceneLights();
+std::vector<PointLightBlock> makeScenePointLights(const glm::vec3 pointLightPositions[], int numLights);
+std::vector<PointLightBlock> makeStressPointLights(int numLights);
 
 // settings
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
+const float Z_NEAR = 0.1f;
+const float Z_FAR = 100.0f;
+
+// number of lights in the stress scene when --stress-lights is given without a count
+const int DEFAULT_STRESS_LIGHT_COUNT = 1024;
+
+// cylinder slices of --bench-vertex-layouts when given without a count, about half a million vertices
+const int DEFAULT_VERTEX_LAYOUT_BENCH_SLICES = 1 << 17;
+// vertices of --bench-vertex-writer when given without a count, 32 MB of vertex data
+const int DEFAULT_VERTEX_WRITER_BENCH_VERTICES = 1 << 20;
 
 // camera
 Camera camera(glm::vec3(-2.5f, 1.0f, 5.0f));
@@ -39,23 +78,12 @@ float lastX = SCR_WIDTH / 2.0f;
 float lastY = SCR_HEIGHT / 2.0f;
 bool firstMouse = true;
 
-// offset variables for plane, sphere
+// offset variables for plane
 const uint NUM_VERTICES_PER_TRI = 3;
 const uint NUM_FLOATS_PER_VERTICE = 9;
 const uint VERTEX_BYTE_SIZE = NUM_FLOATS_PER_VERTICE * sizeof(float);
 
 
-// plane variables
-GLuint planeNumIndices;
-GLuint planeVertexArrayObjectID;
-GLuint planeIndexByteOffset;
-
-
-// sphere variables
-GLuint sphereNumIndices;
-GLuint sphereVertexArrayObjectID;
-GLuint sphereIndexByteOffset;
-
 // timing
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
@@ -65,29 +93,127 @@ glm::vec3 lightPos(1.2f, 1.0f, 2.0f);
 glm::vec3 lightColor(0.2f, 0.0f, 2.0f);
 
 
-// Function to calculate frames per second (FPS)
-double calculateFPS(GLFWwindow* window, double elapsedTime) {
-	static double frames = 0.0;
-	static double fps = 0.0;
-	frames += 1.0;
-	if (elapsedTime - fps >= 1.0) {
+// Shows frame time averaged by the profiler over the last second in the window title
+void updateWindowTitle(GLFWwindow* window, double elapsedTime) {
+	static double lastUpdate = 0.0;
+	static int frames = 0;
+	frames++;
+	if (elapsedTime - lastUpdate >= 1.0) {
+		const double frameMs = Profiler::getRecentFrameMs(frames);
 		std::ostringstream oss;
-		oss << "OpenGL 3.1.1 | FPS: " << frames;
+		oss << "OpenGL " << GLVersion.major << "." << GLVersion.minor << " | " << std::fixed << std::setprecision(2) << frameMs << " ms ("
+			<< (frameMs > 0.0 ? 1000.0 / frameMs : 0.0) << " FPS)";
 		glfwSetWindowTitle(window, oss.str().c_str());
-		fps = elapsedTime;
-		frames = 0.0;
+		lastUpdate = elapsedTime;
+		frames = 0;
 	}
-	return fps;
 }
 
-int main()
+int main(int argc, char* argv[])
 {
+	// command line: --stress-lights [count] replaces the four scene lights with many small moving ones,
+	// --profile-out <file> writes the profiler report on exit (.json for Chrome trace, CSV otherwise),
+	// --bench [frames] renders a fixed number of frames offscreen along a scripted camera path and exits,
+	// --bench-vertex-layouts [slices] measures vertex fetch of planar / interleaved / packed vertex buffers and exits,
+	// --bench-vertex-writer [vertices] measures bytes/sec of filling a vertex buffer in memory and mapped, then exits,
+	// --texcook <image> (repeatable) cooks images into .ctex files next to them and exits, --texcook-format auto|rgba8|bc1|bc3 picks their format,
+	// --texcook-size <pixels> resizes them to square layers (MATERIAL_LAYER_SIZE for the material array),
+	// --gpu-driven asks for a GL 4.5 context and draws the boxes, ball, planes and lamps culled by a compute shader with one indirect draw per shader
+	// -------------------------------------------------------------------------------------------------
+	int numStressLights = 0;
+	std::string profileOutPath;
+	bool isBenchmark = false;
+	BenchmarkOptions benchOptions;
+	bool isVertexLayoutBenchmark = false;
+	int vertexLayoutBenchSlices = DEFAULT_VERTEX_LAYOUT_BENCH_SLICES;
+	bool isVertexWriterBenchmark = false;
+	int vertexWriterBenchVertices = DEFAULT_VERTEX_WRITER_BENCH_VERTICES;
+	std::vector<std::string> texcookSources;
+	TextureCookFormat texcookFormat = TextureCookFormat::Auto;
+	int texcookSize = 0;
+	bool isGpuDrivenRequested = false;
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--bench") == 0)
+		{
+			isBenchmark = true;
+			if (i + 1 < argc && std::atoi(argv[i + 1]) > 0)
+				benchOptions.numFrames = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--bench-vertex-layouts") == 0)
+		{
+			// runs without the scene, but needs the same hidden window / headless context as --bench
+			isBenchmark = true;
+			isVertexLayoutBenchmark = true;
+			if (i + 1 < argc && std::atoi(argv[i + 1]) > 0)
+				vertexLayoutBenchSlices = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--bench-vertex-writer") == 0)
+		{
+			isBenchmark = true;
+			isVertexWriterBenchmark = true;
+			if (i + 1 < argc && std::atoi(argv[i + 1]) > 0)
+				vertexWriterBenchVertices = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--stress-lights") == 0)
+		{
+			numStressLights = DEFAULT_STRESS_LIGHT_COUNT;
+			if (i + 1 < argc && std::atoi(argv[i + 1]) > 0)
+				numStressLights = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--profile-out") == 0 && i + 1 < argc)
+		{
+			profileOutPath = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--texcook") == 0 && i + 1 < argc)
+		{
+			texcookSources.push_back(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--texcook-format") == 0 && i + 1 < argc)
+		{
+			if (!TextureCooker::parseFormat(argv[++i], texcookFormat))
+				std::cerr << "Unknown texture format " << argv[i] << ", using auto!" << std::endl;
+		}
+		else if (std::strcmp(argv[i], "--texcook-size") == 0 && i + 1 < argc && std::atoi(argv[i + 1]) > 0)
+		{
+			texcookSize = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--gpu-driven") == 0)
+		{
+			isGpuDrivenRequested = true;
+		}
+	}
+
+	// cooking needs no window or context, blocks are compressed on the job system
+	if (!texcookSources.empty())
+	{
+		JobSystem::init();
+		bool isCooked = true;
+		for (const auto& source : texcookSources)
+			isCooked = TextureCooker::cook(source, getCookedTexturePath(source), texcookFormat, static_cast<uint32_t>(texcookSize), std::cout) && isCooked;
+		JobSystem::shutdown();
+		return isCooked ? 0 : -1;
+	}
+
 	// glfw: initialize and configure
 	// ------------------------------
+#if defined(GLFW_PLATFORM_NULL) && defined(__linux__)
+	// benchmark on a box without a display (CI): GLFW 3.4 null platform with an OSMesa context (Mesa llvmpipe)
+	const bool isHeadless = isBenchmark && std::getenv("DISPLAY") == nullptr && std::getenv("WAYLAND_DISPLAY") == nullptr;
+	if (isHeadless)
+		glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#endif
 	glfwInit();
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	// compute shaders and multi draw indirect of the GPU driven path need 4.5, everything else runs on 3.3
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, isGpuDrivenRequested ? 4 : 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, isGpuDrivenRequested ? 5 : 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	if (isBenchmark)
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE); // frames go to an offscreen target, the window only owns the context
+#if defined(GLFW_PLATFORM_NULL) && defined(__linux__)
+	if (isHeadless)
+		glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+#endif
 
 #ifdef __APPLE__
 	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
@@ -96,6 +222,13 @@ int main()
 	// glfw window creation
 	// --------------------
 	GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Christopher Rode", NULL, NULL);
+	if (window == NULL && isGpuDrivenRequested)
+	{
+		std::cout << "OpenGL 4.5 is not available, drawing without the GPU driven path" << std::endl;
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+		window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Christopher Rode", NULL, NULL);
+	}
 	if (window == NULL)
 	{
 		std::cout << "Failed to create GLFW window" << std::endl;
@@ -103,12 +236,20 @@ int main()
 		return -1;
 	}
 	glfwMakeContextCurrent(window);
-	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-	glfwSetCursorPosCallback(window, mouse_callback);
-	glfwSetScrollCallback(window, scroll_callback);
+	if (isBenchmark)
+	{
+		// no input and no vsync, the camera follows the scripted path as fast as frames render
+		glfwSwapInterval(0);
+	}
+	else
+	{
+		glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+		glfwSetCursorPosCallback(window, mouse_callback);
+		glfwSetScrollCallback(window, scroll_callback);
 
-	// tell GLFW to capture our mouse
-	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+		// tell GLFW to capture our mouse
+		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+	}
 
 	// glad: load all OpenGL function pointers
 	// ---------------------------------------
@@ -117,16 +258,36 @@ int main()
 		std::cout << "Failed to initialize GLAD" << std::endl;
 		return -1;
 	}
+	const bool isGpuDriven = isGpuDrivenRequested && GpuDrivenScene::isSupported();
+	StreamingBuffer::loadEntryPoints((GLADloadproc)glfwGetProcAddress);
 	
 	// configure global opengl state
 	// -----------------------------
 	glEnable(GL_DEPTH_TEST);
+	if (isVertexLayoutBenchmark)
+	{
+		const bool isMeasured = runVertexLayoutBenchmark(std::cout, vertexLayoutBenchSlices);
+		glfwTerminate();
+		return isMeasured ? 0 : -1;
+	}
+	if (isVertexWriterBenchmark)
+	{
+		const bool isMeasured = runVertexWriterBenchmark(std::cout, vertexWriterBenchVertices);
+		glfwTerminate();
+		return isMeasured ? 0 : -1;
+	}
+	Profiler::init();
+	// worker threads for mesh generation and light binning, one less than the hardware threads
+	JobSystem::init();
 
 
 	// build and compile our shader zprogram
 	// ------------------------------------
 	Shader lightingShader("shaderfiles/6.multiple_lights.vs", "shaderfiles/6.multiple_lights.fs");
 	Shader lightCubeShader("shaderfiles/6.light_cube.vs", "shaderfiles/6.light_cube.fs");
+	// same lighting, but model matrix comes from per-instance vertex attribute
+	// and maps are sampled from texture arrays at the per-instance layer
+	Shader instancedLightingShader("shaderfiles/6.multiple_lights_instanced.vs", "shaderfiles/6.multiple_lights.fs", nullptr, "#define MATERIAL_ARRAY\n");
 
 	// set up vertex data (and buffer(s)) and configure vertex attributes
 	// ------------------------------------------------------------------
@@ -227,13 +388,13 @@ int main()
 
 	// first, configure the cube's VAO (and VBO)
 	unsigned int VBO, cubeVAO;
-	glGenVertexArrays(1, &cubeVAO);
-	glGenBuffers(1, &VBO);
+	GpuResourceTracker::genVertexArrays(1, &cubeVAO);
+	GpuResourceTracker::genBuffers(1, &VBO);
 
 	glBindBuffer(GL_ARRAY_BUFFER, VBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
-	glBindVertexArray(cubeVAO);
+	GLStateCache::bindVertexArray(cubeVAO);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
@@ -243,8 +404,8 @@ int main()
 
 	// second, configure the light's VAO (VBO stays the same; the vertices are the same for the light object which is also a 3D cube)
 	unsigned int lightCubeVAO;
-	glGenVertexArrays(1, &lightCubeVAO);
-	glBindVertexArray(lightCubeVAO);
+	GpuResourceTracker::genVertexArrays(1, &lightCubeVAO);
+	GLStateCache::bindVertexArray(lightCubeVAO);
 
 	glBindBuffer(GL_ARRAY_BUFFER, VBO);
 	// note that we update the lamp's position attribute's stride to reflect the updated buffer data
@@ -253,85 +414,258 @@ int main()
 
 
 	
-	// plane object data
-	ShapeData plane = ShapeGenerator::makePlane(20);
-
-	unsigned int planeVBO{}, planeVAO, planeVAO2;
-	glGenVertexArrays(1, &planeVAO);
-	glGenBuffers(1, &planeVBO);
-
-	glBindVertexArray(planeVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, planeVBO);
-	glBufferData(GL_ARRAY_BUFFER, plane.vertexBufferSize() + plane.indexBufferSize(), 0, GL_STATIC_DRAW);
-
-	GLsizeiptr currentOffset = 0;
-
-	glBufferSubData(GL_ARRAY_BUFFER, currentOffset, plane.vertexBufferSize(), plane.vertices);
-	currentOffset += plane.vertexBufferSize();
-
-	planeIndexByteOffset = currentOffset;
-
-	glBufferSubData(GL_ARRAY_BUFFER, currentOffset, plane.indexBufferSize(), plane.indices);
-
-	planeNumIndices = plane.numIndices;
-
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, VERTEX_BYTE_SIZE, (void*)0);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, VERTEX_BYTE_SIZE, (void*)(sizeof(float) * 3));
-	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, VERTEX_BYTE_SIZE, (void*)(sizeof(float) * 6));
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, planeVBO);
-
-	//Sphere object data
-	ShapeData sphere = ShapeGenerator::makeSphere();
-
-	unsigned int sphereVBO{}, sphereVAO;
-	glGenVertexArrays(1, &sphereVAO);
-	glGenBuffers(1, &sphereVBO);
-
-	glBindVertexArray(sphereVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, sphereVBO);
-	glBufferData(GL_ARRAY_BUFFER, sphere.vertexBufferSize() + sphere.indexBufferSize(), 0, GL_STATIC_DRAW);
-
-	currentOffset = 0;
-
-	glBufferSubData(GL_ARRAY_BUFFER, currentOffset, sphere.vertexBufferSize(), sphere.vertices);
-	currentOffset += sphere.vertexBufferSize();
+	// the plane and every sphere level share one vertex and index buffer, so switching between them binds nothing
+	GeometryPool shapePool;
+	shapePool.create(VertexFormat::shapeData(), 1 << 14, 1 << 16);
+
+	// plane object data - generated straight into its ranges of the pool, there is no copy in system memory
+	const uint planeDimensions = 20;
+	const GeometryHandle planeMesh = ShapeGenerator::streamPlane(planeDimensions, shapePool);
+	const Bounds planeBounds = ShapeGenerator::planeBounds(planeDimensions);
+
+	//Sphere object data - icosphere levels of detail, the one drawn depends on how big the ball is on screen
+	SphereLodChain sphereLods;
+	sphereLods.create(shapePool);
+
+	// cylinder mesh data - built once here and owned by the registry for the life of the context,
+	// indexed so that side and both covers go out in one draw call
+	static_meshes_3D::MeshRegistry meshRegistry;
+	// generation is deferred, so every pending mesh is generated on the job system at once and then uploaded here
+	const static_meshes_3D::MeshHandle cylinderMesh = meshRegistry.getIndexedCylinder(0.5f, 20, 1.5f, true, true, true,
+		static_meshes_3D::VertexLayout::Interleaved, static_meshes_3D::MeshInitialization::Deferred);
+	meshRegistry.buildPending();
+
+	// textures of all cylinders are layers of one array, so the soap bottle, the red cylinder and the legs
+	// differ only by per-instance data and go out in a single instanced draw
+	MaterialArray cylinderMaterials;
+	cylinderMaterials.create({ "wall.jpg", "Red_rectangle.svg.png", "A_black_image.jpg" });
+
+	// per-instance model matrices and material layers of the cylinders, these never move so they are uploaded once
+	std::vector<glm::mat4> cylinderTransforms;
+	std::vector<GLuint> cylinderLayers;
+
+	glm::mat4 cupTransform = glm::translate(glm::mat4(1.0f), glm::vec3(-0.95f, 0.89f, -1.0f));
+	cylinderTransforms.push_back(glm::scale(cupTransform, glm::vec3(1.5f)));
+	cylinderLayers.push_back(cylinderMaterials.getLayer("wall.jpg"));
+
+	glm::mat4 cup2Transform = glm::translate(glm::mat4(1.0f), glm::vec3(-3.95f, 0.65f, -2.7f));
+	cup2Transform = glm::scale(cup2Transform, glm::vec3(0.9f));
+	cylinderTransforms.push_back(glm::rotate(cup2Transform, glm::radians(-50.0f), glm::vec3(-3.95f, 0.75f, -2.7f)));
+	cylinderLayers.push_back(cylinderMaterials.getLayer("Red_rectangle.svg.png"));
+
+	for (const auto& legPosition : legPositions)
+	{
+		glm::mat4 legModel = glm::translate(glm::mat4(1.0f), legPosition);//get positions
+		cylinderTransforms.push_back(glm::scale(legModel, glm::vec3(0.9f)));//size of cylinders
+		cylinderLayers.push_back(cylinderMaterials.getLayer("A_black_image.jpg"));
+	}
+	static_meshes_3D::InstanceBuffer cylinderInstances;
+	cylinderInstances.setInstances(cylinderTransforms, cylinderLayers);
+
+	// cylinders are one queued draw, it is depth sorted by the middle of all of them
+	glm::vec3 cylinderCenter(0.0f);
+	for (const auto& transform : cylinderTransforms)
+		cylinderCenter += glm::vec3(transform[3]) / static_cast<float>(cylinderTransforms.size());
+
+	// the scene does not move, so model matrices and world bounds of all objects are computed once here -
+	// every frame the frustum culler only tests the bounds and objects outside of the view are not queued at all
+	CullList sceneBounds;
+	const Bounds cubeLocalBounds = Bounds::fromPositions(reinterpret_cast<const glm::vec3*>(vertices), sizeof(vertices) / (8 * sizeof(float)), 8 * sizeof(float));
+
+	std::vector<glm::mat4> cubeModels;
+	const size_t firstCubeBounds = sceneBounds.size();
+	for (unsigned int i = 0; i < sizeof(cubePositions) / sizeof(cubePositions[0]); i++)
+	{
+		// calculate the model matrix for each object
+		glm::mat4 model = glm::mat4(1.0f);
+		model = glm::translate(model, cubePositions[i]);
+		float angle = 0.0f * i;
+		cubeModels.push_back(glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, -5.3f, 0.5f)));
+		sceneBounds.add(cubeLocalBounds.transformed(cubeModels.back()));
+	}
 
-	sphereIndexByteOffset = currentOffset;
+	std::vector<glm::mat4> sphereModels;
+	const size_t firstSphereBounds = sceneBounds.size();
+	for (unsigned int i = 0; i < 1; i++)
+	{
+		glm::mat4 model = glm::mat4(1.0f);//make sure to initialize matrix to identity matrix first
+		model = glm::translate(model, spherePositions[i]);//get positions
+		sphereModels.push_back(glm::scale(model, glm::vec3(0.7f))); // Make it a smaller sphere
+		sceneBounds.add(sphereLods.getLocalBounds().transformed(sphereModels.back()));
+	}
 
-	glBufferSubData(GL_ARRAY_BUFFER, currentOffset, sphere.indexBufferSize(), sphere.indices);
+	std::vector<glm::mat4> planeModels;
+	const size_t firstPlaneBounds = sceneBounds.size();
+	for (unsigned int i = 0; i < 1; i++)
+	{
+		glm::mat4 model = glm::scale(glm::mat4(1.0f), glm::vec3(2.0f));//double size, affine so bounds follow the drawn plane
+		model = glm::translate(model, planePositions[i]); // Translate the model matrix to the plane's position
+		planeModels.push_back(glm::scale(model, glm::vec3(0.28f))); // Scale the model matrix to make it a smaller plane
+		sceneBounds.add(planeBounds.transformed(planeModels.back()));
+	}
 
-	sphereNumIndices = sphere.numIndices;
+	// plane2 floor
+	const glm::vec3 floorPosition(-0.5f, -1.0f, -1.0f);
+	const glm::mat4 floorModel = glm::scale(glm::translate(glm::scale(glm::mat4(1.0f), glm::vec3(4.0f)), floorPosition), glm::vec3(0.28f)); // Make it a smaller plane
+	const size_t floorBounds = sceneBounds.add(planeBounds.transformed(floorModel));
 
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, VERTEX_BYTE_SIZE, (void*)0);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, VERTEX_BYTE_SIZE, (void*)(sizeof(float) * 3));
-	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, VERTEX_BYTE_SIZE, (void*)(sizeof(float) * 6));
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sphereVBO);
+	std::vector<glm::mat4> lightCubeModels;
+	const size_t firstLightCubeBounds = sceneBounds.size();
+	for (unsigned int i = 0; i < sizeof(pointLightPositions) / sizeof(pointLightPositions[0]); i++)
+	{
+		glm::mat4 model = glm::mat4(1.0f);
+		model = glm::translate(model, pointLightPositions[i]);
+		lightCubeModels.push_back(glm::scale(model, glm::vec3(0.5f))); // Make it a smaller cube
+		sceneBounds.add(cubeLocalBounds.transformed(lightCubeModels.back()));
+	}
 
+	// cylinders are culled one instance at a time, the instance buffer is refilled only when the set of visible ones changes
+	const size_t firstCylinderBounds = sceneBounds.size();
+	const Bounds cylinderLocalBounds = meshRegistry.get(cylinderMesh)->getLocalBounds();
+	for (const auto& transform : cylinderTransforms)
+		sceneBounds.add(cylinderLocalBounds.transformed(transform));
+	std::vector<uint8_t> cylinderVisibility(cylinderTransforms.size(), 1);
+	std::vector<glm::mat4> visibleCylinderTransforms = cylinderTransforms;
+	std::vector<GLuint> visibleCylinderLayers = cylinderLayers;
+
+	FrustumCuller frustumCuller;
+	std::vector<uint8_t> sceneVisibility;
+
+	// GPU driven path: boxes, ball, planes and lamps sit in one shared buffer and the GPU culls them,
+	// lit objects and lamps are one indirect draw each. Cylinders are strips joined by primitive restart,
+	// they stay on their instanced draw in the render queue
+	GpuDrivenScene gpuScene;
+	MaterialArray sceneMaterials;
+	std::unique_ptr<Shader> indirectLightingShader, indirectLightCubeShader;
+	size_t litBatch = 0, lightCubeBatch = 0;
+	if (isGpuDriven)
+	{
+		sceneMaterials.create({ "lightblue2.jpg", "Color-Green.jpg", "A_black_image.jpg", "360.jpg" });
+		indirectLightingShader.reset(new Shader("shaderfiles/6.multiple_lights_indirect.vs", "shaderfiles/6.multiple_lights.fs", nullptr, "#define MATERIAL_ARRAY\n"));
+		indirectLightCubeShader.reset(new Shader("shaderfiles/6.light_cube_indirect.vs", "shaderfiles/6.light_cube.fs"));
+
+		std::vector<GpuDrivenScene::Vertex> cubeVertices;
+		for (size_t i = 0; i + 8 <= sizeof(vertices) / sizeof(float); i += 8)
+			cubeVertices.push_back({ glm::vec3(vertices[i], vertices[i + 1], vertices[i + 2]), glm::vec3(vertices[i + 3], vertices[i + 4], vertices[i + 5]),
+				glm::vec2(vertices[i + 6], vertices[i + 7]) });
+		std::vector<GLuint> cubeIndices(cubeVertices.size());
+		std::iota(cubeIndices.begin(), cubeIndices.end(), 0u);
+		const size_t gpuCubeMesh = gpuScene.addMesh(cubeVertices, cubeIndices);
+		const size_t gpuPlaneMesh = gpuScene.addMesh(ShapeGenerator::makePlane(planeDimensions));
+		// one level of detail, the one the LOD chain draws at middle distance
+		const size_t gpuSphereMesh = gpuScene.addMesh(ShapeGenerator::makeIcosphere(3));
+
+		litBatch = gpuScene.addBatch();
+		lightCubeBatch = gpuScene.addBatch();
+		for (const auto& model : cubeModels)
+			gpuScene.addObject(litBatch, gpuCubeMesh, model, sceneMaterials.getLayer("lightblue2.jpg"));
+		for (const auto& model : sphereModels)
+			gpuScene.addObject(litBatch, gpuSphereMesh, model, sceneMaterials.getLayer("Color-Green.jpg"));
+		for (const auto& model : planeModels)
+			gpuScene.addObject(litBatch, gpuPlaneMesh, model, sceneMaterials.getLayer("A_black_image.jpg"));
+		gpuScene.addObject(litBatch, gpuPlaneMesh, floorModel, sceneMaterials.getLayer("360.jpg"));
+		for (const auto& model : lightCubeModels)
+			gpuScene.addObject(lightCubeBatch, gpuCubeMesh, model);
+		gpuScene.upload();
+	}
 
-	// load textures (we now use a utility function to keep the code more organized)
+	// the countertop, the floor, the boxes and the two cups are big enough to hide things behind them, the occlusion
+	// culler draws them into a small depth buffer and drops objects behind them. Cylinders are round, so the cups
+	// stand in with a box inside them (x and z shrink to 0.65, below 1/sqrt(2) so corners stay inside the sliced
+	// circle too), the legs are too thin to bother
+	OcclusionCuller occlusionCuller;
+	occlusionCuller.create();
+	for (size_t i = 0; i < cubeModels.size(); i++)
+		occlusionCuller.addOccluder(cubeLocalBounds.box, cubeModels[i], firstCubeBounds + i);
+	for (size_t i = 0; i < planeModels.size(); i++)
+		occlusionCuller.addOccluder(planeBounds.box, planeModels[i], firstPlaneBounds + i);
+	occlusionCuller.addOccluder(planeBounds.box, floorModel, floorBounds);
+	BoundingBox cupLocalBox = cylinderLocalBounds.box;
+	const glm::vec3 cupInset = cupLocalBox.getExtent() * glm::vec3(0.35f, 0.0f, 0.35f);
+	cupLocalBox.min += cupInset;
+	cupLocalBox.max -= cupInset;
+	for (size_t i = 0; i < 2; i++)
+		occlusionCuller.addOccluder(cupLocalBox, cylinderTransforms[i], firstCylinderBounds + i);
+
+
+	// load textures - images decode on the job system and show a grey placeholder until they are uploaded,
+	// the same path loaded twice gives the same texture
 	// -----------------------------------------------------------------------------
-	unsigned int diffuseMap = loadTexture("lightblue2.jpg");
-	unsigned int specularMap = loadTexture("redyellowblue.png");
-	unsigned int cup = loadTexture("wall.jpg");
-	unsigned int countertop = loadTexture("A_black_image.jpg");
-	unsigned int spec = loadTexture("Color-Green.jpg");
-	unsigned int cup2 = loadTexture("Red_rectangle.svg.png");
-	unsigned int counter2top = loadTexture("A_black_image.jpg");
-	unsigned int floor = loadTexture("360.jpg");
+	TextureManager textureManager;
+	textureManager.create();
+	unsigned int diffuseMap = textureManager.load("lightblue2.jpg");
+	unsigned int countertop = textureManager.load("A_black_image.jpg");
+	unsigned int spec = textureManager.load("Color-Green.jpg");
+	unsigned int floor = textureManager.load("360.jpg");
 	// shader configuration
 	// --------------------
 	lightingShader.use();
 	lightingShader.setInt("material.diffuse", 0);
 	lightingShader.setInt("material.specular", 1);
-	lightingShader.setInt("material.cup", 3);
-	lightingShader.setInt("material.countertop", 4);
-	lightingShader.setInt("material.spec", 5);
+	lightingShader.setFloat("material.shininess", 32.0f);
+	lightingShader.setInt("clusterLightData", ClusteredLightGrid::LIGHT_DATA_TEXTURE_UNIT);
+	lightingShader.setInt("clusterGrid", ClusteredLightGrid::CLUSTER_GRID_TEXTURE_UNIT);
+	lightingShader.setInt("clusterLightIndices", ClusteredLightGrid::LIGHT_INDICES_TEXTURE_UNIT);
+	instancedLightingShader.use();
+	instancedLightingShader.setInt("material.diffuse", 0);
+	instancedLightingShader.setInt("material.specular", 1);
+	instancedLightingShader.setFloat("material.shininess", 32.0f);
+	instancedLightingShader.setInt("clusterLightData", ClusteredLightGrid::LIGHT_DATA_TEXTURE_UNIT);
+	instancedLightingShader.setInt("clusterGrid", ClusteredLightGrid::CLUSTER_GRID_TEXTURE_UNIT);
+	instancedLightingShader.setInt("clusterLightIndices", ClusteredLightGrid::LIGHT_INDICES_TEXTURE_UNIT);
+	if (indirectLightingShader)
+	{
+		indirectLightingShader->use();
+		indirectLightingShader->setInt("material.diffuse", 0);
+		indirectLightingShader->setInt("material.specular", 1);
+		indirectLightingShader->setFloat("material.shininess", 32.0f);
+		indirectLightingShader->setInt("clusterLightData", ClusteredLightGrid::LIGHT_DATA_TEXTURE_UNIT);
+		indirectLightingShader->setInt("clusterGrid", ClusteredLightGrid::CLUSTER_GRID_TEXTURE_UNIT);
+		indirectLightingShader->setInt("clusterLightIndices", ClusteredLightGrid::LIGHT_INDICES_TEXTURE_UNIT);
+	}
+
+	// camera and lights live in uniform blocks shared by all programs, so each is uploaded once per frame
+	// no matter how many shaders use them. They and the cylinder instances are written straight into a ring
+	// buffer, a new region every frame, so no upload waits for the GPU to finish reading the previous frame
+	CameraBlock cameraBlock = {};
+	LightsBlock lightsBlock = makeSceneLights();
+	StreamingBuffer frameStream;
+	frameStream.create(64 * 1024);
+
+	// model matrix is the only per-object uniform left, set through pre-resolved handles
+	const UniformId lightingModelId = lightingShader.getUniformId("model");
+	const UniformId lightCubeModelId = lightCubeShader.getUniformId("model");
+
+	// point lights are binned into view frustum clusters every frame, so fragments only shade lights close to them
+	const int numScenePointLights = sizeof(pointLightPositions) / sizeof(pointLightPositions[0]);
+	const bool isStressScene = numStressLights > 0;
+	std::vector<PointLightBlock> pointLights = isStressScene ? makeStressPointLights(numStressLights)
+		: makeScenePointLights(pointLightPositions, numScenePointLights);
+	std::vector<glm::vec3> pointLightOrigins;
+	for (const auto& light : pointLights)
+		pointLightOrigins.push_back(light.position);
+
+	ClusteredLightGrid lightGrid;
+	lightGrid.createGrid(Z_NEAR, Z_FAR);
+
+	// draws of the scene are collected every frame and submitted sorted by state
+	RenderQueue renderQueue;
+
+	// benchmark renders into its own framebuffer, so the result does not depend on the window system
+	OffscreenTarget benchTarget;
+	const CameraPath benchPath = CameraPath::makeScenePath();
+	int benchFrame = 0;
+	if (isBenchmark)
+	{
+		if (!benchTarget.create(benchOptions.width, benchOptions.height))
+		{
+			glfwTerminate();
+			return -1;
+		}
+		benchTarget.bind();
+		// every benchmark frame samples the final textures, not placeholders
+		textureManager.finishLoading();
+	}
 
 
 
@@ -339,18 +673,35 @@ int main()
 	// -----------
 	while (!glfwWindowShouldClose(window))
 	{
+		// everything the frame needs was created above, so object counts must stay flat
+		GpuResourceTracker::beginFrame();
+		Profiler::beginFrame();
+
+		// finished images replace their placeholders, a few per frame
+		{
+			ProfileScope scope("texture upload");
+			textureManager.update();
+		}
+
 		// per-frame time logic
 		// --------------------
-		float currentFrame = glfwGetTime();
+		// benchmark steps simulated time by a fixed amount, so every run animates the same way
+		float currentFrame = isBenchmark ? benchFrame * benchOptions.frameTime : static_cast<float>(glfwGetTime());
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
 		
-		//display fps in window
-		calculateFPS(window, currentFrame);
+		//display frame time in window
+		updateWindowTitle(window, glfwGetTime());
 		
 		// input
 		// -----
-		processInput(window);
+		{
+			ProfileScope scope("input");
+			if (isBenchmark)
+				camera.LookAt(benchPath.getPosition(static_cast<float>(benchFrame) / benchOptions.numFrames), benchPath.getTarget());
+			else
+				processInput(window);
+		}
 
 		// render
 		// ------
@@ -359,214 +710,141 @@ int main()
 
 
 
-		// be sure to activate shader when setting uniforms/drawing objects
-		lightingShader.use();
-		lightingShader.setVec3("viewPos", camera.Position);
-		lightingShader.setFloat("material.shininess", 32.0f);
-
-		/*
-		   Here we set all the uniforms for the 5/6 types of lights we have. We have to set them manually and index
-		   the proper PointLight struct in the array to set each uniform variable. This can be done more code-friendly
-		   by defining light types as classes and set their values in there, or by using a more efficient uniform approach
-		   by using 'Uniform buffer objects', but that is something we'll discuss in the 'Advanced GLSL' tutorial.
-		*/
-		// directional light
-		lightingShader.setVec3("dirLight.direction", -5.2f, -0.2f, 0.0f);
-		lightingShader.setVec3("dirLight.ambient", 0.05f, 0.05f, 0.05f);
-		lightingShader.setVec3("dirLight.diffuse", 0.4f, 0.4f, 0.4f);
-		lightingShader.setVec3("dirLight.specular", 0.5f, 0.5f, 0.5f);
-		// point light 1
-		lightingShader.setVec3("pointLights[0].position", pointLightPositions[0]);
-		lightingShader.setVec3("pointLights[0].ambient", 0.05f, 0.05f, 0.05f);
-		lightingShader.setVec3("pointLights[0].diffuse", 0.8f, 0.8f, 0.8f);
-		lightingShader.setVec3("pointLights[0].specular", -6.7f, 0.8f, -1.7f);
-		lightingShader.setFloat("pointLights[0].constant", 1.0f);
-		lightingShader.setFloat("pointLights[0].linear", 0.09);
-		lightingShader.setFloat("pointLights[0].quadratic", 0.032);
-		// point light 2
-		lightingShader.setVec3("pointLights[1].position", pointLightPositions[1]);
-		lightingShader.setVec3("pointLights[1].ambient", 0.05f, 0.05f, 0.05f);
-		lightingShader.setVec3("pointLights[1].diffuse", 0.8f, 0.8f, 0.8f);
-		lightingShader.setVec3("pointLights[1].specular", 1.0f, 1.0f, 1.0f);
-		lightingShader.setFloat("pointLights[1].constant", 1.0f);
-		lightingShader.setFloat("pointLights[1].linear", 0.09);
-		lightingShader.setFloat("pointLights[1].quadratic", 0.032);
-		// point light 3
-		lightingShader.setVec3("pointLights[2].position", pointLightPositions[2]);
-		lightingShader.setVec3("pointLights[2].ambient", 0.05f, 0.05f, 0.05f);
-		lightingShader.setVec3("pointLights[2].diffuse", 0.8f, 0.8f, 0.8f);
-		lightingShader.setVec3("pointLights[2].specular", 1.0f, 1.0f, 1.0f);
-		lightingShader.setFloat("pointLights[2].constant", 1.0f);
-		lightingShader.setFloat("pointLights[2].linear", 0.09);
-		lightingShader.setFloat("pointLights[2].quadratic", 0.032);
-		// point light 4
-		lightingShader.setVec3("pointLights[3].position", pointLightPositions[3]);
-		lightingShader.setVec3("pointLights[3].ambient", 0.05f, 0.05f, 0.05f);
-		lightingShader.setVec3("pointLights[3].diffuse", 0.8f, 0.8f, 0.8f);
-		lightingShader.setVec3("pointLights[3].specular", 1.0f, 1.0f, 1.0f);
-		lightingShader.setFloat("pointLights[3].constant", 1.0f);
-		lightingShader.setFloat("pointLights[3].linear", 0.09);
-		lightingShader.setFloat("pointLights[3].quadratic", 0.032);
-		// spotLight
-		lightingShader.setVec3("spotLight.position", camera.Position);
-		lightingShader.setVec3("spotLight.direction", camera.Front);
-		lightingShader.setVec3("spotLight.ambient", 0.0f, 0.0f, 0.0f);
-		lightingShader.setVec3("spotLight.diffuse", 1.0f, 1.0f, 1.0f);
-		lightingShader.setVec3("spotLight.specular", 1.0f, 1.0f, 1.0f);
-		lightingShader.setFloat("spotLight.constant", 1.0f);
-		lightingShader.setFloat("spotLight.linear", 0.09);
-		lightingShader.setFloat("spotLight.quadratic", 0.032);
-		lightingShader.setFloat("spotLight.cutOff", glm::cos(glm::radians(12.5f)));
-		lightingShader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(15.0f)));
-
 		// view/projection transformations
-		glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+		int renderWidth = benchTarget.getWidth(), renderHeight = benchTarget.getHeight();
+		if (!isBenchmark)
+			glfwGetFramebufferSize(window, &renderWidth, &renderHeight);
+		const float aspectRatio = renderWidth > 0 && renderHeight > 0 ? (float)renderWidth / (float)renderHeight : (float)SCR_WIDTH / (float)SCR_HEIGHT;
+		glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), aspectRatio, Z_NEAR, Z_FAR);
 		glm::mat4 view = camera.GetViewMatrix();
-		lightingShader.setMat4("projection", projection);
-		lightingShader.setMat4("view", view);
-
-		// world transformation
-		glm::mat4 model = glm::mat4(1.0f);
-		lightingShader.setMat4("model", model);
-
-		 //bind diffuse map
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, diffuseMap);
-
-
-		// render rectangles
-		glBindVertexArray(cubeVAO);
-		for (unsigned int i = 0; i < 3; i++)
 		{
-			// calculate the model matrix for each object and pass it to shader before drawing
-			glm::mat4 model = glm::mat4(1.0f);
-			model = glm::translate(model, cubePositions[i]);
-			float angle = 0.0f * i;
-			model = glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, -5.3f, 0.5f));
-			lightingShader.setMat4("model", model);
-
-			glDrawArrays(GL_TRIANGLES, 0, 36);
+			ProfileScope scope("frustum culling");
+			frustumCuller.setViewProjection(projection * view);
+			frustumCuller.cull(sceneBounds, sceneVisibility);
 		}
 
+		// occluders rasterize on a worker while the main thread updates uniforms and bins lights
+		occlusionCuller.beginCulling(projection * view, sceneBounds, sceneVisibility);
 
-		//assign shapes
-		unsigned int  VBO, cubeVAO, cylinderVAO, cylinder2VAO;
-		glGenVertexArrays(1, &cubeVAO);
-		glGenBuffers(1, &VBO);
-
-		glBindBuffer(GL_ARRAY_BUFFER, VBO);
-		glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-		//draw cube attributes
-		glBindVertexArray(cubeVAO);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-		glEnableVertexAttribArray(2);
-
-		glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+		{
+			ProfileScope scope("uniform setup");
+			frameStream.beginFrame();
+			cameraBlock.projection = projection;
+			cameraBlock.view = view;
+			cameraBlock.viewPos = camera.Position;
+			frameStream.bindRange(GL_UNIFORM_BUFFER, CAMERA_BLOCK_BINDING,
+				frameStream.push(&cameraBlock, sizeof(CameraBlock), frameStream.getUniformAlignment()));
+
+			// the spot light is attached to the camera, the region of this frame gets the whole block anyway
+			lightsBlock.spotLight.position = camera.Position;
+			lightsBlock.spotLight.direction = camera.Front;
+			frameStream.bindRange(GL_UNIFORM_BUFFER, LIGHTS_BLOCK_BINDING,
+				frameStream.push(&lightsBlock, sizeof(LightsBlock), frameStream.getUniformAlignment()));
+		}
 
-		
-		
-		//soap bottle
-		//draw cylinder 1
-		glGenVertexArrays(1, &cylinderVAO);
-		glBindVertexArray(cylinderVAO);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-		glEnableVertexAttribArray(2);
-		
-		//Add texture
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, cup);
-		glBindVertexArray(cylinderVAO);
-		
-		//set size, position and lighting shader
-		model = glm::mat4(1.0f); // make sure to initialize matrix to identity matrix first		
-		model = glm::translate(model, glm::vec3(-0.95f, 0.89f, -1.0f));
-		model = glm::scale(model, glm::vec3(1.5f));
-		lightingShader.setMat4("model", model);
-		static_meshes_3D::Cylinder C(0.5, 20, 1.5, true, true, true);
-		C.render();
-		
+		{
+			ProfileScope scope("light binning");
+			// stress lights circle around where they were placed, so the grid is rebuilt from moving lights
+			if (isStressScene)
+			{
+				for (size_t i = 0; i < pointLights.size(); i++)
+				{
+					const float phase = currentFrame + static_cast<float>(i);
+					pointLights[i].position = pointLightOrigins[i] + glm::vec3(glm::cos(phase), 0.0f, glm::sin(phase)) * 0.5f;
+				}
+			}
 
+			lightGrid.update(pointLights, view, projection, renderWidth, renderHeight);
+			lightGrid.bindTextures();
+		}
+		Profiler::addCounter("point lights", static_cast<double>(lightGrid.getStats().numLights));
+		Profiler::addCounter("busiest cluster lights", static_cast<double>(lightGrid.getStats().maxLightsPerCluster));
 
-		//red cylinder
-		//draw cylinder 2 
-		glGenVertexArrays(1, &cylinder2VAO);
-		glBindVertexArray(cylinder2VAO);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 10 * sizeof(float), (void*)0);
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-		glEnableVertexAttribArray(2);
-
-		//Add texture
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, cup2);
-		glBindVertexArray(cylinderVAO);
-
-
-		//set size, position and lighting shader
-		model = glm::mat4(1.0f); // make sure to initialize matrix to identity matrix first		
-		model = glm::translate(model, glm::vec3(-3.95f, 0.65f, -2.7f));
-		model = glm::scale(model, glm::vec3(0.9f));
-		float angle = -50.0f;
-		model = glm::rotate(model, glm::radians(angle) , glm::vec3(-3.95f, 0.75f, -2.7f));
-		lightingShader.setMat4("model", model);
-		C.render();
-
-		/* Modified 4/1/2024
-		Created cylinder instancing algorithm for the legs of desk.
-		This approach benefits from OpenGL instancing, resulting in better performance, reduced overhead compared to drawing each cylinder separately
-		and less redundant code.
-		Time complexity began at 0(12) and was reduced to 0(1).
-		*/
-
-		// Using a loop for rendering all cylinders at once
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, countertop);
-		glBindVertexArray(cylinderVAO);
-
-		// Loop through all legs to render cylinders
-		//loops 12 times for desk legs
-		for (unsigned int i = 0; i < 12; i++)
 		{
-			model = glm::mat4(1.0f); // make sure to initialize matrix to identity matrix first		
-			model = glm::translate(model, legPositions[i]);//get positions
-			model = glm::scale(model, glm::vec3(0.9f));//size of cylinders
-			lightingShader.setMat4("model", model);//set shader
-			C.render();//render
+			ProfileScope scope("occlusion wait");
+			occlusionCuller.finishCulling(sceneVisibility);
 		}
 
+		// scene objects go through the render queue - it sorts the draws by shader, texture and VAO, so each of
+		// them is bound once per frame, and front to back among draws sharing them
 
-		/* Modified 4/1/2024
-		Created sphere instancing algorithm for the tennis ball.
-		This approach benefits from OpenGL instancing, resulting in better performance, reduced overhead compared to drawing each sphere separately
-		and less redundant code required in the future.
-		Time complexity remains the same since we are only creating one sphere right now but is set up like the cylinders for less redundant code and better performance in the future.
-		*/
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, spec);
-		glBindVertexArray(sphereVAO);
-
-		//loops once for one sphere
-		for (unsigned int i = 0; i < 1; i++)
+		renderQueue.begin(view, Z_FAR);
 		{
-			model = model = glm::mat4(1.0f);//make sure to initialize matrix to identity matrix first	
-			model = glm::translate(model, spherePositions[i]);//get positions
-			model = glm::scale(model, glm::vec3(0.7f)); // Make it a smaller sphere
-			lightingShader.setMat4("model", model);//set shaders
-			//draw sphere
-			glDrawElements(GL_TRIANGLES, sphereNumIndices, GL_UNSIGNED_SHORT, (void*)sphereIndexByteOffset);
+			ProfileScope scope("queue draws");
+			DrawPacket cubePacket;
+			cubePacket.program = lightingShader.ID;
+			cubePacket.texture = diffuseMap;
+			cubePacket.vao = cubeVAO;
+			cubePacket.modelLocation = lightingModelId.location;
+			cubePacket.count = 36;
+
+			// render rectangles
+			for (size_t i = 0; i < cubeModels.size(); i++)
+			{
+				if (isGpuDriven || !sceneVisibility[firstCubeBounds + i])
+					continue;
+				cubePacket.model = cubeModels[i];
+				renderQueue.push(cubePacket, cubePositions[i]);
+			}
 
+			/* Modified 4/1/2024
+			Created cylinder instancing algorithm for the legs of desk.
+			This approach benefits from OpenGL instancing, resulting in better performance, reduced overhead compared to drawing each cylinder separately
+			and less redundant code.
+			Time complexity began at 0(12) and was reduced to 0(1).
+			Modified 10/17/2026
+			Legs are now drawn with hardware instancing, all 12 of them cost one draw call per cylinder part.
+			Soap bottle, red cylinder and legs now share one draw call, each instance picks its texture array layer.
+			Only instances inside the view frustum are in the instance buffer.
+			*/
+			if (!std::equal(cylinderVisibility.begin(), cylinderVisibility.end(), sceneVisibility.begin() + firstCylinderBounds))
+			{
+				std::copy(sceneVisibility.begin() + firstCylinderBounds, sceneVisibility.begin() + firstCylinderBounds + cylinderVisibility.size(),
+					cylinderVisibility.begin());
+				visibleCylinderTransforms.clear();
+				visibleCylinderLayers.clear();
+				for (size_t i = 0; i < cylinderTransforms.size(); i++)
+				{
+					if (cylinderVisibility[i])
+					{
+						visibleCylinderTransforms.push_back(cylinderTransforms[i]);
+						visibleCylinderLayers.push_back(cylinderLayers[i]);
+					}
+				}
+			}
+			// instances go to the region of this frame, the own buffer is only used when the region is full
+			if (!visibleCylinderTransforms.empty() && !cylinderInstances.streamInstances(frameStream, visibleCylinderTransforms, visibleCylinderLayers))
+				cylinderInstances.setInstances(visibleCylinderTransforms, visibleCylinderLayers, GL_DYNAMIC_DRAW);
+			if (std::find(cylinderVisibility.begin(), cylinderVisibility.end(), 1) != cylinderVisibility.end())
+			{
+				DrawPacket cylinderPacket;
+				cylinderPacket.program = instancedLightingShader.ID;
+				cylinderPacket.textureTarget = GL_TEXTURE_2D_ARRAY;
+				cylinderPacket.texture = cylinderMaterials.getTextureID();
+				meshRegistry.get(cylinderMesh)->enqueueInstanced(renderQueue, cylinderInstances, cylinderPacket, cylinderCenter);
+			}
 
+			/* Modified 4/1/2024
+			Created sphere instancing algorithm for the tennis ball.
+			This approach benefits from OpenGL instancing, resulting in better performance, reduced overhead compared to drawing each sphere separately
+			and less redundant code required in the future.
+			Time complexity remains the same since we are only creating one sphere right now but is set up like the cylinders for less redundant code and better performance in the future.
+			*/
+			DrawPacket spherePacket;
+			spherePacket.program = lightingShader.ID;
+			spherePacket.texture = spec;
+			spherePacket.modelLocation = lightingModelId.location;
 
+			for (size_t i = 0; i < sphereModels.size(); i++)
+			{
+				if (isGpuDriven || !sceneVisibility[firstSphereBounds + i])
+					continue;
+				spherePacket.model = sphereModels[i];
+				//draw sphere, radius 0.7 after scaling the unit sphere
+				const int sphereLevel = sphereLods.selectLevel(spherePositions[i], 0.7f, view, projection, renderHeight);
+				sphereLods.enqueue(renderQueue, spherePacket, sphereLevel, spherePositions[i]);
+				Profiler::addCounter("sphere triangles", sphereLods.getNumTriangles(sphereLevel));
+			}
 
 			/* Modified 4/1/2024
 			Created sphere instancing algorithm for the black plane.
@@ -574,66 +852,118 @@ int main()
 			and less redundant code required in the future.
 			Time complexity remains the same since we are only creating one plane right now but is set up like the cylinders for less redundant code and better performance in the future.
 			*/
-			glActiveTexture(GL_TEXTURE0);// Activate texture unit 0
-			glBindTexture(GL_TEXTURE_2D, countertop);// Bind the countertop texture to the active texture unit
-			glBindVertexArray(planeVAO); // Bind the plane Vertex Array Object (VAO)
+			DrawPacket planePacket;
+			planePacket.program = lightingShader.ID;
+			planePacket.texture = countertop;
+			planePacket.modelLocation = lightingModelId.location;
+			shapePool.fillPacket(planeMesh, planePacket);
 
-			//loops once for one black plane
-			for (unsigned int i = 0; i < 1; i++)
+			for (size_t i = 0; i < planeModels.size(); i++)
 			{
-				model = model = glm::mat4(2.0f);//make sure to initialize matrix to identity matrix first	
-				model = glm::translate(model, planePositions[i]); // Translate the model matrix to the plane's position
-				model = glm::scale(model, glm::vec3(0.28f)); // Scale the model matrix to make it a smaller plane
-				lightingShader.setMat4("model", model);// Set the "model" uniform in the lighting shader
+				if (isGpuDriven || !sceneVisibility[firstPlaneBounds + i])
+					continue;
+				planePacket.model = planeModels[i];
+				renderQueue.push(planePacket, planePositions[i]);
+			}
 
-				// draw plane
-				glDrawElements(GL_TRIANGLES, planeNumIndices, GL_UNSIGNED_SHORT, (void*)planeIndexByteOffset);
+			// plane2 floor
+			if (!isGpuDriven && sceneVisibility[floorBounds])
+			{
+				planePacket.texture = floor;
+				planePacket.model = floorModel;
+				renderQueue.push(planePacket, floorPosition);
 			}
 
-		// setup to draw plane2 floor
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, floor);
-		glBindVertexArray(planeVAO);
-		model = model = glm::mat4(4.0f);
-		model = glm::translate(model, glm::vec3(-0.5f, -1.0f, -1.0f));
-		model = glm::scale(model, glm::vec3(0.28f)); // Make it a smaller plane
-		lightingShader.setMat4("model", model);
-
-		// draw plane
-		glDrawElements(GL_TRIANGLES, planeNumIndices, GL_UNSIGNED_SHORT, (void*)planeIndexByteOffset);
-		
+			// also draw the lamp object(s), as many light bulbs as we have point lights
+			DrawPacket lightCubePacket;
+			lightCubePacket.program = lightCubeShader.ID;
+			lightCubePacket.vao = lightCubeVAO;
+			lightCubePacket.modelLocation = lightCubeModelId.location;
+			lightCubePacket.count = 36;
+			for (size_t i = 0; i < lightCubeModels.size(); i++)
+			{
+				if (isGpuDriven || !sceneVisibility[firstLightCubeBounds + i])
+					continue;
+				lightCubePacket.model = lightCubeModels[i];
+				renderQueue.push(lightCubePacket, pointLightPositions[i]);
+			}
 		}
 
+		{
+			ProfileScope scope("scene draws", true);
+			frameStream.finishWrites();
+			renderQueue.submit();
+		}
 
-
-		// also draw the lamp object(s)
-		lightCubeShader.use();
-		lightCubeShader.setMat4("projection", projection);
-		lightCubeShader.setMat4("view", view);
-
-		// we now draw as many light bulbs as we have point lights.
-		glBindVertexArray(lightCubeVAO);
-		for (unsigned int i = 0; i < 5; i++)
+		// GPU driven objects are culled and drawn without touching them on the CPU, the frustum planes are
+		// the ones the CPU culler extracted at the start of the frame
+		if (isGpuDriven)
 		{
-			model = glm::mat4(2.0f);
-			model = glm::translate(model, pointLightPositions[i]);
-			model = glm::scale(model, glm::vec3(0.5f)); // Make it a smaller cube
-			lightCubeShader.setMat4("model", model);
-			glDrawArrays(GL_TRIANGLES, 0, 36);
+			ProfileScope scope("gpu driven draws", true);
+			gpuScene.cull(frustumCuller);
+			indirectLightingShader->use();
+			sceneMaterials.bind(0);
+			gpuScene.draw(litBatch);
+			indirectLightCubeShader->use();
+			gpuScene.draw(lightCubeBatch);
 		}
 
+		// every draw reading the region of this frame is issued, the region is written again once the fence passes
+		frameStream.endFrame();
+
 
 		// glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
 		// -------------------------------------------------------------------------------
-		glfwSwapBuffers(window);
-		glfwPollEvents();
+		{
+			ProfileScope scope("swap buffers");
+			if (isBenchmark)
+			{
+				// nothing is presented, wait for the GPU instead so frame time covers its work too
+				glFinish();
+				if (++benchFrame >= benchOptions.numFrames)
+					glfwSetWindowShouldClose(window, true);
+			}
+			else
+			{
+				glfwSwapBuffers(window);
+			}
+			glfwPollEvents();
+		}
+
+		GLStateCache::reportFrameCounters();
+		Profiler::endFrame();
+		GpuResourceTracker::endFrame();
 	}
 
 	// optional: de-allocate all resources once they've outlived their purpose:
 	// ------------------------------------------------------------------------
-	glDeleteVertexArrays(1, &cubeVAO);
-	glDeleteVertexArrays(1, &lightCubeVAO);
-	glDeleteBuffers(1, &VBO);
+	GpuResourceTracker::deleteVertexArrays(1, &cubeVAO);
+	GpuResourceTracker::deleteVertexArrays(1, &lightCubeVAO);
+	GpuResourceTracker::deleteBuffers(1, &VBO);
+	sphereLods.deleteChain();
+	shapePool.deletePool();
+	textureManager.deleteTextures();
+	cylinderInstances.deleteBuffer();
+	gpuScene.deleteScene();
+	sceneMaterials.deleteArray();
+	cylinderMaterials.deleteArray();
+	frameStream.deleteBuffer();
+	lightGrid.deleteGrid();
+	benchTarget.deleteTarget();
+	Profiler::shutdown();
+	meshRegistry.clear();
+	JobSystem::shutdown();
+
+	// everything should be gone now, anything left over is a leak
+	GpuResourceTracker::printLiveCounts(std::cout);
+
+	std::cout << pointLights.size() << " point lights, " << ClusteredLightGrid::NUM_CLUSTERS << " clusters"
+		<< (isStressScene ? " (stress scene)" : "") << std::endl;
+	Profiler::printSummary(std::cout);
+	if (isBenchmark)
+		printBenchmarkReport(std::cout, benchOptions);
+	if (!profileOutPath.empty())
+		Profiler::writeReport(profileOutPath);
 
 	// glfw: terminate, clearing all previously allocated GLFW resources.
 	// ------------------------------------------------------------------
@@ -698,43 +1028,76 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 	camera.ProcessMouseScroll(yoffset);
 }
 
-
-
-// utility function for loading a 2D texture from file
-// ---------------------------------------------------
-unsigned int loadTexture(char const* path)
+// fills the Lights uniform block with the directional light and the spot light, the spot light direction
+// and position follow the camera and are updated in the render loop
+// ---------------------------------------------------------------------------------
+LightsBlock makeSceneLights()
 {
-	unsigned int textureID;
-	glGenTextures(1, &textureID);
+	LightsBlock lights = {};
+	/*
+	   Here we fill the lights that affect every fragment. The whole block is uploaded to the Lights uniform buffer
+	   in one call and shared by every lighting shader, so the values are no longer set uniform by uniform on each program.
+	   Point lights are not part of the block, see makeScenePointLights.
+	*/
+	// directional light
+	lights.dirLight.direction = glm::vec3(-5.2f, -0.2f, 0.0f);
+	lights.dirLight.ambient = glm::vec3(0.05f, 0.05f, 0.05f);
+	lights.dirLight.diffuse = glm::vec3(0.4f, 0.4f, 0.4f);
+	lights.dirLight.specular = glm::vec3(0.5f, 0.5f, 0.5f);
+	// spotLight
+	lights.spotLight.ambient = glm::vec3(0.0f, 0.0f, 0.0f);
+	lights.spotLight.diffuse = glm::vec3(1.0f, 1.0f, 1.0f);
+	lights.spotLight.specular = glm::vec3(1.0f, 1.0f, 1.0f);
+	lights.spotLight.constant = 1.0f;
+	lights.spotLight.linear = 0.09f;
+	lights.spotLight.quadratic = 0.032f;
+	lights.spotLight.cutOff = glm::cos(glm::radians(12.5f));
+	lights.spotLight.outerCutOff = glm::cos(glm::radians(15.0f));
+	return lights;
+}
 
-	int width, height, nrComponents;
-	unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
-	if (data)
+// builds the point lights of the scene, the first one keeps its colored specular highlight
+// ---------------------------------------------------------------------------------
+std::vector<PointLightBlock> makeScenePointLights(const glm::vec3 pointLightPositions[], int numLights)
+{
+	std::vector<PointLightBlock> lights(numLights);
+	for (int i = 0; i < numLights; i++)
 	{
-		GLenum format;
-		if (nrComponents == 1)
-			format = GL_RED;
-		else if (nrComponents == 3)
-			format = GL_RGB;
-		else if (nrComponents == 4)
-			format = GL_RGBA;
-
-		glBindTexture(GL_TEXTURE_2D, textureID);
-		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		stbi_image_free(data);
+		lights[i].position = pointLightPositions[i];
+		lights[i].ambient = glm::vec3(0.05f, 0.05f, 0.05f);
+		lights[i].diffuse = glm::vec3(0.8f, 0.8f, 0.8f);
+		lights[i].specular = i == 0 ? glm::vec3(-6.7f, 0.8f, -1.7f) : glm::vec3(1.0f, 1.0f, 1.0f);
+		lights[i].constant = 1.0f;
+		lights[i].linear = 0.09f;
+		lights[i].quadratic = 0.032f;
+		lights[i].radius = ClusteredLightGrid::computeLightRadius(lights[i]);
 	}
-	else
+	return lights;
+}
+
+// builds many small dim colored lights (radius under 2 units) spread over the desk and the floor, the seed is fixed so every run
+// of the stress scene lights the same way and frame times can be compared
+// ---------------------------------------------------------------------------------
+std::vector<PointLightBlock> makeStressPointLights(int numLights)
+{
+	std::mt19937 random(1024);
+	std::uniform_real_distribution<float> x(-9.0f, 2.0f);
+	std::uniform_real_distribution<float> y(-3.5f, 2.0f);
+	std::uniform_real_distribution<float> z(-7.0f, 3.0f);
+	std::uniform_real_distribution<float> channel(0.1f, 0.5f);
+
+	std::vector<PointLightBlock> lights(numLights);
+	for (auto& light : lights)
 	{
-		std::cout << "Texture failed to load at path: " << path << std::endl;
-		stbi_image_free(data);
+		const glm::vec3 color(channel(random), channel(random), channel(random));
+		light.position = glm::vec3(x(random), y(random), z(random));
+		light.ambient = glm::vec3(0.0f);
+		light.diffuse = color;
+		light.specular = color;
+		light.constant = 1.0f;
+		light.linear = 2.0f;
+		light.quadratic = 8.0f;
+		light.radius = ClusteredLightGrid::computeLightRadius(light);
 	}
-
-	return textureID;
+	return lights;
 }
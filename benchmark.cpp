@@ -0,0 +1,345 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code drives the scene without a user for --bench runs: scripted camera path, offscreen target and the final report
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+// Project
+#include "benchmark.h"
+#include "cylinder.h"
+#include "glStateCache.h"
+#include "gpuResourceTracker.h"
+#include "profiler.h"
+#include "shader.h"
+#include "vertexBufferObject.h"
+
+namespace {
+
+    const int VERTEX_LAYOUT_WARMUP_DRAWS = 8; // Draws before measuring, so buffers are resident in GPU memory
+    const int VERTEX_LAYOUT_SAMPLES = 31; // Timed samples per layout, the median is reported
+    const int VERTEX_LAYOUT_DRAWS_PER_SAMPLE = 16; // Draws inside one timer query
+    const int VERTEX_WRITER_SAMPLES = 15; // Timed buffer fills per path, the median is reported
+
+    /**
+     * Vertex of the writer benchmark, same size as an interleaved position / texture coordinate / normal vertex.
+     */
+    struct BenchVertex
+    {
+        glm::vec3 position;
+        glm::vec2 textureCoordinate;
+        glm::vec3 normal;
+    };
+
+    /**
+     * Vertex with given index, so per vertex paths cannot be folded into a bulk fill by the compiler.
+     */
+    BenchVertex makeBenchVertex(int index)
+    {
+        const auto value = static_cast<float>(index);
+        return { glm::vec3(value, value * 0.5f, 1.0f), glm::vec2(value * 0.25f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f) };
+    }
+
+} // namespace
+
+CameraPath::CameraPath(const std::vector<glm::vec3>& keyPositions, const glm::vec3& target)
+    : keyPositions_(keyPositions)
+    , target_(target)
+{
+    if (keyPositions_.size() < 4) {
+        std::cerr << "Camera path needs at least 4 key positions, got " << keyPositions_.size() << "!" << std::endl;
+    }
+}
+
+CameraPath CameraPath::makeScenePath()
+{
+    // One loop around the desk, dipping under the tabletop on the far side and rising above the lamps
+    const std::vector<glm::vec3> keyPositions = {
+        glm::vec3(-2.5f, 1.0f, 5.0f),
+        glm::vec3(3.0f, 1.5f, 2.0f),
+        glm::vec3(4.0f, 3.0f, -5.0f),
+        glm::vec3(-3.5f, 6.5f, -10.0f),
+        glm::vec3(-11.0f, -1.5f, -6.0f),
+        glm::vec3(-10.0f, 0.5f, 3.0f)
+    };
+    return CameraPath(keyPositions, glm::vec3(-3.5f, 0.0f, -2.0f));
+}
+
+glm::vec3 CameraPath::getPosition(float t) const
+{
+    const auto numKeys = static_cast<int>(keyPositions_.size());
+    if (numKeys < 4) {
+        return numKeys > 0 ? keyPositions_[0] : glm::vec3(0.0f);
+    }
+
+    const auto scaledT = (t - std::floor(t)) * numKeys;
+    const auto segment = static_cast<int>(scaledT) % numKeys;
+    const auto u = scaledT - std::floor(scaledT);
+
+    const auto& p0 = keyPositions_[(segment + numKeys - 1) % numKeys];
+    const auto& p1 = keyPositions_[segment];
+    const auto& p2 = keyPositions_[(segment + 1) % numKeys];
+    const auto& p3 = keyPositions_[(segment + 2) % numKeys];
+
+    // Uniform Catmull-Rom, passes through p1 at u = 0 and p2 at u = 1
+    return 0.5f * ((2.0f * p1) + (p2 - p0) * u + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * (u * u)
+        + (3.0f * p1 - p0 - 3.0f * p2 + p3) * (u * u * u));
+}
+
+const glm::vec3& CameraPath::getTarget() const
+{
+    return target_;
+}
+
+OffscreenTarget::~OffscreenTarget()
+{
+    deleteTarget();
+}
+
+bool OffscreenTarget::create(int width, int height)
+{
+    if (framebufferID_ != 0)
+    {
+        std::cerr << "This offscreen target is already created! You need to delete it before re-creating it!" << std::endl;
+        return false;
+    }
+
+    GpuResourceTracker::genFramebuffers(1, &framebufferID_);
+    GpuResourceTracker::genRenderbuffers(2, renderbufferIDs_);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbufferIDs_[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbufferIDs_[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebufferID_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbufferIDs_[0]);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, renderbufferIDs_[1]);
+    const auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    width_ = width;
+    height_ = height;
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cerr << "Offscreen target " << width << "x" << height << " is not complete (status 0x" << std::hex << status << std::dec << ")!" << std::endl;
+        deleteTarget();
+        return false;
+    }
+
+    return true;
+}
+
+void OffscreenTarget::bind() const
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, framebufferID_);
+    glViewport(0, 0, width_, height_);
+}
+
+int OffscreenTarget::getWidth() const
+{
+    return width_;
+}
+
+int OffscreenTarget::getHeight() const
+{
+    return height_;
+}
+
+void OffscreenTarget::deleteTarget()
+{
+    if (framebufferID_ == 0) {
+        return;
+    }
+
+    GpuResourceTracker::deleteFramebuffers(1, &framebufferID_);
+    GpuResourceTracker::deleteRenderbuffers(2, renderbufferIDs_);
+    framebufferID_ = 0;
+    renderbufferIDs_[0] = renderbufferIDs_[1] = 0;
+    width_ = height_ = 0;
+}
+
+void printBenchmarkReport(std::ostream& os, const BenchmarkOptions& options)
+{
+    const auto frameTime = Profiler::getFrameTimeStats();
+    const auto drawCalls = Profiler::getCounterStats("draw calls");
+    const auto triangles = Profiler::getCounterStats("triangles");
+
+    os << "==== Benchmark: " << options.numFrames << " frames at " << options.width << "x" << options.height << " ====" << std::endl;
+    os << std::fixed << std::setprecision(3);
+    os << "BENCH frame_ms avg=" << frameTime.average << " p50=" << frameTime.p50 << " p95=" << frameTime.p95
+        << " p99=" << frameTime.p99 << " max=" << frameTime.max << std::endl;
+    os << std::setprecision(1);
+    os << "BENCH draw_calls_per_frame avg=" << drawCalls.average << " max=" << drawCalls.max << std::endl;
+    os << "BENCH triangles_per_frame avg=" << triangles.average << " max=" << triangles.max << std::endl;
+    os << std::defaultfloat;
+}
+
+bool runVertexLayoutBenchmark(std::ostream& os, int numSlices)
+{
+    using static_meshes_3D::Cylinder;
+    using static_meshes_3D::VertexLayout;
+
+    const struct
+    {
+        VertexLayout layout;
+        const char* name;
+    } layouts[] = {
+        { VertexLayout::Planar, "planar" },
+        { VertexLayout::Interleaved, "interleaved" },
+        { VertexLayout::InterleavedPacked, "interleaved_packed" }
+    };
+
+    Shader fetchShader("shaderfiles/vertex_fetch.vs", "shaderfiles/vertex_fetch.fs");
+    GLuint queryID = 0;
+    GpuResourceTracker::genQueries(1, &queryID);
+
+    os << "==== Vertex layout benchmark: cylinder with " << numSlices << " slices, "
+        << VERTEX_LAYOUT_DRAWS_PER_SAMPLE << " draws per sample ====" << std::endl;
+
+    // Nothing gets rasterized, so fragment work cannot hide differences in vertex fetch
+    glEnable(GL_RASTERIZER_DISCARD);
+    fetchShader.use();
+
+    auto isMeasured = true;
+    for (const auto& entry : layouts)
+    {
+        Cylinder cylinder(1.0f, numSlices, 1.0f, true, true, true, entry.layout);
+        for (auto i = 0; i < VERTEX_LAYOUT_WARMUP_DRAWS; i++) {
+            cylinder.render();
+        }
+
+        std::vector<double> sampleMs;
+        for (auto sample = 0; sample < VERTEX_LAYOUT_SAMPLES; sample++)
+        {
+            glBeginQuery(GL_TIME_ELAPSED, queryID);
+            for (auto i = 0; i < VERTEX_LAYOUT_DRAWS_PER_SAMPLE; i++) {
+                cylinder.render();
+            }
+            glEndQuery(GL_TIME_ELAPSED);
+
+            // Waiting for the result is fine here, the benchmark is the only thing running
+            GLuint64 elapsedNs = 0;
+            glGetQueryObjectui64v(queryID, GL_QUERY_RESULT, &elapsedNs);
+            sampleMs.push_back(static_cast<double>(elapsedNs) / 1.0e6);
+        }
+
+        std::sort(sampleMs.begin(), sampleMs.end());
+        const auto medianMs = sampleMs[sampleMs.size() / 2];
+        const auto verticesPerSample = static_cast<double>(cylinder.getNumVertices()) * VERTEX_LAYOUT_DRAWS_PER_SAMPLE;
+        const auto bufferBytes = static_cast<double>(cylinder.getNumVertices()) * cylinder.getVertexByteSize();
+        if (medianMs <= 0.0) {
+            isMeasured = false;
+        }
+
+        os << std::fixed << std::setprecision(3);
+        os << "BENCH vertex_layout=" << entry.name << " bytes_per_vertex=" << cylinder.getVertexByteSize()
+            << " buffer_mb=" << bufferBytes / (1024.0 * 1024.0) << " median_ms=" << medianMs
+            << " mverts_per_s=" << (medianMs > 0.0 ? verticesPerSample / (medianMs * 1000.0) : 0.0)
+            << " gb_per_s=" << (medianMs > 0.0 ? bufferBytes * VERTEX_LAYOUT_DRAWS_PER_SAMPLE / (medianMs * 1.0e6) : 0.0) << std::endl;
+        os << std::defaultfloat;
+    }
+
+    glDisable(GL_RASTERIZER_DISCARD);
+    GLStateCache::useProgram(0);
+    glDeleteProgram(fetchShader.ID);
+    GpuResourceTracker::deleteQueries(1, &queryID);
+
+    if (!isMeasured) {
+        std::cerr << "Vertex layout benchmark got no GPU timings, timer queries are not working!" << std::endl;
+    }
+    return isMeasured;
+}
+
+bool runVertexWriterBenchmark(std::ostream& os, int numVertices)
+{
+    enum class Target { AddData, ArenaWriter, MappedWriter };
+    const struct
+    {
+        Target target;
+        bool isBulk;
+        const char* name;
+    } paths[] = {
+        { Target::AddData, false, "arena_add_data" },
+        { Target::ArenaWriter, false, "arena_writer" },
+        { Target::ArenaWriter, true, "arena_append_n" },
+        { Target::MappedWriter, false, "mapped_writer" },
+        { Target::MappedWriter, true, "mapped_append_n" }
+    };
+
+    const auto count = static_cast<size_t>(numVertices);
+    const auto bufferBytes = static_cast<double>(sizeof(BenchVertex) * count);
+    os << "==== Vertex writer benchmark: " << numVertices << " vertices of " << sizeof(BenchVertex) << " bytes, "
+        << VERTEX_WRITER_SAMPLES << " samples per path ====" << std::endl;
+
+    auto isMeasured = true;
+    for (const auto& path : paths)
+    {
+        // One VBO per path - in-memory paths reuse its buffer after the first sample, mapped ones orphan the storage
+        VertexBufferObject vbo;
+        vbo.createVBO(path.target == Target::MappedWriter ? 0 : sizeof(BenchVertex) * count);
+        vbo.bindVBO();
+
+        std::vector<double> sampleMs;
+        for (auto sample = 0; sample < VERTEX_WRITER_SAMPLES; sample++)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            VertexWriter<BenchVertex> writer;
+            if (path.target == Target::AddData)
+            {
+                for (size_t i = 0; i < count; i++) {
+                    vbo.addData(makeBenchVertex(static_cast<int>(i)));
+                }
+            }
+            else
+            {
+                writer = path.target == Target::ArenaWriter ? vbo.appendWriter<BenchVertex>(count)
+                    : vbo.mapNewBufferWriter<BenchVertex>(count, GL_STATIC_DRAW);
+                if (path.isBulk) {
+                    writer.appendN(makeBenchVertex(0), count);
+                }
+                else
+                {
+                    for (size_t i = 0; i < count; i++) {
+                        writer.append(makeBenchVertex(static_cast<int>(i)));
+                    }
+                }
+            }
+
+            if (path.target == Target::MappedWriter) {
+                vbo.unmapBuffer();
+            }
+            else {
+                vbo.uploadDataToGPU(GL_STATIC_DRAW);
+            }
+            glFinish();
+            sampleMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+            if (path.target != Target::AddData && !writer.isFull()) {
+                isMeasured = false;
+            }
+        }
+        vbo.deleteVBO();
+
+        std::sort(sampleMs.begin(), sampleMs.end());
+        const auto medianMs = sampleMs[sampleMs.size() / 2];
+        if (medianMs <= 0.0) {
+            isMeasured = false;
+        }
+
+        os << std::fixed << std::setprecision(3);
+        os << "BENCH vertex_writer=" << path.name << " buffer_mb=" << bufferBytes / (1024.0 * 1024.0) << " median_ms=" << medianMs
+            << " gb_per_s=" << (medianMs > 0.0 ? bufferBytes / (medianMs * 1.0e6) : 0.0) << std::endl;
+        os << std::defaultfloat;
+    }
+
+    if (!isMeasured) {
+        std::cerr << "Vertex writer benchmark could not fill every buffer!" << std::endl;
+    }
+    return isMeasured;
+}
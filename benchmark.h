@@ -0,0 +1,129 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code drives the scene without a user for --bench runs: scripted camera path, offscreen target and the final report
+
+#pragma once
+#include <ostream>
+#include <vector>
+
+// GLAD
+#include <glad/glad.h>
+
+// GLM
+#include <glm/glm.hpp>
+
+/**
+ * Settings of a benchmark run.
+ */
+struct BenchmarkOptions
+{
+    int numFrames = 600; // Frames rendered before the program exits
+    int width = 1280; // Size of the offscreen target
+    int height = 720;
+    float frameTime = 1.0f / 60.0f; // Simulated time step, so animations do not depend on how fast frames are
+};
+
+/**
+ * Closed Catmull-Rom spline through camera positions, the camera looks at a fixed target while flying.
+ * The same parameter always gives the same camera, so runs are comparable.
+ */
+class CameraPath
+{
+public:
+    /**
+     * @param keyPositions  Positions the path passes through (at least 4), the last one connects back to the first
+     * @param target        Point the camera keeps looking at
+     */
+    CameraPath(const std::vector<glm::vec3>& keyPositions, const glm::vec3& target);
+
+    /**
+     * Creates path circling around the desk scene.
+     */
+    static CameraPath makeScenePath();
+
+    /**
+     * Gets camera position at given point of the path.
+     *
+     * @param t  Path parameter, 0 is the first key position and 1 brings the camera back there
+     */
+    glm::vec3 getPosition(float t) const;
+
+    /**
+     * Gets point the camera looks at.
+     */
+    const glm::vec3& getTarget() const;
+
+private:
+    std::vector<glm::vec3> keyPositions_;
+    glm::vec3 target_;
+};
+
+/**
+ * Framebuffer with color and depth renderbuffers, the scene is rendered here instead of the (hidden) window.
+ */
+class OffscreenTarget
+{
+public:
+    OffscreenTarget() = default;
+    OffscreenTarget(const OffscreenTarget&) = delete;
+    OffscreenTarget& operator=(const OffscreenTarget&) = delete;
+    ~OffscreenTarget();
+
+    /**
+     * Creates the framebuffer.
+     *
+     * @return True, if the framebuffer is complete and can be rendered to.
+     */
+    bool create(int width, int height);
+
+    /**
+     * Binds the framebuffer and sets viewport to its size.
+     */
+    void bind() const;
+
+    int getWidth() const;
+    int getHeight() const;
+
+    /**
+     * Deletes the framebuffer and its renderbuffers.
+     */
+    void deleteTarget();
+
+private:
+    GLuint framebufferID_{ 0 };
+    GLuint renderbufferIDs_[2] = { 0, 0 }; // Color and depth
+    int width_{ 0 };
+    int height_{ 0 };
+};
+
+/**
+ * Prints result of a benchmark run - frame time percentiles, draw calls and triangles per frame.
+ * Lines starting with "BENCH" are meant to be picked up by scripts.
+ */
+void printBenchmarkReport(std::ostream& os, const BenchmarkOptions& options);
+
+/**
+ * Compares vertex fetch throughput of all vertex layouts. Draws a cylinder with many slices in every layout
+ * with rasterizer discard on, so the GPU time covers only vertex fetch and the vertex shader.
+ * Prints one "BENCH vertex_layout" line per layout.
+ *
+ * @param os         Stream the results are printed to
+ * @param numSlices  Number of cylinder slices, vertex count is about four times that
+ *
+ * @return True, if every layout was measured.
+ */
+bool runVertexLayoutBenchmark(std::ostream& os, int numSlices);
+
+/**
+ * Compares ways of filling a vertex buffer: per vertex addData into the in-memory buffer, VertexWriter over the
+ * in-memory buffer and VertexWriter over the mapped GPU buffer, each writing one vertex at a time and with appendN.
+ * Timed on the CPU up to glFinish, so the staging copy of the in-memory paths counts too.
+ * Prints one "BENCH vertex_writer" line per path.
+ *
+ * @param os           Stream the results are printed to
+ * @param numVertices  Number of 32-byte vertices written per sample
+ *
+ * @return True, if every path was measured.
+ */
+bool runVertexWriterBenchmark(std::ostream& os, int numVertices);
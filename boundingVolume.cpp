@@ -0,0 +1,109 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code holds the bounding box and bounding sphere of a mesh and moves them into world space
+
+#include <algorithm>
+#include <cmath>
+
+// Project
+#include "boundingVolume.h"
+
+bool BoundingBox::isEmpty() const
+{
+    return min.x > max.x || min.y > max.y || min.z > max.z;
+}
+
+void BoundingBox::expand(const glm::vec3& point)
+{
+    min = glm::min(min, point);
+    max = glm::max(max, point);
+}
+
+glm::vec3 BoundingBox::getCenter() const
+{
+    return (min + max) * 0.5f;
+}
+
+glm::vec3 BoundingBox::getExtent() const
+{
+    return (max - min) * 0.5f;
+}
+
+BoundingBox BoundingBox::transformed(const glm::mat4& matrix) const
+{
+    if (isEmpty()) {
+        return *this;
+    }
+
+    // Center moves with the matrix, extent along each world axis is the sum of absolute contributions
+    // of the local axes (Arvo), so only one point is transformed instead of eight corners
+    const auto center = glm::vec3(matrix * glm::vec4(getCenter(), 1.0f));
+    const auto extent = getExtent();
+    glm::vec3 worldExtent(0.0f);
+    for (auto axis = 0; axis < 3; axis++) {
+        worldExtent += glm::abs(glm::vec3(matrix[axis])) * extent[axis];
+    }
+
+    BoundingBox box;
+    box.min = center - worldExtent;
+    box.max = center + worldExtent;
+    return box;
+}
+
+BoundingSphere BoundingSphere::transformed(const glm::mat4& matrix) const
+{
+    const auto maxScale = std::sqrt(std::max({ glm::dot(glm::vec3(matrix[0]), glm::vec3(matrix[0])),
+        glm::dot(glm::vec3(matrix[1]), glm::vec3(matrix[1])), glm::dot(glm::vec3(matrix[2]), glm::vec3(matrix[2])) }));
+
+    BoundingSphere sphere;
+    sphere.center = glm::vec3(matrix * glm::vec4(center, 1.0f));
+    sphere.radius = radius * maxScale;
+    return sphere;
+}
+
+Bounds Bounds::fromPositions(const glm::vec3* positions, size_t count, size_t strideBytes)
+{
+    const auto position = [positions, strideBytes](size_t i) {
+        return *reinterpret_cast<const glm::vec3*>(reinterpret_cast<const unsigned char*>(positions) + strideBytes * i);
+    };
+
+    Bounds bounds;
+    for (size_t i = 0; i < count; i++) {
+        bounds.box.expand(position(i));
+    }
+    if (count == 0) {
+        return bounds;
+    }
+
+    // Second pass for the radius, it is tighter than half of the box diagonal for anything rounded
+    bounds.sphere.center = bounds.box.getCenter();
+    auto radiusSquared = 0.0f;
+    for (size_t i = 0; i < count; i++)
+    {
+        const auto offset = position(i) - bounds.sphere.center;
+        radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+    }
+    bounds.sphere.radius = std::sqrt(radiusSquared);
+    return bounds;
+}
+
+Bounds Bounds::fromBox(const BoundingBox& box)
+{
+    Bounds bounds;
+    bounds.box = box;
+    if (!box.isEmpty())
+    {
+        bounds.sphere.center = box.getCenter();
+        bounds.sphere.radius = glm::length(box.getExtent());
+    }
+    return bounds;
+}
+
+Bounds Bounds::transformed(const glm::mat4& matrix) const
+{
+    Bounds bounds;
+    bounds.box = box.transformed(matrix);
+    bounds.sphere = sphere.transformed(matrix);
+    return bounds;
+}
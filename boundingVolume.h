@@ -0,0 +1,73 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code holds the bounding box and bounding sphere of a mesh and moves them into world space
+
+#pragma once
+#include <cfloat>
+#include <cstddef>
+
+// GLM
+#include <glm/glm.hpp>
+
+/**
+ * Axis aligned bounding box. A default constructed box is empty (min above max), expanding it by
+ * a point makes it the box of that point.
+ */
+struct BoundingBox
+{
+    glm::vec3 min = glm::vec3(FLT_MAX);
+    glm::vec3 max = glm::vec3(-FLT_MAX);
+
+    bool isEmpty() const;
+    void expand(const glm::vec3& point);
+    glm::vec3 getCenter() const;
+    glm::vec3 getExtent() const; // Half size along each axis
+
+    /**
+     * Gets box containing this box transformed by a matrix. The matrix must be affine (a model matrix,
+     * no projection).
+     */
+    BoundingBox transformed(const glm::mat4& matrix) const;
+};
+
+/**
+ * Bounding sphere.
+ */
+struct BoundingSphere
+{
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+
+    /**
+     * Gets sphere containing this sphere transformed by a matrix (same rules as for the box), radius
+     * grows by the largest scale of the matrix.
+     */
+    BoundingSphere transformed(const glm::mat4& matrix) const;
+};
+
+/**
+ * Box and sphere of the same object. Culling tests both and keeps the tighter answer - the box fits
+ * long thin meshes (cylinder legs, planes), the sphere fits round ones.
+ */
+struct Bounds
+{
+    BoundingBox box;
+    BoundingSphere sphere;
+
+    /**
+     * Gets bounds of positions. Sphere is centered in the box, with radius reaching the farthest position.
+     *
+     * @param positions    First position
+     * @param count        Number of positions
+     * @param strideBytes  Byte distance between two positions (sizeof(glm::vec3) when tightly packed)
+     */
+    static Bounds fromPositions(const glm::vec3* positions, size_t count, size_t strideBytes = sizeof(glm::vec3));
+
+    /**
+     * Gets bounds of a box, sphere is the one around the box corners.
+     */
+    static Bounds fromBox(const BoundingBox& box);
+
+    Bounds transformed(const glm::mat4& matrix) const;
+};
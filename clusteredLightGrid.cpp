@@ -0,0 +1,388 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code bins point lights into a 3D grid of view frustum clusters so each fragment only shades the lights near it
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+// Project
+#include "clusteredLightGrid.h"
+#include "glStateCache.h"
+#include "gpuResourceTracker.h"
+#include "jobSystem.h"
+
+namespace {
+
+    // Light contribution below this fraction of its brightest color channel is dropped,
+    // CalcPointLight in the fragment shader fades the light out smoothly towards the radius
+    const float LIGHT_CUTOFF = 1.0f / 64.0f;
+
+    // Radius used for lights that do not attenuate at all
+    const float UNBOUNDED_LIGHT_RADIUS = 1.0e4f;
+
+    const GLuint MAX_WORKER_THREADS = 8;
+
+    enum TextureBuffer
+    {
+        LIGHT_DATA = 0,
+        CLUSTER_GRID,
+        LIGHT_INDICES
+    };
+
+    const GLenum TEXTURE_BUFFER_FORMATS[] = { GL_RGBA32F, GL_RG32UI, GL_R32UI };
+    const GLint TEXTURE_BUFFER_UNITS[] = {
+        ClusteredLightGrid::LIGHT_DATA_TEXTURE_UNIT,
+        ClusteredLightGrid::CLUSTER_GRID_TEXTURE_UNIT,
+        ClusteredLightGrid::LIGHT_INDICES_TEXTURE_UNIT
+    };
+
+    bool sphereIntersectsAabb(const glm::vec3& center, float radius, const glm::vec3& aabbMin, const glm::vec3& aabbMax)
+    {
+        const auto closestPoint = glm::clamp(center, aabbMin, aabbMax);
+        const auto offset = center - closestPoint;
+        return glm::dot(offset, offset) <= radius * radius;
+    }
+
+    int ndcToTile(float ndc, GLuint numTiles)
+    {
+        const auto tile = static_cast<int>(std::floor((ndc * 0.5f + 0.5f) * numTiles));
+        return std::min(std::max(tile, 0), static_cast<int>(numTiles) - 1);
+    }
+
+} // namespace
+
+const GLuint ClusteredLightGrid::GRID_SIZE_X;
+const GLuint ClusteredLightGrid::GRID_SIZE_Y;
+const GLuint ClusteredLightGrid::GRID_SIZE_Z;
+const GLuint ClusteredLightGrid::NUM_CLUSTERS;
+const GLint ClusteredLightGrid::LIGHT_DATA_TEXTURE_UNIT;
+const GLint ClusteredLightGrid::CLUSTER_GRID_TEXTURE_UNIT;
+const GLint ClusteredLightGrid::LIGHT_INDICES_TEXTURE_UNIT;
+
+ClusteredLightGrid::~ClusteredLightGrid()
+{
+    deleteGrid();
+}
+
+void ClusteredLightGrid::createGrid(float zNear, float zFar)
+{
+    if (bufferIDs_[0] != 0)
+    {
+        std::cerr << "This light grid is already created! You need to delete it before re-creating it!" << std::endl;
+        return;
+    }
+
+    zNear_ = zNear;
+    zFar_ = zFar;
+    boundsProjection_ = glm::mat4(0.0f);
+    clusterMin_.resize(NUM_CLUSTERS);
+    clusterMax_.resize(NUM_CLUSTERS);
+    grid_.resize(NUM_CLUSTERS);
+
+    GpuResourceTracker::genBuffers(3, bufferIDs_);
+    GpuResourceTracker::genTextures(3, textureIDs_);
+    for (auto i = 0; i < 3; i++)
+    {
+        uploadTextureBuffer(bufferIDs_[i], nullptr, 0);
+        GLStateCache::bindTexture(GL_TEXTURE_BUFFER, textureIDs_[i]);
+        glTexBuffer(GL_TEXTURE_BUFFER, TEXTURE_BUFFER_FORMATS[i], bufferIDs_[i]);
+    }
+    GLStateCache::bindTexture(GL_TEXTURE_BUFFER, 0);
+
+    clustersUBO_.createUBO(sizeof(ClustersBlock), CLUSTERS_BLOCK_BINDING);
+
+    // Every worker takes a contiguous range of depth slices, so their clusters never overlap
+    // (one range per job system thread plus the main thread, which helps while waiting)
+    const auto jobThreads = static_cast<GLuint>(JobSystem::getNumWorkers()) + 1;
+    const auto numWorkers = std::min(std::min(jobThreads, MAX_WORKER_THREADS), GRID_SIZE_Z);
+    workers_.resize(numWorkers);
+    for (GLuint i = 0; i < numWorkers; i++)
+    {
+        workers_[i].firstSlice = GRID_SIZE_Z * i / numWorkers;
+        workers_[i].lastSlice = GRID_SIZE_Z * (i + 1) / numWorkers;
+    }
+}
+
+void ClusteredLightGrid::update(const std::vector<PointLightBlock>& lights, const glm::mat4& view, const glm::mat4& projection, int screenWidth, int screenHeight)
+{
+    if (bufferIDs_[0] == 0)
+    {
+        std::cerr << "Light grid has not been created yet!" << std::endl;
+        return;
+    }
+
+    const auto startTime = std::chrono::steady_clock::now();
+
+    // Cluster bounds depend only on projection, which changes just when zooming
+    if (projection != boundsProjection_) {
+        computeClusterBounds(projection);
+    }
+    computeLightBounds(lights, view, projection);
+
+    // Slice ranges go to the job system instead of threads spawned every frame
+    JobSystem::parallelFor(workers_.size(), 1, [this](size_t first, size_t last) {
+        for (auto i = first; i < last; i++) {
+            binSlices(workers_[i]);
+        }
+    });
+
+    // Workers wrote offsets relative to their own lists, concatenate the lists in slice order
+    lightIndices_.clear();
+    for (const auto& worker : workers_)
+    {
+        const auto baseOffset = static_cast<GLuint>(lightIndices_.size());
+        const auto firstCluster = worker.firstSlice * GRID_SIZE_X * GRID_SIZE_Y;
+        const auto lastCluster = worker.lastSlice * GRID_SIZE_X * GRID_SIZE_Y;
+        for (auto cluster = firstCluster; cluster < lastCluster; cluster++) {
+            grid_[cluster].x += baseOffset;
+        }
+        lightIndices_.insert(lightIndices_.end(), worker.lightIndices.begin(), worker.lightIndices.end());
+    }
+
+    stats_.numLights = static_cast<GLuint>(lights.size());
+    stats_.numLightIndices = static_cast<GLuint>(lightIndices_.size());
+    stats_.numActiveClusters = 0;
+    stats_.maxLightsPerCluster = 0;
+    for (const auto& cluster : grid_)
+    {
+        if (cluster.y > 0) {
+            stats_.numActiveClusters++;
+        }
+        stats_.maxLightsPerCluster = std::max(stats_.maxLightsPerCluster, cluster.y);
+    }
+
+    uploadTextureBuffer(bufferIDs_[LIGHT_DATA], lights.data(), sizeof(PointLightBlock) * lights.size());
+    uploadTextureBuffer(bufferIDs_[CLUSTER_GRID], grid_.data(), sizeof(glm::uvec2) * grid_.size());
+    uploadTextureBuffer(bufferIDs_[LIGHT_INDICES], lightIndices_.data(), sizeof(GLuint) * lightIndices_.size());
+
+    const auto logDepthRange = std::log(zFar_ / zNear_);
+    clustersBlock_.gridSize = glm::uvec4(GRID_SIZE_X, GRID_SIZE_Y, GRID_SIZE_Z, 0);
+    clustersBlock_.depthParams = glm::vec4(zNear_, zFar_, GRID_SIZE_Z / logDepthRange, GRID_SIZE_Z * std::log(zNear_) / logDepthRange);
+    clustersBlock_.screenSize = glm::vec2(static_cast<float>(screenWidth), static_cast<float>(screenHeight));
+    clustersUBO_.update(&clustersBlock_, sizeof(ClustersBlock));
+
+    const auto endTime = std::chrono::steady_clock::now();
+    stats_.binningMs = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+}
+
+void ClusteredLightGrid::bindTextures() const
+{
+    for (auto i = 0; i < 3; i++)
+    {
+        GLStateCache::bindTextureUnit(TEXTURE_BUFFER_UNITS[i], GL_TEXTURE_BUFFER, textureIDs_[i]);
+    }
+    GLStateCache::activeTexture(GL_TEXTURE0);
+}
+
+const ClusterStats& ClusteredLightGrid::getStats() const
+{
+    return stats_;
+}
+
+void ClusteredLightGrid::deleteGrid()
+{
+    if (bufferIDs_[0] == 0) {
+        return;
+    }
+
+    GpuResourceTracker::deleteTextures(3, textureIDs_);
+    GpuResourceTracker::deleteBuffers(3, bufferIDs_);
+    for (auto i = 0; i < 3; i++)
+    {
+        textureIDs_[i] = 0;
+        bufferIDs_[i] = 0;
+    }
+    clustersUBO_.deleteUBO();
+}
+
+float ClusteredLightGrid::computeLightRadius(const PointLightBlock& light)
+{
+    const auto brightest = glm::max(glm::max(glm::abs(light.ambient), glm::abs(light.diffuse)), glm::abs(light.specular));
+    const auto maxChannel = std::max(std::max(brightest.r, brightest.g), brightest.b);
+
+    // Solve maxChannel / (constant + linear * d + quadratic * d^2) = LIGHT_CUTOFF for d
+    const auto c = light.constant - maxChannel / LIGHT_CUTOFF;
+    if (c >= 0.0f) {
+        return 0.0f;
+    }
+    if (light.quadratic > 0.0f) {
+        return (-light.linear + std::sqrt(light.linear * light.linear - 4.0f * light.quadratic * c)) / (2.0f * light.quadratic);
+    }
+    if (light.linear > 0.0f) {
+        return -c / light.linear;
+    }
+
+    return UNBOUNDED_LIGHT_RADIUS;
+}
+
+void ClusteredLightGrid::computeClusterBounds(const glm::mat4& projection)
+{
+    const auto inverseProjection = glm::inverse(projection);
+
+    // Directions towards the corners of every tile, scaled so that they reach depth 1
+    std::vector<glm::vec3> cornerDirections((GRID_SIZE_X + 1) * (GRID_SIZE_Y + 1));
+    for (GLuint y = 0; y <= GRID_SIZE_Y; y++)
+    {
+        for (GLuint x = 0; x <= GRID_SIZE_X; x++)
+        {
+            const auto ndcX = -1.0f + 2.0f * x / GRID_SIZE_X;
+            const auto ndcY = -1.0f + 2.0f * y / GRID_SIZE_Y;
+            const auto nearPoint = inverseProjection * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+            const auto viewPoint = glm::vec3(nearPoint) / nearPoint.w;
+            cornerDirections[y * (GRID_SIZE_X + 1) + x] = viewPoint / -viewPoint.z;
+        }
+    }
+
+    for (GLuint slice = 0; slice < GRID_SIZE_Z; slice++)
+    {
+        const auto sliceNear = zNear_ * std::pow(zFar_ / zNear_, static_cast<float>(slice) / GRID_SIZE_Z);
+        const auto sliceFar = zNear_ * std::pow(zFar_ / zNear_, static_cast<float>(slice + 1) / GRID_SIZE_Z);
+        for (GLuint y = 0; y < GRID_SIZE_Y; y++)
+        {
+            for (GLuint x = 0; x < GRID_SIZE_X; x++)
+            {
+                auto aabbMin = glm::vec3(std::numeric_limits<float>::max());
+                auto aabbMax = glm::vec3(-std::numeric_limits<float>::max());
+                for (GLuint corner = 0; corner < 4; corner++)
+                {
+                    const auto& direction = cornerDirections[(y + corner / 2) * (GRID_SIZE_X + 1) + x + corner % 2];
+                    aabbMin = glm::min(aabbMin, glm::min(direction * sliceNear, direction * sliceFar));
+                    aabbMax = glm::max(aabbMax, glm::max(direction * sliceNear, direction * sliceFar));
+                }
+
+                const auto cluster = x + y * GRID_SIZE_X + slice * GRID_SIZE_X * GRID_SIZE_Y;
+                clusterMin_[cluster] = aabbMin;
+                clusterMax_[cluster] = aabbMax;
+            }
+        }
+    }
+
+    boundsProjection_ = projection;
+}
+
+void ClusteredLightGrid::computeLightBounds(const std::vector<PointLightBlock>& lights, const glm::mat4& view, const glm::mat4& projection)
+{
+    lightBounds_.resize(lights.size());
+    for (size_t i = 0; i < lights.size(); i++)
+    {
+        auto& bounds = lightBounds_[i];
+        bounds.viewPosition = glm::vec3(view * glm::vec4(lights[i].position, 1.0f));
+        bounds.radius = lights[i].radius;
+
+        // Empty range unless the light reaches the frustum
+        bounds.minSlice = 1;
+        bounds.maxSlice = 0;
+
+        const auto depth = -bounds.viewPosition.z;
+        if (depth + bounds.radius < zNear_ || depth - bounds.radius > zFar_) {
+            continue;
+        }
+
+        // Light sphere crossing the near plane can cover any tile
+        auto minNdc = glm::vec2(-1.0f);
+        auto maxNdc = glm::vec2(1.0f);
+        if (depth - bounds.radius > zNear_)
+        {
+            // Project corners of the box around the sphere, it lies fully in front of the camera
+            minNdc = glm::vec2(std::numeric_limits<float>::max());
+            maxNdc = glm::vec2(-std::numeric_limits<float>::max());
+            for (auto corner = 0; corner < 8; corner++)
+            {
+                const auto offset = glm::vec3(corner & 1 ? 1.0f : -1.0f, corner & 2 ? 1.0f : -1.0f, corner & 4 ? 1.0f : -1.0f);
+                const auto clipPosition = projection * glm::vec4(bounds.viewPosition + offset * bounds.radius, 1.0f);
+                const auto ndcPosition = glm::vec2(clipPosition) / clipPosition.w;
+                minNdc = glm::min(minNdc, ndcPosition);
+                maxNdc = glm::max(maxNdc, ndcPosition);
+            }
+
+            if (minNdc.x > 1.0f || minNdc.y > 1.0f || maxNdc.x < -1.0f || maxNdc.y < -1.0f) {
+                continue;
+            }
+        }
+
+        bounds.minSlice = getSlice(std::max(depth - bounds.radius, zNear_));
+        bounds.maxSlice = getSlice(std::min(depth + bounds.radius, zFar_));
+        bounds.minTileX = ndcToTile(minNdc.x, GRID_SIZE_X);
+        bounds.maxTileX = ndcToTile(maxNdc.x, GRID_SIZE_X);
+        bounds.minTileY = ndcToTile(minNdc.y, GRID_SIZE_Y);
+        bounds.maxTileY = ndcToTile(maxNdc.y, GRID_SIZE_Y);
+    }
+}
+
+void ClusteredLightGrid::binSlices(WorkerOutput& output)
+{
+    const auto clustersPerSlice = GRID_SIZE_X * GRID_SIZE_Y;
+    const auto firstCluster = output.firstSlice * clustersPerSlice;
+    const auto lastCluster = output.lastSlice * clustersPerSlice;
+
+    // Gather (cluster, light) pairs, lights are visited in order so every cluster list ends up sorted
+    output.pairClusters.clear();
+    output.pairLights.clear();
+    for (size_t light = 0; light < lightBounds_.size(); light++)
+    {
+        const auto& bounds = lightBounds_[light];
+        const auto minSlice = std::max(bounds.minSlice, static_cast<int>(output.firstSlice));
+        const auto maxSlice = std::min(bounds.maxSlice, static_cast<int>(output.lastSlice) - 1);
+        for (auto slice = minSlice; slice <= maxSlice; slice++)
+        {
+            for (auto y = bounds.minTileY; y <= bounds.maxTileY; y++)
+            {
+                for (auto x = bounds.minTileX; x <= bounds.maxTileX; x++)
+                {
+                    const auto cluster = x + y * GRID_SIZE_X + slice * clustersPerSlice;
+                    if (sphereIntersectsAabb(bounds.viewPosition, bounds.radius, clusterMin_[cluster], clusterMax_[cluster]))
+                    {
+                        output.pairClusters.push_back(cluster);
+                        output.pairLights.push_back(static_cast<GLuint>(light));
+                    }
+                }
+            }
+        }
+    }
+
+    // Counting sort of the pairs by cluster, grid entries of our slices become (offset, count)
+    for (auto cluster = firstCluster; cluster < lastCluster; cluster++) {
+        grid_[cluster] = glm::uvec2(0, 0);
+    }
+    for (const auto cluster : output.pairClusters) {
+        grid_[cluster].y++;
+    }
+
+    GLuint offset = 0;
+    for (auto cluster = firstCluster; cluster < lastCluster; cluster++)
+    {
+        grid_[cluster].x = offset;
+        offset += grid_[cluster].y;
+        grid_[cluster].y = 0;
+    }
+
+    output.lightIndices.resize(output.pairClusters.size());
+    for (size_t i = 0; i < output.pairClusters.size(); i++)
+    {
+        auto& cluster = grid_[output.pairClusters[i]];
+        output.lightIndices[cluster.x + cluster.y] = output.pairLights[i];
+        cluster.y++;
+    }
+}
+
+int ClusteredLightGrid::getSlice(float depth) const
+{
+    const auto slice = static_cast<int>(std::floor(std::log(depth / zNear_) / std::log(zFar_ / zNear_) * GRID_SIZE_Z));
+    return std::min(std::max(slice, 0), static_cast<int>(GRID_SIZE_Z) - 1);
+}
+
+void ClusteredLightGrid::uploadTextureBuffer(GLuint bufferID, const void* ptrData, GLsizeiptr dataSizeBytes)
+{
+    // Orphan the old storage so the driver does not wait for the previous frame to stop reading it,
+    // buffer textures must not be empty, so at least one texel is always allocated
+    glBindBuffer(GL_TEXTURE_BUFFER, bufferID);
+    glBufferData(GL_TEXTURE_BUFFER, std::max(dataSizeBytes, static_cast<GLsizeiptr>(sizeof(glm::vec4))), nullptr, GL_STREAM_DRAW);
+    if (dataSizeBytes > 0) {
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, dataSizeBytes, ptrData);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
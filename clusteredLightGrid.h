@@ -0,0 +1,148 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code bins point lights into a 3D grid of view frustum clusters so each fragment only shades the lights near it
+
+#pragma once
+#include <vector>
+
+// GLAD
+#include <glad/glad.h>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Project
+#include "uniformBlocks.h"
+
+/**
+ * Statistics of the last light binning.
+ */
+struct ClusterStats
+{
+    GLuint numLights = 0; // Point lights given to the grid
+    GLuint numLightIndices = 0; // Sum of light counts of all clusters
+    GLuint numActiveClusters = 0; // Clusters with at least one light
+    GLuint maxLightsPerCluster = 0; // Light count of the busiest cluster
+    double binningMs = 0.0; // CPU time spent binning and uploading, in milliseconds
+};
+
+/**
+ * Clustered forward lighting. The view frustum is divided into GRID_SIZE_X * GRID_SIZE_Y screen tiles
+ * and GRID_SIZE_Z exponential depth slices. Every frame the point lights are binned into the clusters
+ * on the CPU (depth slices are split between job system threads) and three texture buffers are uploaded:
+ *   - light data (RGBA32F, four texels per light, see PointLightBlock)
+ *   - cluster grid (RG32UI, offset and count into the index list per cluster)
+ *   - light index list (R32UI)
+ * Fragment shader looks up its cluster and loops only over the lights listed there.
+ */
+class ClusteredLightGrid
+{
+public:
+    static const GLuint GRID_SIZE_X = 16;
+    static const GLuint GRID_SIZE_Y = 9;
+    static const GLuint GRID_SIZE_Z = 24;
+    static const GLuint NUM_CLUSTERS = GRID_SIZE_X * GRID_SIZE_Y * GRID_SIZE_Z;
+
+    // Texture units of the texture buffers, chosen above the units used by material textures
+    static const GLint LIGHT_DATA_TEXTURE_UNIT = 8;
+    static const GLint CLUSTER_GRID_TEXTURE_UNIT = 9;
+    static const GLint LIGHT_INDICES_TEXTURE_UNIT = 10;
+
+    ClusteredLightGrid() = default;
+    ClusteredLightGrid(const ClusteredLightGrid&) = delete;
+    ClusteredLightGrid& operator=(const ClusteredLightGrid&) = delete;
+    ~ClusteredLightGrid();
+
+    /**
+     * Creates texture buffers and the Clusters uniform buffer. Must be called once before update.
+     *
+     * @param zNear  Near plane distance of the projection used for rendering
+     * @param zFar   Far plane distance of the projection used for rendering
+     */
+    void createGrid(float zNear, float zFar);
+
+    /**
+     * Bins given lights into clusters and uploads the results to the GPU.
+     *
+     * @param lights        Point lights in world space, radius of each light must be set
+     * @param view          View matrix of the frame
+     * @param projection    Projection matrix of the frame (near / far planes must match createGrid)
+     * @param screenWidth   Viewport width in pixels
+     * @param screenHeight  Viewport height in pixels
+     */
+    void update(const std::vector<PointLightBlock>& lights, const glm::mat4& view, const glm::mat4& projection, int screenWidth, int screenHeight);
+
+    /**
+     * Binds the texture buffers to their texture units (LIGHT_DATA_TEXTURE_UNIT...).
+     */
+    void bindTextures() const;
+
+    /**
+     * Gets statistics of the last update.
+     */
+    const ClusterStats& getStats() const;
+
+    /**
+     * Deletes all GPU objects of the grid.
+     */
+    void deleteGrid();
+
+    /**
+     * Computes distance, at which light contribution falls below the cutoff, so that it can be binned
+     * into clusters. Brighter lights reach further.
+     *
+     * @param light  Light with attenuation and colors set
+     *
+     * @return Light radius in world units.
+     */
+    static float computeLightRadius(const PointLightBlock& light);
+
+private:
+    /**
+     * Cluster range covered by one light, computed once per frame before workers start.
+     */
+    struct LightBounds
+    {
+        glm::vec3 viewPosition;
+        float radius;
+        int minSlice, maxSlice;
+        int minTileX, maxTileX;
+        int minTileY, maxTileY;
+    };
+
+    /**
+     * Results of one worker thread, kept between frames so that the vectors do not reallocate.
+     */
+    struct WorkerOutput
+    {
+        GLuint firstSlice = 0;
+        GLuint lastSlice = 0; // Exclusive
+        std::vector<GLuint> pairClusters; // Cluster of each (cluster, light) pair found
+        std::vector<GLuint> pairLights; // Light of each (cluster, light) pair found
+        std::vector<GLuint> lightIndices; // Pairs sorted by cluster
+    };
+
+    void computeClusterBounds(const glm::mat4& projection);
+    void computeLightBounds(const std::vector<PointLightBlock>& lights, const glm::mat4& view, const glm::mat4& projection);
+    void binSlices(WorkerOutput& output);
+    int getSlice(float depth) const;
+    static void uploadTextureBuffer(GLuint bufferID, const void* ptrData, GLsizeiptr dataSizeBytes);
+
+    float zNear_{ 0.1f };
+    float zFar_{ 100.0f };
+    glm::mat4 boundsProjection_{ 0.0f }; // Projection the cluster bounds were computed for
+
+    std::vector<glm::vec3> clusterMin_; // View space AABB of every cluster
+    std::vector<glm::vec3> clusterMax_;
+    std::vector<LightBounds> lightBounds_;
+    std::vector<WorkerOutput> workers_;
+    std::vector<glm::uvec2> grid_; // Offset and count of lights per cluster
+    std::vector<GLuint> lightIndices_;
+
+    GLuint bufferIDs_[3] = { 0, 0, 0 }; // Light data, cluster grid and light indices buffers
+    GLuint textureIDs_[3] = { 0, 0, 0 }; // Buffer textures viewing the buffers above
+    UniformBuffer clustersUBO_;
+    ClustersBlock clustersBlock_ = {};
+    ClusterStats stats_;
+};
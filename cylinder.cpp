@@ -11,18 +11,24 @@
 
 // Project
 #include "cylinder.h"
+#include "glStateCache.h"
+#include "gpuResourceTracker.h"
+#include "profiler.h"
 
 
 
 namespace static_meshes_3D {
 
-	Cylinder::Cylinder(float radius, int numSlices, float height, bool withPositions, bool withTextureCoordinates, bool withNormals)
-		: StaticMesh3D(withPositions, withTextureCoordinates, withNormals)
+	Cylinder::Cylinder(float radius, int numSlices, float height, bool withPositions, bool withTextureCoordinates, bool withNormals,
+		VertexLayout vertexLayout, MeshInitialization initialization)
+		: StaticMesh3D(withPositions, withTextureCoordinates, withNormals, vertexLayout)
 		, _radius(radius)
 		, _numSlices(numSlices)
 		, _height(height)
 	{
-		initializeData();
+		if (initialization == MeshInitialization::Immediate) {
+			initializeData();
+		}
 	}
 
 	float Cylinder::getRadius() const
@@ -40,9 +46,14 @@ namespace static_meshes_3D {
 		return _height;
 	}
 
-	void Cylinder::initializeData()
+	int Cylinder::getNumVertices() const
 	{
-		if (_isInitialized) {
+		return _numVerticesTotal;
+	}
+
+	void Cylinder::generateData()
+	{
+		if (_isInitialized || _vertexData != nullptr) {
 			return;
 		}
 
@@ -51,10 +62,6 @@ namespace static_meshes_3D {
 		_numVerticesTopBottom = _numSlices + 2;
 		_numVerticesTotal = _numVerticesSide + _numVerticesTopBottom * 2;
 
-		// Generate VAO and VBO for vertex attributes
-		glGenVertexArrays(1, &_vao);
-		glBindVertexArray(_vao);
-		_vbo.createVBO(getVertexByteSize() * _numVerticesTotal);
 
 		// Pre-calculate sines / cosines for given number of slices
 		const auto sliceAngleStep = 2.0f * glm::pi<float>() / float(_numSlices);
@@ -69,93 +76,58 @@ namespace static_meshes_3D {
 			currentSliceAngle += sliceAngleStep;
 		}
 
-		if (hasPositions())
+		// Every vertex is written once with all its attributes, straight into the chosen vertex layout
+		beginVertices(_numVerticesTotal);
+		const auto halfHeight = _height / 2.0f;
+		auto vertexIndex = 0;
+
+		// Add cylinder side vertices, top and bottom vertex of every slice go one after another for the triangle strip
+		// I have decided to map the texture twice around cylinder, looks fine
+		const auto sliceTextureStepU = 2.0f / float(_numSlices);
+		for (auto i = 0; i <= _numSlices; i++)
 		{
-			// Pre-calculate X and Z coordinates
-			std::vector<float> x;
-			std::vector<float> z;
-			for (auto i = 0; i <= _numSlices; i++)
-			{
-				x.push_back(cosines[i] * _radius);
-				z.push_back(sines[i] * _radius);
-			}
-
-			// Add cylinder side vertices
-			for (auto i = 0; i <= _numSlices; i++)
-			{
-				const auto topPosition = glm::vec3(x[i], _height / 2.0f, z[i]);
-				const auto bottomPosition = glm::vec3(x[i], -_height / 2.0f, z[i]);
-				_vbo.addRawData(&topPosition, sizeof(glm::vec3));
-				_vbo.addRawData(&bottomPosition, sizeof(glm::vec3));
-			}
-
-			// Add top cylinder cover
-			glm::vec3 topCenterPosition(0.0f, _height / 2.0f, 0.0f);
-			_vbo.addRawData(&topCenterPosition, sizeof(glm::vec3));
-			for (auto i = 0; i <= _numSlices; i++)
-			{
-				const auto topPosition = glm::vec3(x[i], _height / 2.0f, z[i]);
-				_vbo.addRawData(&topPosition, sizeof(glm::vec3));
-			}
-
-			// Add bottom cylinder cover
-			glm::vec3 bottomCenterPosition(0.0f, -_height / 2.0f, 0.0f);
-			_vbo.addRawData(&bottomCenterPosition, sizeof(glm::vec3));
-			for (auto i = 0; i <= _numSlices; i++)
-			{
-				const auto bottomPosition = glm::vec3(x[i], -_height / 2.0f, -z[i]);
-				_vbo.addRawData(&bottomPosition, sizeof(glm::vec3));
-			}
+			const auto x = cosines[i] * _radius;
+			const auto z = sines[i] * _radius;
+			const auto texCoordU = sliceTextureStepU * float(i);
+			const auto normal = glm::vec3(cosines[i], 0.0f, sines[i]);
+			writeVertex(vertexIndex++, glm::vec3(x, halfHeight, z), glm::vec2(texCoordU, 1.0f), normal);
+			writeVertex(vertexIndex++, glm::vec3(x, -halfHeight, z), glm::vec2(texCoordU, 0.0f), normal);
 		}
 
-		if (hasTextureCoordinates())
+		// Add top cylinder cover, circle texture coordinates around the center
+		const glm::vec2 topBottomCenterTexCoord(0.5f, 0.5f);
+		const glm::vec3 topNormal(0.0f, 1.0f, 0.0f);
+		writeVertex(vertexIndex++, glm::vec3(0.0f, halfHeight, 0.0f), topBottomCenterTexCoord, topNormal);
+		for (auto i = 0; i <= _numSlices; i++)
 		{
-			// Pre-calculate step size in texture coordinate U
-			// I have decided to map the texture twice around cylinder, looks fine
-			const auto sliceTextureStepU = 2.0f / float(_numSlices);
-
-			auto currentSliceTexCoordU = 0.0f;
-			for (auto i = 0; i <= _numSlices; i++)
-			{
-				_vbo.addData(glm::vec2(currentSliceTexCoordU, 1.0f));
-				_vbo.addData(glm::vec2(currentSliceTexCoordU, 0.0f));
-
-				// Update texture coordinate of current slice 
-				currentSliceTexCoordU += sliceTextureStepU;
-			}
-
-			// Generate circle texture coordinates for cylinder top cover
-			glm::vec2 topBottomCenterTexCoord(0.5f, 0.5f);
-			_vbo.addData(topBottomCenterTexCoord);
-			for (auto i = 0; i <= _numSlices; i++) {
-				_vbo.addData(glm::vec2(topBottomCenterTexCoord.x + sines[i] * 0.5f, topBottomCenterTexCoord.y + cosines[i] * 0.5f));
-			}
-
-			// Generate circle texture coordinates for cylinder bottom cover
-			_vbo.addData(topBottomCenterTexCoord);
-			for (auto i = 0; i <= _numSlices; i++) {
-				_vbo.addData(glm::vec2(topBottomCenterTexCoord.x + sines[i] * 0.5f, topBottomCenterTexCoord.y - cosines[i] * 0.5f));
-			}
+			const auto texCoord = glm::vec2(topBottomCenterTexCoord.x + sines[i] * 0.5f, topBottomCenterTexCoord.y + cosines[i] * 0.5f);
+			writeVertex(vertexIndex++, glm::vec3(cosines[i] * _radius, halfHeight, sines[i] * _radius), texCoord, topNormal);
 		}
 
-		if (hasNormals())
+		// Add bottom cylinder cover, Z is mirrored so that the fan faces down
+		const glm::vec3 bottomNormal(0.0f, -1.0f, 0.0f);
+		writeVertex(vertexIndex++, glm::vec3(0.0f, -halfHeight, 0.0f), topBottomCenterTexCoord, bottomNormal);
+		for (auto i = 0; i <= _numSlices; i++)
 		{
-			for (auto i = 0; i <= _numSlices; i++) {
-				_vbo.addData(glm::vec3(cosines[i], 0.0f, sines[i]), 2);
-			}
+			const auto texCoord = glm::vec2(topBottomCenterTexCoord.x + sines[i] * 0.5f, topBottomCenterTexCoord.y - cosines[i] * 0.5f);
+			writeVertex(vertexIndex++, glm::vec3(cosines[i] * _radius, -halfHeight, -sines[i] * _radius), texCoord, bottomNormal);
+		}
 
-			// Add normal for every vertex of cylinder top cover
-			_vbo.addData(glm::vec3(0.0f, 1.0f, 0.0f), _numVerticesTopBottom);
+	}
 
-			// Add normal for every vertex of cylinder bottom cover
-			_vbo.addData(glm::vec3(0.0f, -1.0f, 0.0f), _numVerticesTopBottom);
+	void Cylinder::uploadData()
+	{
+		if (_isInitialized || _vertexData == nullptr) {
+			return;
 		}
 
-		// Finally upload data to the GPU
-		_vbo.bindVBO();
-		_vbo.uploadDataToGPU(GL_STATIC_DRAW);
+		// Generate VAO and VBO for vertex attributes and finally upload data to the GPU
+		GpuResourceTracker::genVertexArrays(1, &_vao);
+		GLStateCache::bindVertexArray(_vao);
+		uploadVertices();
 		setVertexAttributesPointers(_numVerticesTotal);
 
+		_vertexData = nullptr;
 		_isInitialized = true;
 	}
 
@@ -165,16 +137,47 @@ namespace static_meshes_3D {
 			return;
 		}
 
-		glBindVertexArray(_vao);
+		GLStateCache::bindVertexArray(_vao);
 
 		// Render cylinder side first
 		glDrawArrays(GL_TRIANGLE_STRIP, 0, _numVerticesSide);
+		Profiler::countDraw(GL_TRIANGLE_STRIP, _numVerticesSide);
 
 		// Render top cover
 		glDrawArrays(GL_TRIANGLE_FAN, _numVerticesSide, _numVerticesTopBottom);
+		Profiler::countDraw(GL_TRIANGLE_FAN, _numVerticesTopBottom);
 
 		// Render bottom cover
 		glDrawArrays(GL_TRIANGLE_FAN, _numVerticesSide + _numVerticesTopBottom, _numVerticesTopBottom);
+		Profiler::countDraw(GL_TRIANGLE_FAN, _numVerticesTopBottom);
+	}
+
+	void Cylinder::renderInstancedGeometry(GLsizei numInstances) const
+	{
+		// Same three parts as in render, but each of them drawn for all instances at once
+		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, _numVerticesSide, numInstances);
+		glDrawArraysInstanced(GL_TRIANGLE_FAN, _numVerticesSide, _numVerticesTopBottom, numInstances);
+		glDrawArraysInstanced(GL_TRIANGLE_FAN, _numVerticesSide + _numVerticesTopBottom, _numVerticesTopBottom, numInstances);
+		Profiler::countDraw(GL_TRIANGLE_STRIP, _numVerticesSide, numInstances);
+		Profiler::countDraw(GL_TRIANGLE_FAN, _numVerticesTopBottom, numInstances);
+		Profiler::countDraw(GL_TRIANGLE_FAN, _numVerticesTopBottom, numInstances);
+	}
+
+	void Cylinder::enqueueInstancedGeometry(RenderQueue& queue, DrawPacket& packet, const glm::vec3& position) const
+	{
+		packet.kind = DrawKind::Arrays;
+		packet.mode = GL_TRIANGLE_STRIP;
+		packet.first = 0;
+		packet.count = _numVerticesSide;
+		queue.push(packet, position);
+
+		packet.mode = GL_TRIANGLE_FAN;
+		packet.first = _numVerticesSide;
+		packet.count = _numVerticesTopBottom;
+		queue.push(packet, position);
+
+		packet.first = _numVerticesSide + _numVerticesTopBottom;
+		queue.push(packet, position);
 	}
 
 	void Cylinder::renderPoints() const
@@ -184,7 +187,7 @@ namespace static_meshes_3D {
 		}
 
 		// Just render all points as they are stored in the VBO
-		glBindVertexArray(_vao);
+		GLStateCache::bindVertexArray(_vao);
 		glDrawArrays(GL_POINTS, 0, _numVerticesTotal);
 	}
 
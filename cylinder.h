@@ -15,7 +15,11 @@ namespace static_meshes_3D {
 	{
 	public:
 		Cylinder(float radius, int numSlices, float height,
-			bool withPositions = true, bool withTextureCoordinates = true, bool withNormals = true);
+			bool withPositions = true, bool withTextureCoordinates = true, bool withNormals = true,
+			VertexLayout vertexLayout = VertexLayout::Interleaved, MeshInitialization initialization = MeshInitialization::Immediate);
+
+		void generateData() override;
+		void uploadData() override;
 
 		void render() const override;
 		void renderPoints() const override;
@@ -35,6 +39,11 @@ namespace static_meshes_3D {
 		 */
 		float getHeight() const;
 
+		/**
+		 * Gets number of vertices of all cylinder parts together.
+		 */
+		int getNumVertices() const;
+
 	private:
 		float _radius; // Cylinder radius (distance from the center of cylinder to surface)
 		int _numSlices; // Number of cylinder slices
@@ -44,7 +53,8 @@ namespace static_meshes_3D {
 		int _numVerticesTopBottom; // How many vertices to render top / bottom of the cylinder
 		int _numVerticesTotal; // Just a sum of both numbers above
 
-		void initializeData() override;
+		void renderInstancedGeometry(GLsizei numInstances) const override;
+		void enqueueInstancedGeometry(RenderQueue& queue, DrawPacket& packet, const glm::vec3& position) const override;
 	};
 
 } // namespace static_meshes_3D
@@ -0,0 +1,233 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code tests world bounds of scene objects against the view frustum, several objects at once with SSE / AVX
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FRUSTUM_CULLER_SSE
+#include <emmintrin.h>
+#endif
+
+// x64 configurations of the project build with /arch:AVX2, which defines __AVX__ for MSVC
+#if defined(__AVX__)
+#define FRUSTUM_CULLER_AVX
+#include <immintrin.h>
+#endif
+
+// Project
+#include "frustumCuller.h"
+#include "profiler.h"
+
+namespace {
+
+    const int NUM_PLANES = 6;
+
+    /**
+     * Distance of the sphere center from a plane, minus how far the object reaches towards the outside -
+     * the smaller of the sphere radius and the box extent projected on the plane normal.
+     * Negative means the object is completely on the outer side.
+     */
+    float getInnerDistance(const glm::vec4& plane, const glm::vec3& boxCenter, const glm::vec3& boxExtent,
+        const glm::vec3& sphereCenter, float sphereRadius)
+    {
+        const auto normal = glm::vec3(plane);
+        const auto boxReach = glm::dot(glm::abs(normal), boxExtent);
+        const auto boxDistance = glm::dot(normal, boxCenter) + plane.w + boxReach;
+        const auto sphereDistance = glm::dot(normal, sphereCenter) + plane.w + sphereRadius;
+        return std::min(boxDistance, sphereDistance);
+    }
+
+} // namespace
+
+size_t CullList::add(const Bounds& worldBounds)
+{
+    const auto index = size();
+    for (auto* component : { &boxCenterX_, &boxCenterY_, &boxCenterZ_, &boxExtentX_, &boxExtentY_, &boxExtentZ_,
+        &sphereX_, &sphereY_, &sphereZ_, &sphereRadius_ }) {
+        component->push_back(0.0f);
+    }
+
+    set(index, worldBounds);
+    return index;
+}
+
+void CullList::set(size_t index, const Bounds& worldBounds)
+{
+    const auto center = worldBounds.box.getCenter();
+    const auto extent = worldBounds.box.getExtent();
+    boxCenterX_[index] = center.x;
+    boxCenterY_[index] = center.y;
+    boxCenterZ_[index] = center.z;
+    boxExtentX_[index] = extent.x;
+    boxExtentY_[index] = extent.y;
+    boxExtentZ_[index] = extent.z;
+    sphereX_[index] = worldBounds.sphere.center.x;
+    sphereY_[index] = worldBounds.sphere.center.y;
+    sphereZ_[index] = worldBounds.sphere.center.z;
+    sphereRadius_[index] = worldBounds.sphere.radius;
+}
+
+void CullList::clear()
+{
+    for (auto* component : { &boxCenterX_, &boxCenterY_, &boxCenterZ_, &boxExtentX_, &boxExtentY_, &boxExtentZ_,
+        &sphereX_, &sphereY_, &sphereZ_, &sphereRadius_ }) {
+        component->clear();
+    }
+}
+
+size_t CullList::size() const
+{
+    return boxCenterX_.size();
+}
+
+void FrustumCuller::setViewProjection(const glm::mat4& viewProjection)
+{
+    // Rows of the matrix combined give the planes in world space: left, right, bottom, top, near, far
+    const auto matrix = glm::transpose(viewProjection);
+    planes_[0] = matrix[3] + matrix[0];
+    planes_[1] = matrix[3] - matrix[0];
+    planes_[2] = matrix[3] + matrix[1];
+    planes_[3] = matrix[3] - matrix[1];
+    planes_[4] = matrix[3] + matrix[2];
+    planes_[5] = matrix[3] - matrix[2];
+
+    for (auto& plane : planes_) {
+        plane /= glm::length(glm::vec3(plane));
+    }
+}
+
+bool FrustumCuller::isVisible(const Bounds& worldBounds) const
+{
+    const auto boxCenter = worldBounds.box.getCenter();
+    const auto boxExtent = worldBounds.box.getExtent();
+    for (const auto& plane : planes_)
+    {
+        if (getInnerDistance(plane, boxCenter, boxExtent, worldBounds.sphere.center, worldBounds.sphere.radius) < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t FrustumCuller::cull(const CullList& objects, std::vector<uint8_t>& visibility)
+{
+    const auto count = objects.size();
+    visibility.resize(count);
+    size_t first = 0;
+
+#ifdef FRUSTUM_CULLER_AVX
+    for (; first + 8 <= count; first += 8)
+    {
+        const auto boxX = _mm256_loadu_ps(&objects.boxCenterX_[first]);
+        const auto boxY = _mm256_loadu_ps(&objects.boxCenterY_[first]);
+        const auto boxZ = _mm256_loadu_ps(&objects.boxCenterZ_[first]);
+        const auto extentX = _mm256_loadu_ps(&objects.boxExtentX_[first]);
+        const auto extentY = _mm256_loadu_ps(&objects.boxExtentY_[first]);
+        const auto extentZ = _mm256_loadu_ps(&objects.boxExtentZ_[first]);
+        const auto sphereX = _mm256_loadu_ps(&objects.sphereX_[first]);
+        const auto sphereY = _mm256_loadu_ps(&objects.sphereY_[first]);
+        const auto sphereZ = _mm256_loadu_ps(&objects.sphereZ_[first]);
+        const auto radius = _mm256_loadu_ps(&objects.sphereRadius_[first]);
+
+        auto outside = _mm256_setzero_ps();
+        for (const auto& plane : planes_)
+        {
+            const auto normalX = _mm256_set1_ps(plane.x), normalY = _mm256_set1_ps(plane.y), normalZ = _mm256_set1_ps(plane.z);
+            const auto distance = _mm256_set1_ps(plane.w);
+            const auto boxReach = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(std::abs(plane.x)), extentX),
+                _mm256_mul_ps(_mm256_set1_ps(std::abs(plane.y)), extentY)), _mm256_mul_ps(_mm256_set1_ps(std::abs(plane.z)), extentZ));
+            const auto boxDistance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(normalX, boxX), _mm256_mul_ps(normalY, boxY)),
+                _mm256_add_ps(_mm256_mul_ps(normalZ, boxZ), distance)), boxReach);
+            const auto sphereDistance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(normalX, sphereX), _mm256_mul_ps(normalY, sphereY)),
+                _mm256_add_ps(_mm256_mul_ps(normalZ, sphereZ), distance)), radius);
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_min_ps(boxDistance, sphereDistance), _mm256_setzero_ps(), _CMP_LT_OQ));
+        }
+
+        const auto outsideMask = _mm256_movemask_ps(outside);
+        for (auto i = 0; i < 8; i++) {
+            visibility[first + i] = (outsideMask >> i) & 1 ? 0 : 1;
+        }
+    }
+#endif
+
+#ifdef FRUSTUM_CULLER_SSE
+    for (; first + 4 <= count; first += 4)
+    {
+        const auto boxX = _mm_loadu_ps(&objects.boxCenterX_[first]);
+        const auto boxY = _mm_loadu_ps(&objects.boxCenterY_[first]);
+        const auto boxZ = _mm_loadu_ps(&objects.boxCenterZ_[first]);
+        const auto extentX = _mm_loadu_ps(&objects.boxExtentX_[first]);
+        const auto extentY = _mm_loadu_ps(&objects.boxExtentY_[first]);
+        const auto extentZ = _mm_loadu_ps(&objects.boxExtentZ_[first]);
+        const auto sphereX = _mm_loadu_ps(&objects.sphereX_[first]);
+        const auto sphereY = _mm_loadu_ps(&objects.sphereY_[first]);
+        const auto sphereZ = _mm_loadu_ps(&objects.sphereZ_[first]);
+        const auto radius = _mm_loadu_ps(&objects.sphereRadius_[first]);
+
+        auto outside = _mm_setzero_ps();
+        for (const auto& plane : planes_)
+        {
+            const auto normalX = _mm_set1_ps(plane.x), normalY = _mm_set1_ps(plane.y), normalZ = _mm_set1_ps(plane.z);
+            const auto distance = _mm_set1_ps(plane.w);
+            const auto boxReach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(std::abs(plane.x)), extentX),
+                _mm_mul_ps(_mm_set1_ps(std::abs(plane.y)), extentY)), _mm_mul_ps(_mm_set1_ps(std::abs(plane.z)), extentZ));
+            const auto boxDistance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(normalX, boxX), _mm_mul_ps(normalY, boxY)),
+                _mm_add_ps(_mm_mul_ps(normalZ, boxZ), distance)), boxReach);
+            const auto sphereDistance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(normalX, sphereX), _mm_mul_ps(normalY, sphereY)),
+                _mm_add_ps(_mm_mul_ps(normalZ, sphereZ), distance)), radius);
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_min_ps(boxDistance, sphereDistance), _mm_setzero_ps()));
+        }
+
+        const auto outsideMask = _mm_movemask_ps(outside);
+        for (auto i = 0; i < 4; i++) {
+            visibility[first + i] = (outsideMask >> i) & 1 ? 0 : 1;
+        }
+    }
+#endif
+
+    cullScalar(objects, first, count, visibility.data());
+
+    size_t numVisible = 0;
+    for (const auto visible : visibility) {
+        numVisible += visible;
+    }
+
+    stats_.numTested = count;
+    stats_.numCulled = count - numVisible;
+    Profiler::addCounter("objects tested", static_cast<double>(stats_.numTested));
+    Profiler::addCounter("objects culled", static_cast<double>(stats_.numCulled));
+    return numVisible;
+}
+
+const FrustumCuller::Stats& FrustumCuller::getStats() const
+{
+    return stats_;
+}
+
+const glm::vec4* FrustumCuller::getPlanes() const
+{
+    return planes_;
+}
+
+void FrustumCuller::cullScalar(const CullList& objects, size_t first, size_t last, uint8_t* visibility) const
+{
+    for (auto i = first; i < last; i++)
+    {
+        const glm::vec3 boxCenter(objects.boxCenterX_[i], objects.boxCenterY_[i], objects.boxCenterZ_[i]);
+        const glm::vec3 boxExtent(objects.boxExtentX_[i], objects.boxExtentY_[i], objects.boxExtentZ_[i]);
+        const glm::vec3 sphereCenter(objects.sphereX_[i], objects.sphereY_[i], objects.sphereZ_[i]);
+
+        visibility[i] = 1;
+        for (auto plane = 0; plane < NUM_PLANES; plane++)
+        {
+            if (getInnerDistance(planes_[plane], boxCenter, boxExtent, sphereCenter, objects.sphereRadius_[i]) < 0.0f)
+            {
+                visibility[i] = 0;
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,106 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code tests world bounds of scene objects against the view frustum, several objects at once with SSE / AVX
+
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Project
+#include "boundingVolume.h"
+
+/**
+ * World bounds of many objects, stored per component so that the culler loads 4 / 8 objects
+ * into one SIMD register. Object index is the order of add calls.
+ */
+class CullList
+{
+public:
+    /**
+     * Adds an object.
+     *
+     * @param worldBounds  Bounds of the object in world space
+     *
+     * @return Index of the object, its visibility is at this index after FrustumCuller::cull.
+     */
+    size_t add(const Bounds& worldBounds);
+
+    /**
+     * Replaces bounds of an object that moved.
+     */
+    void set(size_t index, const Bounds& worldBounds);
+
+    void clear();
+    size_t size() const;
+
+private:
+    friend class FrustumCuller;
+    friend class OcclusionCuller;
+
+    std::vector<float> boxCenterX_, boxCenterY_, boxCenterZ_;
+    std::vector<float> boxExtentX_, boxExtentY_, boxExtentZ_;
+    std::vector<float> sphereX_, sphereY_, sphereZ_, sphereRadius_;
+};
+
+/**
+ * View frustum culling. Six planes are extracted from projection * view (Gribb / Hartmann) and every
+ * object is tested with both its box and its sphere, it is culled when either of them lies completely
+ * outside one plane. Objects go through in batches of 8 with AVX, 4 with SSE, and one by one
+ * for the rest of the list (or everywhere, when no SIMD is available).
+ */
+class FrustumCuller
+{
+public:
+    /**
+     * Objects tested and culled by the last cull call.
+     */
+    struct Stats
+    {
+        size_t numTested = 0;
+        size_t numCulled = 0;
+    };
+
+    /**
+     * Extracts frustum planes, call whenever the camera changes (every frame).
+     *
+     * @param viewProjection  projection * view
+     */
+    void setViewProjection(const glm::mat4& viewProjection);
+
+    /**
+     * Tests one object.
+     *
+     * @return True, if the bounds are at least partly inside the frustum.
+     */
+    bool isVisible(const Bounds& worldBounds) const;
+
+    /**
+     * Tests all objects of a list and counts them into the "objects tested" / "objects culled" profiler counters.
+     *
+     * @param objects     Objects to test
+     * @param visibility  Output, resized to the list size, 1 for objects at least partly inside the frustum
+     *
+     * @return Number of visible objects.
+     */
+    size_t cull(const CullList& objects, std::vector<uint8_t>& visibility);
+
+    const Stats& getStats() const;
+
+    /**
+     * Gets the six planes of the last setViewProjection, for culling on the GPU.
+     */
+    const glm::vec4* getPlanes() const;
+
+private:
+    /**
+     * Tests objects of the list one by one.
+     */
+    void cullScalar(const CullList& objects, size_t first, size_t last, uint8_t* visibility) const;
+
+    glm::vec4 planes_[6]; // xyz is the normal pointing inside, w the distance, normalized
+    Stats stats_;
+};
@@ -0,0 +1,407 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code keeps many meshes of one vertex format in shared GPU buffers behind a single VAO
+
+#include <algorithm>
+#include <iostream>
+
+// Project
+#include "geometryPool.h"
+#include "ShapeData.h"
+#include "glStateCache.h"
+#include "gpuResourceTracker.h"
+#include "profiler.h"
+
+const uint32_t GeometryHandle::INVALID_ID = ~0u;
+
+namespace {
+
+    /**
+     * Creates a buffer of given size, through the copy target - binding an element buffer would change the bound VAO.
+     */
+    GLuint createBuffer(size_t sizeBytes)
+    {
+        GLuint buffer = 0;
+        GpuResourceTracker::genBuffers(1, &buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, sizeBytes, nullptr, GL_STATIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        return buffer;
+    }
+
+    void uploadRange(GLuint buffer, size_t offsetBytes, size_t sizeBytes, const void* data)
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, offsetBytes, sizeBytes, data);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    void* mapRange(GLuint buffer, size_t offsetBytes, size_t sizeBytes)
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        auto* data = glMapBufferRange(GL_COPY_WRITE_BUFFER, offsetBytes, sizeBytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        return data;
+    }
+
+    bool unmapBuffer(GLuint buffer)
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        const auto isUnmapped = glUnmapBuffer(GL_COPY_WRITE_BUFFER) == GL_TRUE;
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        return isUnmapped;
+    }
+
+    bool isIntegerType(GLenum type)
+    {
+        return type == GL_BYTE || type == GL_UNSIGNED_BYTE || type == GL_SHORT || type == GL_UNSIGNED_SHORT
+            || type == GL_INT || type == GL_UNSIGNED_INT;
+    }
+
+    GLuint readIndex(const void* indices, GLenum indexType, size_t i)
+    {
+        return indexType == GL_UNSIGNED_SHORT ? static_cast<const GLushort*>(indices)[i] : static_cast<const GLuint*>(indices)[i];
+    }
+
+} // namespace
+
+VertexFormat VertexFormat::shapeData()
+{
+    VertexFormat format;
+    format.stride = sizeof(Vertex);
+    format.attributes = {
+        { 0, 3, GL_FLOAT, GL_FALSE, static_cast<GLuint>(offsetof(Vertex, position)) },
+        { 1, 3, GL_FLOAT, GL_FALSE, static_cast<GLuint>(offsetof(Vertex, color)) },
+        { 2, 3, GL_FLOAT, GL_FALSE, static_cast<GLuint>(offsetof(Vertex, normal)) },
+    };
+    return format;
+}
+
+bool GeometryHandle::isValid() const
+{
+    return id != INVALID_ID;
+}
+
+GeometryPool::~GeometryPool()
+{
+    deletePool();
+}
+
+bool GeometryPool::create(const VertexFormat& format, uint32_t vertexCapacity, uint32_t indexCapacity, GLenum indexType)
+{
+    if (vao_ != 0)
+    {
+        std::cerr << "This geometry pool is already created! You need to delete it before re-creating it!" << std::endl;
+        return false;
+    }
+    if (format.stride <= 0 || (indexType != GL_UNSIGNED_SHORT && indexType != GL_UNSIGNED_INT))
+    {
+        std::cerr << "Geometry pool needs a vertex stride and 16 or 32-bit indices!" << std::endl;
+        return false;
+    }
+
+    format_ = format;
+    indexType_ = indexType;
+    vertexCapacity = std::max(vertexCapacity, 1u);
+    indexCapacity = std::max(indexCapacity, 1u);
+    vertexBufferID_ = createBuffer(static_cast<size_t>(vertexCapacity) * format_.stride);
+    indexBufferID_ = createBuffer(static_cast<size_t>(indexCapacity) * getIndexSize());
+    vertexAllocator_.reset(vertexCapacity);
+    indexAllocator_.reset(indexCapacity);
+    stats_ = Stats();
+    stats_.vertexCapacity = vertexCapacity;
+    stats_.indexCapacity = indexCapacity;
+
+    GpuResourceTracker::genVertexArrays(1, &vao_);
+    setupVertexArray();
+    return true;
+}
+
+GeometryHandle GeometryPool::add(const void* vertices, uint32_t numVertices, const void* indices, uint32_t numIndices, GLenum indexType)
+{
+    const auto handle = reserve(numVertices, numIndices);
+    if (!handle.isValid()) {
+        return handle;
+    }
+
+    const auto& allocation = allocations_[handle.id];
+    const auto firstVertex = allocation.firstVertex;
+    const auto firstIndex = allocation.firstIndex;
+    uploadRange(vertexBufferID_, static_cast<size_t>(firstVertex) * format_.stride, static_cast<size_t>(numVertices) * format_.stride, vertices);
+    if (indexType == indexType_) {
+        uploadRange(indexBufferID_, static_cast<size_t>(firstIndex) * getIndexSize(), static_cast<size_t>(numIndices) * getIndexSize(), indices);
+    }
+    else if (indexType_ == GL_UNSIGNED_SHORT)
+    {
+        std::vector<GLushort> converted(numIndices);
+        for (uint32_t i = 0; i < numIndices; i++) {
+            converted[i] = static_cast<GLushort>(readIndex(indices, indexType, i));
+        }
+        uploadRange(indexBufferID_, static_cast<size_t>(firstIndex) * sizeof(GLushort), converted.size() * sizeof(GLushort), converted.data());
+    }
+    else
+    {
+        std::vector<GLuint> converted(numIndices);
+        for (uint32_t i = 0; i < numIndices; i++) {
+            converted[i] = readIndex(indices, indexType, i);
+        }
+        uploadRange(indexBufferID_, static_cast<size_t>(firstIndex) * sizeof(GLuint), converted.size() * sizeof(GLuint), converted.data());
+    }
+    return handle;
+}
+
+GeometryHandle GeometryPool::reserve(uint32_t numVertices, uint32_t numIndices)
+{
+    GeometryHandle handle;
+    if (vao_ == 0 || isMapped_ || numVertices == 0 || numIndices == 0) {
+        return handle;
+    }
+    if (indexType_ == GL_UNSIGNED_SHORT && numVertices > 0x10000u)
+    {
+        std::cerr << "Mesh with " << numVertices << " vertices does not fit 16-bit indices of the geometry pool!" << std::endl;
+        return handle;
+    }
+
+    auto firstVertex = vertexAllocator_.allocate(numVertices);
+    auto firstIndex = indexAllocator_.allocate(numIndices);
+    if (firstVertex == OffsetAllocator::NO_SPACE || firstIndex == OffsetAllocator::NO_SPACE)
+    {
+        // Ranges that did fit go back, growing packs every mesh anew anyway
+        if (firstVertex != OffsetAllocator::NO_SPACE) {
+            vertexAllocator_.free(firstVertex, numVertices);
+        }
+        if (firstIndex != OffsetAllocator::NO_SPACE) {
+            indexAllocator_.free(firstIndex, numIndices);
+        }
+
+        relocate(std::max(stats_.vertexCapacity * 2, stats_.usedVertices + numVertices),
+            std::max(stats_.indexCapacity * 2, stats_.usedIndices + numIndices));
+        firstVertex = vertexAllocator_.allocate(numVertices);
+        firstIndex = indexAllocator_.allocate(numIndices);
+    }
+
+    if (freeIds_.empty())
+    {
+        handle.id = static_cast<uint32_t>(allocations_.size());
+        allocations_.emplace_back();
+    }
+    else
+    {
+        handle.id = freeIds_.back();
+        freeIds_.pop_back();
+    }
+
+    auto& allocation = allocations_[handle.id];
+    allocation.firstVertex = firstVertex;
+    allocation.numVertices = numVertices;
+    allocation.firstIndex = firstIndex;
+    allocation.numIndices = numIndices;
+    allocation.isUsed = true;
+    stats_.numMeshes++;
+    stats_.usedVertices += numVertices;
+    stats_.usedIndices += numIndices;
+    return handle;
+}
+
+bool GeometryPool::mapMesh(GeometryHandle mesh, void*& vertices, void*& indices)
+{
+    vertices = indices = nullptr;
+    if (isMapped_ || !mesh.isValid() || mesh.id >= allocations_.size() || !allocations_[mesh.id].isUsed) {
+        return false;
+    }
+
+    // Map state belongs to the buffer, so both stay mapped while the copy target moves on
+    const auto& allocation = allocations_[mesh.id];
+    vertices = mapRange(vertexBufferID_, static_cast<size_t>(allocation.firstVertex) * format_.stride, static_cast<size_t>(allocation.numVertices) * format_.stride);
+    indices = mapRange(indexBufferID_, static_cast<size_t>(allocation.firstIndex) * getIndexSize(), static_cast<size_t>(allocation.numIndices) * getIndexSize());
+    if (vertices == nullptr || indices == nullptr)
+    {
+        std::cerr << "Could not map mesh " << mesh.id << " of geometry pool for writing!" << std::endl;
+        if (vertices != nullptr) {
+            unmapBuffer(vertexBufferID_);
+        }
+        if (indices != nullptr) {
+            unmapBuffer(indexBufferID_);
+        }
+        vertices = indices = nullptr;
+        return false;
+    }
+
+    isMapped_ = true;
+    return true;
+}
+
+bool GeometryPool::unmapMesh()
+{
+    if (!isMapped_) {
+        return false;
+    }
+
+    const auto isVertexDataKept = unmapBuffer(vertexBufferID_);
+    const auto isIndexDataKept = unmapBuffer(indexBufferID_);
+    isMapped_ = false;
+    return isVertexDataKept && isIndexDataKept;
+}
+
+void GeometryPool::remove(GeometryHandle mesh)
+{
+    if (!mesh.isValid() || mesh.id >= allocations_.size() || !allocations_[mesh.id].isUsed) {
+        return;
+    }
+
+    auto& allocation = allocations_[mesh.id];
+    vertexAllocator_.free(allocation.firstVertex, allocation.numVertices);
+    indexAllocator_.free(allocation.firstIndex, allocation.numIndices);
+    stats_.numMeshes--;
+    stats_.usedVertices -= allocation.numVertices;
+    stats_.usedIndices -= allocation.numIndices;
+    allocation = Allocation();
+    freeIds_.push_back(mesh.id);
+}
+
+void GeometryPool::defragment()
+{
+    // Nothing to gain, when the free space is one range already
+    if (vao_ == 0 || isMapped_ || (vertexAllocator_.getLargestFreeRange() == vertexAllocator_.getFreeSize()
+        && indexAllocator_.getLargestFreeRange() == indexAllocator_.getFreeSize())) {
+        return;
+    }
+
+    relocate(stats_.vertexCapacity, stats_.indexCapacity);
+}
+
+void GeometryPool::fillPacket(GeometryHandle mesh, DrawPacket& packet) const
+{
+    const auto& allocation = allocations_[mesh.id];
+    packet.vao = vao_;
+    packet.kind = DrawKind::Elements;
+    packet.count = static_cast<GLsizei>(allocation.numIndices);
+    packet.indexType = indexType_;
+    packet.indexOffset = static_cast<uintptr_t>(allocation.firstIndex) * getIndexSize();
+    packet.baseVertex = static_cast<GLint>(allocation.firstVertex);
+}
+
+void GeometryPool::draw(GeometryHandle mesh) const
+{
+    const auto& allocation = allocations_[mesh.id];
+    GLStateCache::bindVertexArray(vao_);
+    glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(allocation.numIndices), indexType_,
+        reinterpret_cast<void*>(static_cast<uintptr_t>(allocation.firstIndex) * getIndexSize()), static_cast<GLint>(allocation.firstVertex));
+    Profiler::countDraw(GL_TRIANGLES, static_cast<GLsizei>(allocation.numIndices));
+}
+
+GLuint GeometryPool::getVAO() const
+{
+    return vao_;
+}
+
+GLenum GeometryPool::getIndexType() const
+{
+    return indexType_;
+}
+
+GLsizei GeometryPool::getVertexStride() const
+{
+    return format_.stride;
+}
+
+GLsizei GeometryPool::getNumIndices(GeometryHandle mesh) const
+{
+    return mesh.isValid() && mesh.id < allocations_.size() ? static_cast<GLsizei>(allocations_[mesh.id].numIndices) : 0;
+}
+
+const GeometryPool::Stats& GeometryPool::getStats() const
+{
+    return stats_;
+}
+
+void GeometryPool::deletePool()
+{
+    if (vao_ == 0) {
+        return;
+    }
+
+    unmapMesh();
+    GpuResourceTracker::deleteVertexArrays(1, &vao_);
+    GpuResourceTracker::deleteBuffers(1, &vertexBufferID_);
+    GpuResourceTracker::deleteBuffers(1, &indexBufferID_);
+    vao_ = vertexBufferID_ = indexBufferID_ = 0;
+    allocations_.clear();
+    freeIds_.clear();
+    stats_ = Stats();
+}
+
+void GeometryPool::relocate(uint32_t vertexCapacity, uint32_t indexCapacity)
+{
+    const auto newVertexBuffer = createBuffer(static_cast<size_t>(vertexCapacity) * format_.stride);
+    const auto newIndexBuffer = createBuffer(static_cast<size_t>(indexCapacity) * getIndexSize());
+    vertexAllocator_.reset(vertexCapacity);
+    indexAllocator_.reset(indexCapacity);
+
+    // Meshes keep their order, they are only moved together
+    std::vector<uint32_t> order;
+    for (uint32_t id = 0; id < allocations_.size(); id++)
+    {
+        if (allocations_[id].isUsed) {
+            order.push_back(id);
+        }
+    }
+    std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) { return allocations_[a].firstVertex < allocations_[b].firstVertex; });
+
+    for (const auto id : order)
+    {
+        auto& allocation = allocations_[id];
+        const auto firstVertex = vertexAllocator_.allocate(allocation.numVertices);
+        const auto firstIndex = indexAllocator_.allocate(allocation.numIndices);
+
+        glBindBuffer(GL_COPY_READ_BUFFER, vertexBufferID_);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, newVertexBuffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, static_cast<size_t>(allocation.firstVertex) * format_.stride,
+            static_cast<size_t>(firstVertex) * format_.stride, static_cast<size_t>(allocation.numVertices) * format_.stride);
+        glBindBuffer(GL_COPY_READ_BUFFER, indexBufferID_);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, newIndexBuffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, static_cast<size_t>(allocation.firstIndex) * getIndexSize(),
+            static_cast<size_t>(firstIndex) * getIndexSize(), static_cast<size_t>(allocation.numIndices) * getIndexSize());
+
+        allocation.firstVertex = firstVertex;
+        allocation.firstIndex = firstIndex;
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    GpuResourceTracker::deleteBuffers(1, &vertexBufferID_);
+    GpuResourceTracker::deleteBuffers(1, &indexBufferID_);
+    vertexBufferID_ = newVertexBuffer;
+    indexBufferID_ = newIndexBuffer;
+    stats_.vertexCapacity = vertexCapacity;
+    stats_.indexCapacity = indexCapacity;
+    stats_.numRelocations++;
+    setupVertexArray();
+}
+
+void GeometryPool::setupVertexArray()
+{
+    GLStateCache::bindVertexArray(vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBufferID_);
+    for (const auto& attribute : format_.attributes)
+    {
+        glEnableVertexAttribArray(attribute.location);
+        // Integer attributes that are not normalized reach the shader as integers (uint, ivec...)
+        if (isIntegerType(attribute.type) && !attribute.normalized) {
+            glVertexAttribIPointer(attribute.location, attribute.size, attribute.type, format_.stride,
+                reinterpret_cast<void*>(static_cast<uintptr_t>(attribute.offset)));
+        }
+        else {
+            glVertexAttribPointer(attribute.location, attribute.size, attribute.type, attribute.normalized, format_.stride,
+                reinterpret_cast<void*>(static_cast<uintptr_t>(attribute.offset)));
+        }
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferID_);
+    GLStateCache::bindVertexArray(0);
+}
+
+size_t GeometryPool::getIndexSize() const
+{
+    return indexType_ == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+}
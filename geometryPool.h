@@ -0,0 +1,204 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code keeps many meshes of one vertex format in shared GPU buffers behind a single VAO
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// GLAD
+#include <glad/glad.h>
+
+// Project
+#include "offsetAllocator.h"
+#include "renderQueue.h"
+
+/**
+ * One vertex attribute of a VertexFormat, same meaning as the glVertexAttribPointer parameters.
+ */
+struct VertexAttribute
+{
+    GLuint location;
+    GLint size;
+    GLenum type;
+    GLboolean normalized;
+    GLuint offset; // Bytes from the start of the vertex
+};
+
+/**
+ * Interleaved vertex layout.
+ */
+struct VertexFormat
+{
+    GLsizei stride = 0;
+    std::vector<VertexAttribute> attributes;
+
+    /**
+     * Gets format of ShapeData vertices (position, color, normal at locations 0, 1, 2).
+     */
+    static VertexFormat shapeData();
+};
+
+/**
+ * Handle of a mesh in a GeometryPool.
+ */
+struct GeometryHandle
+{
+    static const uint32_t INVALID_ID;
+
+    uint32_t id = INVALID_ID;
+
+    bool isValid() const;
+};
+
+/**
+ * Shared vertex and index buffer for meshes of one vertex format. Meshes get ranges of both buffers from
+ * offset allocators and are drawn with base vertex, so their indices stay local and all of them go through
+ * the same VAO - switching between them binds nothing. When a mesh does not fit, the buffers grow (the
+ * meshes are packed on the way), and defragment packs them in place of freed ones. Offsets of meshes
+ * change then, so draws take them from the pool every time (fillPacket) instead of remembering them.
+ */
+class GeometryPool
+{
+public:
+    /**
+     * Sizes of the pool.
+     */
+    struct Stats
+    {
+        uint32_t numMeshes = 0;
+        uint32_t usedVertices = 0;
+        uint32_t vertexCapacity = 0;
+        uint32_t usedIndices = 0;
+        uint32_t indexCapacity = 0;
+        uint32_t numRelocations = 0; // Times the buffers were grown or defragmented
+    };
+
+    GeometryPool() = default;
+    GeometryPool(const GeometryPool&) = delete;
+    GeometryPool& operator=(const GeometryPool&) = delete;
+    ~GeometryPool();
+
+    /**
+     * Creates the buffers and the VAO.
+     *
+     * @param format          Vertex layout of all meshes
+     * @param vertexCapacity  Initial number of vertices
+     * @param indexCapacity   Initial number of indices
+     * @param indexType       GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, indices are per mesh, so 16 bits are enough
+     *                        for any mesh with up to 65536 vertices no matter how big the pool is
+     *
+     * @return True, if the pool was created.
+     */
+    bool create(const VertexFormat& format, uint32_t vertexCapacity, uint32_t indexCapacity, GLenum indexType = GL_UNSIGNED_SHORT);
+
+    /**
+     * Uploads a mesh. Indices of another type than the pool's are converted.
+     *
+     * @param vertices     Vertices in the pool's format
+     * @param numVertices  Number of vertices
+     * @param indices      Indices, relative to the first vertex of the mesh
+     * @param numIndices   Number of indices
+     * @param indexType    Type of the given indices
+     *
+     * @return Handle of the mesh, invalid if it could not be added.
+     */
+    GeometryHandle add(const void* vertices, uint32_t numVertices, const void* indices, uint32_t numIndices, GLenum indexType);
+
+    /**
+     * Allocates ranges for a mesh without uploading anything, they are written with mapMesh.
+     *
+     * @return Handle of the mesh, invalid if it could not be added.
+     */
+    GeometryHandle reserve(uint32_t numVertices, uint32_t numIndices);
+
+    /**
+     * Maps vertex and index ranges of a mesh for writing, so a generator can write it straight into the
+     * buffers instead of into a copy in system memory. Contents of the ranges are undefined until written.
+     * Nothing else may be done with the pool until unmapMesh.
+     *
+     * @param mesh      Mesh to (over)write
+     * @param vertices  Receives the first vertex of the mesh
+     * @param indices   Receives the first index of the mesh, of the pool's index type
+     *
+     * @return True, if both ranges were mapped (nothing stays mapped otherwise).
+     */
+    bool mapMesh(GeometryHandle mesh, void*& vertices, void*& indices);
+
+    /**
+     * Unmaps ranges mapped by mapMesh.
+     *
+     * @return True, if the written data survived (unmapping fails when buffer contents got lost while mapped).
+     */
+    bool unmapMesh();
+
+    /**
+     * Frees ranges of a mesh, its handle becomes invalid.
+     */
+    void remove(GeometryHandle mesh);
+
+    /**
+     * Moves all meshes to the start of the buffers, so the free space is in one piece.
+     */
+    void defragment();
+
+    /**
+     * Fills draw fields of a packet - VAO, index range and base vertex of the mesh.
+     */
+    void fillPacket(GeometryHandle mesh, DrawPacket& packet) const;
+
+    /**
+     * Draws a mesh as a triangle list.
+     */
+    void draw(GeometryHandle mesh) const;
+
+    GLuint getVAO() const;
+    GLenum getIndexType() const;
+    GLsizei getVertexStride() const;
+    GLsizei getNumIndices(GeometryHandle mesh) const;
+    const Stats& getStats() const;
+
+    /**
+     * Deletes the buffers, the VAO and all meshes.
+     */
+    void deletePool();
+
+private:
+    /**
+     * Ranges of one mesh, in vertices and indices.
+     */
+    struct Allocation
+    {
+        uint32_t firstVertex = 0;
+        uint32_t numVertices = 0;
+        uint32_t firstIndex = 0;
+        uint32_t numIndices = 0;
+        bool isUsed = false;
+    };
+
+    /**
+     * Copies all meshes packed into new buffers of given capacity and points the VAO to them.
+     */
+    void relocate(uint32_t vertexCapacity, uint32_t indexCapacity);
+
+    /**
+     * Binds buffers to the VAO and sets its vertex attributes.
+     */
+    void setupVertexArray();
+
+    size_t getIndexSize() const;
+
+    VertexFormat format_;
+    GLenum indexType_{ GL_UNSIGNED_SHORT };
+    GLuint vao_{ 0 };
+    GLuint vertexBufferID_{ 0 };
+    GLuint indexBufferID_{ 0 };
+    OffsetAllocator vertexAllocator_;
+    OffsetAllocator indexAllocator_;
+    std::vector<Allocation> allocations_; // Indexed by handle id
+    std::vector<uint32_t> freeIds_;
+    bool isMapped_{ false };
+    Stats stats_;
+};
@@ -0,0 +1,181 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code remembers the bound program, VAO and textures, so binds of what is already bound never reach the driver
+
+// Project
+#include "glStateCache.h"
+#include "profiler.h"
+
+namespace {
+
+    // Name no object has, binding state starts as unknown
+    const GLuint UNKNOWN_BINDING = ~0u;
+
+    const GLenum TRACKED_TEXTURE_TARGETS[] = { GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BUFFER, GL_TEXTURE_3D, GL_TEXTURE_CUBE_MAP };
+    const int NUM_TRACKED_TEXTURE_TARGETS = sizeof(TRACKED_TEXTURE_TARGETS) / sizeof(TRACKED_TEXTURE_TARGETS[0]);
+    const int MAX_UNITS = 32;
+
+    GLuint currentProgram = UNKNOWN_BINDING;
+    GLuint currentVao = UNKNOWN_BINDING;
+    GLuint activeUnit = UNKNOWN_BINDING; // Unit index, not GL_TEXTURE0 + index
+    GLuint boundTextures[MAX_UNITS][NUM_TRACKED_TEXTURE_TARGETS];
+    bool isTextureStateKnown = false; // boundTextures is filled with UNKNOWN_BINDING on first use
+
+    long long numCalls = 0; // Binds passed to the driver since last report
+    long long numSkipped = 0; // Binds dropped since last report
+
+    void resetTextures()
+    {
+        for (auto& unitTextures : boundTextures)
+        {
+            for (auto& texture : unitTextures) {
+                texture = UNKNOWN_BINDING;
+            }
+        }
+        isTextureStateKnown = true;
+    }
+
+    int getTargetIndex(GLenum target)
+    {
+        for (auto i = 0; i < NUM_TRACKED_TEXTURE_TARGETS; i++)
+        {
+            if (TRACKED_TEXTURE_TARGETS[i] == target) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    /**
+     * Gets cache slot of texture bound to a unit and target, nullptr if the pair is not tracked.
+     */
+    GLuint* findTextureSlot(GLuint unit, GLenum target)
+    {
+        if (!isTextureStateKnown) {
+            resetTextures();
+        }
+
+        const auto targetIndex = getTargetIndex(target);
+        if (unit >= static_cast<GLuint>(MAX_UNITS) || targetIndex < 0) {
+            return nullptr;
+        }
+        return &boundTextures[unit][targetIndex];
+    }
+
+    /**
+     * Updates cached value, returns true if the driver has to be called.
+     */
+    bool update(GLuint& cached, GLuint value)
+    {
+        if (cached == value)
+        {
+            numSkipped++;
+            return false;
+        }
+
+        cached = value;
+        numCalls++;
+        return true;
+    }
+
+} // namespace
+
+void GLStateCache::useProgram(GLuint program)
+{
+    if (update(currentProgram, program)) {
+        glUseProgram(program);
+    }
+}
+
+void GLStateCache::bindVertexArray(GLuint vao)
+{
+    if (update(currentVao, vao)) {
+        glBindVertexArray(vao);
+    }
+}
+
+void GLStateCache::activeTexture(GLenum texture)
+{
+    if (update(activeUnit, texture - GL_TEXTURE0)) {
+        glActiveTexture(texture);
+    }
+}
+
+void GLStateCache::bindTexture(GLenum target, GLuint texture)
+{
+    auto* slot = activeUnit != UNKNOWN_BINDING ? findTextureSlot(activeUnit, target) : nullptr;
+    if (slot == nullptr)
+    {
+        numCalls++;
+        glBindTexture(target, texture);
+        return;
+    }
+
+    if (update(*slot, texture)) {
+        glBindTexture(target, texture);
+    }
+}
+
+void GLStateCache::bindTextureUnit(GLuint unit, GLenum target, GLuint texture)
+{
+    const auto* slot = findTextureSlot(unit, target);
+    if (slot != nullptr && *slot == texture)
+    {
+        numSkipped++;
+        return;
+    }
+
+    activeTexture(GL_TEXTURE0 + unit);
+    bindTexture(target, texture);
+}
+
+void GLStateCache::onVertexArraysDeleted(GLsizei count, const GLuint* ids)
+{
+    for (GLsizei i = 0; i < count; i++)
+    {
+        if (ids[i] != 0 && currentVao == ids[i]) {
+            currentVao = 0;
+        }
+    }
+}
+
+void GLStateCache::onTexturesDeleted(GLsizei count, const GLuint* ids)
+{
+    if (!isTextureStateKnown) {
+        return;
+    }
+
+    for (GLsizei i = 0; i < count; i++)
+    {
+        if (ids[i] == 0) {
+            continue;
+        }
+
+        for (auto& unitTextures : boundTextures)
+        {
+            for (auto& texture : unitTextures)
+            {
+                if (texture == ids[i]) {
+                    texture = 0;
+                }
+            }
+        }
+    }
+}
+
+void GLStateCache::invalidate()
+{
+    currentProgram = UNKNOWN_BINDING;
+    currentVao = UNKNOWN_BINDING;
+    activeUnit = UNKNOWN_BINDING;
+    resetTextures();
+}
+
+void GLStateCache::reportFrameCounters()
+{
+    Profiler::addCounter("gl binds", static_cast<double>(numCalls));
+    Profiler::addCounter("gl binds skipped", static_cast<double>(numSkipped));
+    numCalls = 0;
+    numSkipped = 0;
+}
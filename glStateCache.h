@@ -0,0 +1,70 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code remembers the bound program, VAO and textures, so binds of what is already bound never reach the driver
+
+#pragma once
+
+// GLAD
+#include <glad/glad.h>
+
+/**
+ * Shadow copy of the binding state of the OpenGL context. All glUseProgram, glBindVertexArray,
+ * glActiveTexture and glBindTexture calls go through here - a call binding what is already bound
+ * returns without calling the driver. Calls made and calls skipped are counted and handed to the
+ * profiler once per frame. State is unknown at start and after invalidate, so the first bind always
+ * goes through. Texture units 0 to 31 are tracked, binds to higher units always reach the driver.
+ * Only the thread owning the OpenGL context may use the cache.
+ */
+class GLStateCache
+{
+public:
+    /**
+     * Wrapper of glUseProgram.
+     */
+    static void useProgram(GLuint program);
+
+    /**
+     * Wrapper of glBindVertexArray.
+     */
+    static void bindVertexArray(GLuint vao);
+
+    /**
+     * Wrapper of glActiveTexture.
+     *
+     * @param texture  GL_TEXTURE0 + unit index
+     */
+    static void activeTexture(GLenum texture);
+
+    /**
+     * Wrapper of glBindTexture, binds to the active texture unit.
+     */
+    static void bindTexture(GLenum target, GLuint texture);
+
+    /**
+     * Binds texture to given unit. The active unit is switched only when the texture is not bound there yet.
+     *
+     * @param unit     Unit index (0 for GL_TEXTURE0)
+     * @param target   Texture target (GL_TEXTURE_2D...)
+     * @param texture  Texture to bind
+     */
+    static void bindTextureUnit(GLuint unit, GLenum target, GLuint texture);
+
+    /**
+     * Called by GpuResourceTracker before objects are deleted - OpenGL unbinds deleted objects
+     * and their names may come back for new objects, so the cache must not think they are still bound.
+     */
+    static void onVertexArraysDeleted(GLsizei count, const GLuint* ids);
+    static void onTexturesDeleted(GLsizei count, const GLuint* ids);
+
+    /**
+     * Forgets all bindings, for code binding behind the back of the cache (third party libraries...).
+     */
+    static void invalidate();
+
+    /**
+     * Adds calls made and skipped since the last call to the profiler counters of the current frame
+     * ("gl binds", "gl binds skipped"). Call once per frame, before Profiler::endFrame.
+     */
+    static void reportFrameCounters();
+};
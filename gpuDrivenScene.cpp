@@ -0,0 +1,248 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code keeps static meshes in shared buffers, culls objects in a compute shader and draws each shader's objects with one indirect call
+
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+
+// Project
+#include "gpuDrivenScene.h"
+#include "glStateCache.h"
+#include "gpuResourceTracker.h"
+#include "profiler.h"
+
+const GLuint GpuDrivenScene::OBJECT_BUFFER_BINDING = 0;
+const GLuint GpuDrivenScene::MESH_BUFFER_BINDING = 1;
+const GLuint GpuDrivenScene::COMMAND_BUFFER_BINDING = 2;
+const GLuint GpuDrivenScene::OBJECT_ID_LOCATION = 3;
+
+namespace {
+
+    const char* CULL_SHADER_PATH = "shaderfiles/gpu_cull.comp";
+    const GLuint CULL_GROUP_SIZE = 64; // local_size_x of the culling shader
+
+    /**
+     * Indirect command as glMultiDrawElementsIndirect reads it.
+     */
+    struct DrawElementsIndirectCommand
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+
+    /**
+     * Fills a buffer through the copy target, binding it as element buffer would change the bound VAO.
+     */
+    void uploadBuffer(GLuint buffer, GLsizeiptr sizeBytes, const void* data, GLenum usage)
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, sizeBytes, data, usage);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+} // namespace
+
+bool GpuDrivenScene::isSupported()
+{
+    return GLAD_GL_VERSION_4_3 != 0;
+}
+
+size_t GpuDrivenScene::addMesh(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices)
+{
+    GpuMesh mesh = {};
+    mesh.indexCount = static_cast<GLuint>(indices.size());
+    mesh.firstIndex = static_cast<GLuint>(indices_.size());
+    mesh.baseVertex = static_cast<GLint>(vertices_.size());
+    meshes_.push_back(mesh);
+    meshBounds_.push_back(Bounds::fromPositions(vertices.empty() ? nullptr : &vertices[0].position, vertices.size(), sizeof(Vertex)));
+
+    vertices_.insert(vertices_.end(), vertices.begin(), vertices.end());
+    indices_.insert(indices_.end(), indices.begin(), indices.end());
+    return meshes_.size() - 1;
+}
+
+size_t GpuDrivenScene::addMesh(const ShapeData& shape)
+{
+    std::vector<Vertex> vertices;
+    vertices.reserve(shape.vertices.size());
+    for (const auto& vertex : shape.vertices) {
+        vertices.push_back({ vertex.position, vertex.color, glm::vec2(vertex.normal.x, vertex.normal.y) });
+    }
+
+    std::vector<GLuint> indices(shape.numIndices());
+    for (size_t i = 0; i < indices.size(); i++) {
+        indices[i] = shape.index(i);
+    }
+    return addMesh(vertices, indices);
+}
+
+size_t GpuDrivenScene::addBatch()
+{
+    batchFirst_.push_back(0);
+    batchCount_.push_back(0);
+    batchTriangles_.push_back(0);
+    return batchFirst_.size() - 1;
+}
+
+void GpuDrivenScene::addObject(size_t batch, size_t mesh, const glm::mat4& model, GLuint materialLayer)
+{
+    objects_.push_back({ batch, mesh, model, materialLayer });
+}
+
+bool GpuDrivenScene::upload()
+{
+    if (isUploaded_)
+    {
+        std::cerr << "This GPU driven scene is already uploaded! You need to delete it before uploading it again!" << std::endl;
+        return false;
+    }
+    if (!isSupported())
+    {
+        std::cerr << "GPU driven scene needs an OpenGL 4.3 context!" << std::endl;
+        return false;
+    }
+    if (objects_.empty() || indices_.empty()) {
+        return false;
+    }
+
+    // Commands of a batch must be next to each other, one multi draw covers a range of them
+    std::stable_sort(objects_.begin(), objects_.end(), [](const ObjectDesc& a, const ObjectDesc& b) { return a.batch < b.batch; });
+    std::vector<GpuObject> gpuObjects;
+    gpuObjects.reserve(objects_.size());
+    std::fill(batchCount_.begin(), batchCount_.end(), 0);
+    std::fill(batchTriangles_.begin(), batchTriangles_.end(), 0);
+    for (size_t i = 0; i < objects_.size(); i++)
+    {
+        const auto& object = objects_[i];
+        if (batchCount_[object.batch]++ == 0) {
+            batchFirst_[object.batch] = i;
+        }
+        batchTriangles_[object.batch] += static_cast<GLsizei>(meshes_[object.mesh].indexCount / 3);
+
+        const auto worldSphere = meshBounds_[object.mesh].sphere.transformed(object.model);
+        GpuObject gpuObject = {};
+        gpuObject.model = object.model;
+        gpuObject.boundingSphere = glm::vec4(worldSphere.center, worldSphere.radius);
+        gpuObject.mesh = static_cast<GLuint>(object.mesh);
+        gpuObject.materialLayer = object.materialLayer;
+        gpuObjects.push_back(gpuObject);
+    }
+
+    std::vector<GLuint> objectIds(objects_.size());
+    std::iota(objectIds.begin(), objectIds.end(), 0u);
+
+    GLuint buffers[6];
+    GpuResourceTracker::genBuffers(6, buffers);
+    vertexBuffer_ = buffers[0];
+    indexBuffer_ = buffers[1];
+    objectIdBuffer_ = buffers[2];
+    objectBuffer_ = buffers[3];
+    meshBuffer_ = buffers[4];
+    commandBuffer_ = buffers[5];
+
+    // Only the command buffer changes after this, it is written by the culling shader every frame
+    uploadBuffer(vertexBuffer_, vertices_.size() * sizeof(Vertex), vertices_.data(), GL_STATIC_DRAW);
+    uploadBuffer(indexBuffer_, indices_.size() * sizeof(GLuint), indices_.data(), GL_STATIC_DRAW);
+    uploadBuffer(objectIdBuffer_, objectIds.size() * sizeof(GLuint), objectIds.data(), GL_STATIC_DRAW);
+    uploadBuffer(objectBuffer_, gpuObjects.size() * sizeof(GpuObject), gpuObjects.data(), GL_STATIC_DRAW);
+    uploadBuffer(meshBuffer_, meshes_.size() * sizeof(GpuMesh), meshes_.data(), GL_STATIC_DRAW);
+    uploadBuffer(commandBuffer_, objects_.size() * sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_COPY);
+
+    GpuResourceTracker::genVertexArrays(1, &vao_);
+    GLStateCache::bindVertexArray(vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer_);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, position)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, normal)));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, textureCoordinate)));
+
+    // Per-instance attribute starts at the base instance of the command, so every object reads its own index
+    glBindBuffer(GL_ARRAY_BUFFER, objectIdBuffer_);
+    glEnableVertexAttribArray(OBJECT_ID_LOCATION);
+    glVertexAttribIPointer(OBJECT_ID_LOCATION, 1, GL_UNSIGNED_INT, sizeof(GLuint), nullptr);
+    glVertexAttribDivisor(OBJECT_ID_LOCATION, 1);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer_);
+    GLStateCache::bindVertexArray(0);
+
+    cullShader_.reset(new Shader(CULL_SHADER_PATH));
+    planesLocation_ = cullShader_->getUniformId("frustumPlanes").location;
+    numObjectsLocation_ = cullShader_->getUniformId("numObjects").location;
+
+    // Geometry is on the GPU now, descriptions of objects are kept for the batch ranges only
+    vertices_.clear();
+    vertices_.shrink_to_fit();
+    indices_.clear();
+    indices_.shrink_to_fit();
+    isUploaded_ = true;
+    return true;
+}
+
+void GpuDrivenScene::cull(const FrustumCuller& frustum)
+{
+    if (!isUploaded_) {
+        return;
+    }
+
+    cullShader_->use();
+    glUniform4fv(planesLocation_, 6, &frustum.getPlanes()[0][0]);
+    glUniform1ui(numObjectsLocation_, static_cast<GLuint>(objects_.size()));
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, OBJECT_BUFFER_BINDING, objectBuffer_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MESH_BUFFER_BINDING, meshBuffer_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COMMAND_BUFFER_BINDING, commandBuffer_);
+    glDispatchCompute((static_cast<GLuint>(objects_.size()) + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+    // Commands are read by the indirect draws, not by shaders
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+    Profiler::addCounter("gpu driven objects", static_cast<double>(objects_.size()));
+}
+
+void GpuDrivenScene::draw(size_t batch) const
+{
+    if (!isUploaded_ || batch >= batchCount_.size() || batchCount_[batch] == 0) {
+        return;
+    }
+
+    GLStateCache::bindVertexArray(vao_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, OBJECT_BUFFER_BINDING, objectBuffer_);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer_);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, reinterpret_cast<const void*>(batchFirst_[batch] * sizeof(DrawElementsIndirectCommand)),
+        static_cast<GLsizei>(batchCount_[batch]), 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    // The CPU never learns which objects the GPU culled, so triangles of the whole batch are counted
+    Profiler::countDrawTriangles(batchTriangles_[batch]);
+}
+
+void GpuDrivenScene::deleteScene()
+{
+    if (!isUploaded_) {
+        return;
+    }
+
+    const GLuint buffers[] = { vertexBuffer_, indexBuffer_, objectIdBuffer_, objectBuffer_, meshBuffer_, commandBuffer_ };
+    GpuResourceTracker::deleteBuffers(6, buffers);
+    GpuResourceTracker::deleteVertexArrays(1, &vao_);
+    glDeleteProgram(cullShader_->ID);
+    cullShader_.reset();
+
+    vao_ = vertexBuffer_ = indexBuffer_ = objectIdBuffer_ = objectBuffer_ = meshBuffer_ = commandBuffer_ = 0;
+    meshes_.clear();
+    meshBounds_.clear();
+    objects_.clear();
+    batchFirst_.clear();
+    batchCount_.clear();
+    batchTriangles_.clear();
+    isUploaded_ = false;
+}
+
+size_t GpuDrivenScene::getNumObjects() const
+{
+    return objects_.size();
+}
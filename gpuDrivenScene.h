@@ -0,0 +1,160 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code keeps static meshes in shared buffers, culls objects in a compute shader and draws each shader's objects with one indirect call
+
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+#include <glad/glad.h>
+
+// Project
+#include "ShapeData.h"
+#include "boundingVolume.h"
+#include "frustumCuller.h"
+#include "shader.h"
+
+/**
+ * GPU driven rendering of static objects (GL 4.3 features, run on the 4.5 context of --gpu-driven). All meshes share one vertex and one index buffer,
+ * per-object data (model matrix, world bounding sphere, mesh and material layer) lives in a shader storage
+ * buffer, and a compute shader writes one DrawElementsIndirectCommand per object - with zero instances
+ * for objects outside of the view frustum. Objects are grouped into batches, one per shader, and every
+ * batch is drawn by a single glMultiDrawElementsIndirect, so the CPU cost does not depend on the number
+ * of objects. The command of an object has its index as base instance, shaders read it from the per-instance
+ * attribute at OBJECT_ID_LOCATION and look up their object in the buffer at OBJECT_BUFFER_BINDING.
+ */
+class GpuDrivenScene
+{
+public:
+    static const GLuint OBJECT_BUFFER_BINDING; // Shader storage binding of per-object data (0)
+    static const GLuint MESH_BUFFER_BINDING; // Shader storage binding of mesh ranges, used by the culling shader (1)
+    static const GLuint COMMAND_BUFFER_BINDING; // Shader storage binding of indirect commands written by the culling shader (2)
+    static const GLuint OBJECT_ID_LOCATION; // Vertex attribute with the object index (3)
+
+    /**
+     * Vertex of the shared buffer, attribute locations 0, 1 and 2 match the lighting shader.
+     */
+    struct Vertex
+    {
+        glm::vec3 position;
+        glm::vec3 normal;
+        glm::vec2 textureCoordinate;
+    };
+
+    /**
+     * Checks, if the current context has everything the scene needs (compute shaders, storage buffers, multi draw indirect).
+     */
+    static bool isSupported();
+
+    /**
+     * Adds a triangle list mesh to the shared buffers (only before upload).
+     *
+     * @return Index of the mesh for addObject.
+     */
+    size_t addMesh(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices);
+
+    /**
+     * Adds a generated shape, its attributes go to the same locations as in the scene's ShapeData VAOs
+     * (color at the normal location, xy of the normal as texture coordinate).
+     */
+    size_t addMesh(const ShapeData& shape);
+
+    /**
+     * Creates a batch - objects drawn by the same shader.
+     *
+     * @return Index of the batch for addObject and draw.
+     */
+    size_t addBatch();
+
+    /**
+     * Adds an object (only before upload).
+     *
+     * @param batch          Batch drawing the object
+     * @param mesh           Mesh of the object
+     * @param model          Model matrix
+     * @param materialLayer  Layer of the material array for the object, passed to the shader
+     */
+    void addObject(size_t batch, size_t mesh, const glm::mat4& model, GLuint materialLayer = 0);
+
+    /**
+     * Uploads meshes and objects and builds the culling shader.
+     *
+     * @return True, if the scene is ready to be drawn.
+     */
+    bool upload();
+
+    /**
+     * Writes draw commands of all objects on the GPU, objects outside of the frustum get zero instances.
+     *
+     * @param frustum  Frustum culler with planes of the frame already set
+     */
+    void cull(const FrustumCuller& frustum);
+
+    /**
+     * Draws all objects of a batch with the currently used shader.
+     */
+    void draw(size_t batch) const;
+
+    void deleteScene();
+
+    size_t getNumObjects() const;
+
+private:
+    /**
+     * Object as it is laid out in the shader storage buffer (std430).
+     */
+    struct GpuObject
+    {
+        glm::mat4 model;
+        glm::vec4 boundingSphere; // World center and radius
+        GLuint mesh;
+        GLuint materialLayer;
+        GLuint padding[2];
+    };
+
+    /**
+     * Range of a mesh in the shared buffers (std430).
+     */
+    struct GpuMesh
+    {
+        GLuint indexCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+    };
+
+    /**
+     * Object before upload.
+     */
+    struct ObjectDesc
+    {
+        size_t batch;
+        size_t mesh;
+        glm::mat4 model;
+        GLuint materialLayer;
+    };
+
+    std::vector<Vertex> vertices_;
+    std::vector<GLuint> indices_;
+    std::vector<GpuMesh> meshes_;
+    std::vector<Bounds> meshBounds_;
+    std::vector<ObjectDesc> objects_;
+    std::vector<size_t> batchFirst_; // First command of every batch, filled by upload
+    std::vector<size_t> batchCount_;
+    std::vector<GLsizei> batchTriangles_; // All triangles of a batch, for the profiler - culled objects included
+
+    std::unique_ptr<Shader> cullShader_;
+    GLint planesLocation_{ -1 };
+    GLint numObjectsLocation_{ -1 };
+    GLuint vao_{ 0 };
+    GLuint vertexBuffer_{ 0 };
+    GLuint indexBuffer_{ 0 };
+    GLuint objectIdBuffer_{ 0 };
+    GLuint objectBuffer_{ 0 };
+    GLuint meshBuffer_{ 0 };
+    GLuint commandBuffer_{ 0 };
+    bool isUploaded_{ false };
+};
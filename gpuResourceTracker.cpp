@@ -0,0 +1,160 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code wraps creation / deletion of OpenGL objects and keeps live counts of them per type
+
+#include <cassert>
+#include <iostream>
+
+// Project
+#include "gpuResourceTracker.h"
+#include "glStateCache.h"
+
+namespace {
+
+    const int NUM_RESOURCE_TYPES = static_cast<int>(GpuResourceType::Count);
+    const char* RESOURCE_TYPE_NAMES[NUM_RESOURCE_TYPES] = { "vertex arrays", "buffers", "textures", "queries", "framebuffers", "renderbuffers" };
+
+    long long liveCounts[NUM_RESOURCE_TYPES] = {}; // Objects alive right now
+    long long createdCounts[NUM_RESOURCE_TYPES] = {}; // Objects created since program start
+    long long frameStartCounts[NUM_RESOURCE_TYPES] = {}; // Live counts remembered in beginFrame
+
+} // namespace
+
+void GpuResourceTracker::genVertexArrays(GLsizei count, GLuint* ids)
+{
+    glGenVertexArrays(count, ids);
+    recordCreated(GpuResourceType::VertexArray, count, ids);
+}
+
+void GpuResourceTracker::deleteVertexArrays(GLsizei count, const GLuint* ids)
+{
+    recordDeleted(GpuResourceType::VertexArray, count, ids);
+    GLStateCache::onVertexArraysDeleted(count, ids);
+    glDeleteVertexArrays(count, ids);
+}
+
+void GpuResourceTracker::genBuffers(GLsizei count, GLuint* ids)
+{
+    glGenBuffers(count, ids);
+    recordCreated(GpuResourceType::Buffer, count, ids);
+}
+
+void GpuResourceTracker::deleteBuffers(GLsizei count, const GLuint* ids)
+{
+    recordDeleted(GpuResourceType::Buffer, count, ids);
+    glDeleteBuffers(count, ids);
+}
+
+void GpuResourceTracker::genTextures(GLsizei count, GLuint* ids)
+{
+    glGenTextures(count, ids);
+    recordCreated(GpuResourceType::Texture, count, ids);
+}
+
+void GpuResourceTracker::deleteTextures(GLsizei count, const GLuint* ids)
+{
+    recordDeleted(GpuResourceType::Texture, count, ids);
+    GLStateCache::onTexturesDeleted(count, ids);
+    glDeleteTextures(count, ids);
+}
+
+void GpuResourceTracker::genQueries(GLsizei count, GLuint* ids)
+{
+    glGenQueries(count, ids);
+    recordCreated(GpuResourceType::Query, count, ids);
+}
+
+void GpuResourceTracker::deleteQueries(GLsizei count, const GLuint* ids)
+{
+    recordDeleted(GpuResourceType::Query, count, ids);
+    glDeleteQueries(count, ids);
+}
+
+void GpuResourceTracker::genFramebuffers(GLsizei count, GLuint* ids)
+{
+    glGenFramebuffers(count, ids);
+    recordCreated(GpuResourceType::Framebuffer, count, ids);
+}
+
+void GpuResourceTracker::deleteFramebuffers(GLsizei count, const GLuint* ids)
+{
+    recordDeleted(GpuResourceType::Framebuffer, count, ids);
+    glDeleteFramebuffers(count, ids);
+}
+
+void GpuResourceTracker::genRenderbuffers(GLsizei count, GLuint* ids)
+{
+    glGenRenderbuffers(count, ids);
+    recordCreated(GpuResourceType::Renderbuffer, count, ids);
+}
+
+void GpuResourceTracker::deleteRenderbuffers(GLsizei count, const GLuint* ids)
+{
+    recordDeleted(GpuResourceType::Renderbuffer, count, ids);
+    glDeleteRenderbuffers(count, ids);
+}
+
+long long GpuResourceTracker::getLiveCount(GpuResourceType type)
+{
+    return liveCounts[static_cast<int>(type)];
+}
+
+long long GpuResourceTracker::getCreatedCount(GpuResourceType type)
+{
+    return createdCounts[static_cast<int>(type)];
+}
+
+void GpuResourceTracker::beginFrame()
+{
+    for (auto i = 0; i < NUM_RESOURCE_TYPES; i++) {
+        frameStartCounts[i] = liveCounts[i];
+    }
+}
+
+bool GpuResourceTracker::endFrame()
+{
+    auto isFlat = true;
+    for (auto i = 0; i < NUM_RESOURCE_TYPES; i++)
+    {
+        if (liveCounts[i] > frameStartCounts[i])
+        {
+            std::cerr << "Frame leaked " << liveCounts[i] - frameStartCounts[i] << " " << RESOURCE_TYPE_NAMES[i]
+                << " (" << liveCounts[i] << " alive)!" << std::endl;
+            isFlat = false;
+        }
+    }
+
+    assert(isFlat && "GPU objects must not be created in the render loop without being deleted in the same frame");
+    return isFlat;
+}
+
+void GpuResourceTracker::printLiveCounts(std::ostream& os)
+{
+    for (auto i = 0; i < NUM_RESOURCE_TYPES; i++) {
+        os << "Live " << RESOURCE_TYPE_NAMES[i] << ": " << liveCounts[i] << " (created " << createdCounts[i] << " in total)" << std::endl;
+    }
+}
+
+void GpuResourceTracker::recordCreated(GpuResourceType type, GLsizei count, const GLuint* ids)
+{
+    for (GLsizei i = 0; i < count; i++)
+    {
+        if (ids[i] != 0)
+        {
+            liveCounts[static_cast<int>(type)]++;
+            createdCounts[static_cast<int>(type)]++;
+        }
+    }
+}
+
+void GpuResourceTracker::recordDeleted(GpuResourceType type, GLsizei count, const GLuint* ids)
+{
+    // OpenGL silently ignores zero names, so we do the same
+    for (GLsizei i = 0; i < count; i++)
+    {
+        if (ids[i] != 0) {
+            liveCounts[static_cast<int>(type)]--;
+        }
+    }
+}
@@ -0,0 +1,97 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code counts every VAO, buffer, texture, query and framebuffer we create and delete so leaks in the render loop are caught right away
+
+#pragma once
+#include <ostream>
+
+// GLAD
+#include <glad/glad.h>
+
+/**
+ * Types of OpenGL objects tracked by the GpuResourceTracker.
+ */
+enum class GpuResourceType
+{
+    VertexArray,
+    Buffer,
+    Texture,
+    Query,
+    Framebuffer,
+    Renderbuffer,
+    Count
+};
+
+/**
+ * Records creation and destruction of OpenGL objects. All glGen* / glDelete* calls for
+ * vertex arrays, buffers, textures, queries, framebuffers and renderbuffers go through here, so that live object counts are always known
+ * and the render loop can verify that a frame does not leave any new objects behind.
+ */
+class GpuResourceTracker
+{
+public:
+    /**
+     * Wrappers of glGenVertexArrays / glDeleteVertexArrays recording the change.
+     */
+    static void genVertexArrays(GLsizei count, GLuint* ids);
+    static void deleteVertexArrays(GLsizei count, const GLuint* ids);
+
+    /**
+     * Wrappers of glGenBuffers / glDeleteBuffers recording the change.
+     */
+    static void genBuffers(GLsizei count, GLuint* ids);
+    static void deleteBuffers(GLsizei count, const GLuint* ids);
+
+    /**
+     * Wrappers of glGenTextures / glDeleteTextures recording the change.
+     */
+    static void genTextures(GLsizei count, GLuint* ids);
+    static void deleteTextures(GLsizei count, const GLuint* ids);
+
+    /**
+     * Wrappers of glGenQueries / glDeleteQueries recording the change.
+     */
+    static void genQueries(GLsizei count, GLuint* ids);
+    static void deleteQueries(GLsizei count, const GLuint* ids);
+
+    /**
+     * Wrappers of glGenFramebuffers / glDeleteFramebuffers and glGenRenderbuffers / glDeleteRenderbuffers recording the change.
+     */
+    static void genFramebuffers(GLsizei count, GLuint* ids);
+    static void deleteFramebuffers(GLsizei count, const GLuint* ids);
+    static void genRenderbuffers(GLsizei count, GLuint* ids);
+    static void deleteRenderbuffers(GLsizei count, const GLuint* ids);
+
+    /**
+     * Gets number of objects of given type that are currently alive.
+     */
+    static long long getLiveCount(GpuResourceType type);
+
+    /**
+     * Gets number of objects of given type created since the start of the program.
+     */
+    static long long getCreatedCount(GpuResourceType type);
+
+    /**
+     * Marks start of a frame - remembers current live object counts.
+     */
+    static void beginFrame();
+
+    /**
+     * Marks end of a frame and checks, that no object count has grown since beginFrame.
+     * Growth is reported to the error output and asserted in debug builds.
+     *
+     * @return True, if the frame did not leave any new objects behind.
+     */
+    static bool endFrame();
+
+    /**
+     * Prints live object counts of all types.
+     */
+    static void printLiveCounts(std::ostream& os);
+
+private:
+    static void recordCreated(GpuResourceType type, GLsizei count, const GLuint* ids);
+    static void recordDeleted(GpuResourceType type, GLsizei count, const GLuint* ids);
+};
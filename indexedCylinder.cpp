@@ -0,0 +1,150 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code builds the indexed cylinder mesh - shared vertices, zigzag strips and primitive restart
+
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+// Project
+#include "indexedCylinder.h"
+#include "glStateCache.h"
+#include "gpuResourceTracker.h"
+
+namespace static_meshes_3D {
+
+	IndexedCylinder::IndexedCylinder(float radius, int numSlices, float height, bool withPositions, bool withTextureCoordinates, bool withNormals,
+		VertexLayout vertexLayout, MeshInitialization initialization)
+		: StaticMeshIndexed3D(withPositions, withTextureCoordinates, withNormals, vertexLayout)
+		, _radius(radius)
+		, _numSlices(numSlices)
+		, _height(height)
+	{
+		if (initialization == MeshInitialization::Immediate) {
+			initializeData();
+		}
+	}
+
+	float IndexedCylinder::getRadius() const
+	{
+		return _radius;
+	}
+
+	int IndexedCylinder::getSlices() const
+	{
+		return _numSlices;
+	}
+
+	float IndexedCylinder::getHeight() const
+	{
+		return _height;
+	}
+
+	void IndexedCylinder::generateData()
+	{
+		if (_isInitialized || _vertexData != nullptr) {
+			return;
+		}
+
+		// Texture coordinates need the seam column twice (U goes from 0 to 2 there), without them the side wraps around.
+		// Covers need their own rim vertices only when texture coordinates or normals differ from the side ones.
+		const auto numSideColumns = hasTextureCoordinates() ? _numSlices + 1 : _numSlices;
+		const auto hasOwnCovers = hasTextureCoordinates() || hasNormals();
+		const auto numVerticesSide = numSideColumns * 2;
+		_numVertices = numVerticesSide + (hasOwnCovers ? _numSlices * 2 : 0);
+		beginVertices(_numVertices);
+
+		// Pre-calculate sines / cosines for given number of slices
+		const auto sliceAngleStep = 2.0f * glm::pi<float>() / float(_numSlices);
+		std::vector<float> sines, cosines;
+		for (auto i = 0; i <= _numSlices; i++)
+		{
+			sines.push_back(sin(sliceAngleStep * i));
+			cosines.push_back(cos(sliceAngleStep * i));
+		}
+
+		// Side vertices, top and bottom vertex of every column go one after another
+		// I have decided to map the texture twice around cylinder, looks fine
+		const auto halfHeight = _height / 2.0f;
+		const auto sliceTextureStepU = 2.0f / float(_numSlices);
+		auto vertexIndex = 0;
+		for (auto i = 0; i < numSideColumns; i++)
+		{
+			const auto normal = glm::vec3(cosines[i], 0.0f, sines[i]);
+			const auto texCoordU = sliceTextureStepU * float(i);
+			writeVertex(vertexIndex++, glm::vec3(cosines[i] * _radius, halfHeight, sines[i] * _radius), glm::vec2(texCoordU, 1.0f), normal);
+			writeVertex(vertexIndex++, glm::vec3(cosines[i] * _radius, -halfHeight, sines[i] * _radius), glm::vec2(texCoordU, 0.0f), normal);
+		}
+
+		// Rim vertices of the covers, bottom one has Z mirrored just like the non-indexed cylinder
+		auto topRimStart = 0, topRimStep = 2;
+		auto bottomRimStart = 1, bottomRimStep = 2;
+		if (hasOwnCovers)
+		{
+			const glm::vec2 topBottomCenterTexCoord(0.5f, 0.5f);
+			topRimStart = vertexIndex;
+			for (auto i = 0; i < _numSlices; i++)
+			{
+				const auto texCoord = glm::vec2(topBottomCenterTexCoord.x + sines[i] * 0.5f, topBottomCenterTexCoord.y + cosines[i] * 0.5f);
+				writeVertex(vertexIndex++, glm::vec3(cosines[i] * _radius, halfHeight, sines[i] * _radius), texCoord, glm::vec3(0.0f, 1.0f, 0.0f));
+			}
+
+			bottomRimStart = vertexIndex;
+			for (auto i = 0; i < _numSlices; i++)
+			{
+				const auto texCoord = glm::vec2(topBottomCenterTexCoord.x + sines[i] * 0.5f, topBottomCenterTexCoord.y - cosines[i] * 0.5f);
+				writeVertex(vertexIndex++, glm::vec3(cosines[i] * _radius, -halfHeight, -sines[i] * _radius), texCoord, glm::vec3(0.0f, -1.0f, 0.0f));
+			}
+			topRimStep = bottomRimStep = 1;
+		}
+
+		// Side strip, wrapping back to the first column when the seam is not duplicated
+		const auto restartIndex = getRestartIndex(_numVertices);
+		auto& indices = _generatedIndices;
+		indices.clear();
+		indices.reserve(numVerticesSide + 2 + _numSlices * 2 + 2);
+		for (auto i = 0; i <= _numSlices; i++)
+		{
+			const auto column = hasTextureCoordinates() ? i : i % _numSlices;
+			indices.push_back(column * 2);
+			indices.push_back(column * 2 + 1);
+		}
+
+		// Covers as zigzag strips over the rim - 0, 1, n-1, 2, n-2... keeps the winding of a fan around the center.
+		// Shared bottom rim goes the other way round, because its Z is not mirrored.
+		const auto addCoverStrip = [&](int rimStart, int rimStep, bool isReversed) {
+			indices.push_back(restartIndex);
+			for (auto i = 0; i < _numSlices; i++)
+			{
+				const auto zigzag = i % 2 == 1 ? (i + 1) / 2 : (_numSlices - i / 2) % _numSlices;
+				const auto slice = isReversed ? (_numSlices - zigzag) % _numSlices : zigzag;
+				indices.push_back(rimStart + slice * rimStep);
+			}
+		};
+		addCoverStrip(topRimStart, topRimStep, false);
+		addCoverStrip(bottomRimStart, bottomRimStep, !hasOwnCovers);
+
+	}
+
+	void IndexedCylinder::uploadData()
+	{
+		if (_isInitialized || _vertexData == nullptr) {
+			return;
+		}
+
+		// Generate VAO and VBO for vertex attributes and finally upload data to the GPU
+		GpuResourceTracker::genVertexArrays(1, &_vao);
+		GLStateCache::bindVertexArray(_vao);
+		uploadVertices();
+		setVertexAttributesPointers(_numVertices);
+		uploadIndices(_generatedIndices, GL_TRIANGLE_STRIP);
+
+		std::vector<GLuint>().swap(_generatedIndices);
+		_vertexData = nullptr;
+		_isInitialized = true;
+	}
+
+} // namespace static_meshes_3D
@@ -0,0 +1,49 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this class builds the cylinder from shared vertices and renders all of its parts with a single indexed draw call
+
+#pragma once
+#include "staticMeshIndexed3D.h"
+
+namespace static_meshes_3D {
+
+	/**
+	* Cylinder static mesh with given radius, number of slices and height, rendered with one indexed draw.
+	* Side and both covers are triangle strips joined with primitive restart. Covers are triangulated
+	* as zigzag strips over the rim, so they need no center vertex, and vertices are shared wherever
+	* their attributes match (without texture coordinates and normals the covers reuse the side vertices).
+	*/
+	class IndexedCylinder : public StaticMeshIndexed3D
+	{
+	public:
+		IndexedCylinder(float radius, int numSlices, float height,
+			bool withPositions = true, bool withTextureCoordinates = true, bool withNormals = true,
+			VertexLayout vertexLayout = VertexLayout::Interleaved, MeshInitialization initialization = MeshInitialization::Immediate);
+
+		void generateData() override;
+		void uploadData() override;
+
+		/**
+		 * Gets cylinder radius.
+		 */
+		float getRadius() const;
+
+		/**
+		 * Gets number of cylinder slices.
+		 */
+		int getSlices() const;
+
+		/**
+		 * Gets cylinder height.
+		 */
+		float getHeight() const;
+
+	private:
+		float _radius; // Cylinder radius (distance from the center of cylinder to surface)
+		int _numSlices; // Number of cylinder slices
+		float _height; // Height of the cylinder
+
+	};
+
+} // namespace static_meshes_3D
@@ -0,0 +1,100 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code uploads per-instance model matrices used by instanced rendering of static meshes
+#include <iostream>
+
+// Project
+#include "instanceBuffer.h"
+
+namespace static_meshes_3D {
+
+	const int InstanceBuffer::MODEL_MATRIX_ATTRIBUTE_INDEX = 3;
+	const int InstanceBuffer::MATERIAL_LAYER_ATTRIBUTE_INDEX = 7;
+
+	InstanceBuffer::~InstanceBuffer()
+	{
+		deleteBuffer();
+	}
+
+	void InstanceBuffer::setModelMatrices(const std::vector<glm::mat4>& modelMatrices, GLenum usageHint)
+	{
+		setInstances(modelMatrices, std::vector<GLuint>(modelMatrices.size(), 0), usageHint);
+	}
+
+	void InstanceBuffer::setInstances(const std::vector<glm::mat4>& modelMatrices, const std::vector<GLuint>& materialLayers, GLenum usageHint)
+	{
+		if (materialLayers.size() != modelMatrices.size())
+		{
+			std::cerr << "Instance buffer got " << modelMatrices.size() << " model matrices but " << materialLayers.size() << " material layers!" << std::endl;
+			return;
+		}
+
+		const auto dataSizeBytes = sizeof(InstanceData) * modelMatrices.size();
+		if (_vbo.getBufferID() == 0) {
+			_vbo.createVBO(dataSizeBytes);
+		}
+
+		auto* instances = static_cast<InstanceData*>(_vbo.appendRawData(dataSizeBytes));
+		for (size_t i = 0; i < modelMatrices.size(); i++)
+		{
+			instances[i].modelMatrix = modelMatrices[i];
+			instances[i].materialLayer = materialLayers[i];
+		}
+		_vbo.bindVBO();
+		_vbo.uploadDataToGPU(usageHint);
+		_numInstances = static_cast<GLsizei>(modelMatrices.size());
+		_streamBufferID = 0;
+		_streamOffset = 0;
+	}
+
+	bool InstanceBuffer::streamInstances(StreamingBuffer& stream, const std::vector<glm::mat4>& modelMatrices, const std::vector<GLuint>& materialLayers)
+	{
+		if (materialLayers.size() != modelMatrices.size())
+		{
+			std::cerr << "Instance buffer got " << modelMatrices.size() << " model matrices but " << materialLayers.size() << " material layers!" << std::endl;
+			return false;
+		}
+
+		// Attribute offsets must be multiples of 4 bytes, InstanceData alignment covers that
+		const auto allocation = stream.allocate(sizeof(InstanceData) * modelMatrices.size(), alignof(InstanceData));
+		if (!allocation.isValid()) {
+			return false;
+		}
+
+		auto* instances = static_cast<InstanceData*>(allocation.data);
+		for (size_t i = 0; i < modelMatrices.size(); i++)
+		{
+			instances[i].modelMatrix = modelMatrices[i];
+			instances[i].materialLayer = materialLayers[i];
+		}
+		_numInstances = static_cast<GLsizei>(modelMatrices.size());
+		_streamBufferID = stream.getBufferID();
+		_streamOffset = allocation.offset;
+		return true;
+	}
+
+	GLsizei InstanceBuffer::getInstanceCount() const
+	{
+		return _numInstances;
+	}
+
+	GLuint InstanceBuffer::getBufferID() const
+	{
+		return _streamBufferID != 0 ? _streamBufferID : _vbo.getBufferID();
+	}
+
+	GLintptr InstanceBuffer::getBufferOffset() const
+	{
+		return _streamOffset;
+	}
+
+	void InstanceBuffer::deleteBuffer()
+	{
+		_vbo.deleteVBO();
+		_numInstances = 0;
+		_streamBufferID = 0;
+		_streamOffset = 0;
+	}
+
+} // namespace static_meshes_3D
@@ -0,0 +1,97 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code holds per-instance model matrices on the GPU so many copies of one mesh can be drawn with a single call
+
+#pragma once
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Project
+#include "vertexBufferObject.h"
+#include "streamingBuffer.h"
+
+namespace static_meshes_3D {
+
+	/**
+	 * Per-instance data as it lies in the buffer.
+	 */
+	struct InstanceData
+	{
+		glm::mat4 modelMatrix;
+		GLuint materialLayer; // Layer of the MaterialArray the instance samples
+	};
+
+	/**
+	 * Buffer of per-instance model matrices and material layers, consumed as a mat4 and an uint vertex attribute with divisor 1.
+	 */
+	class InstanceBuffer
+	{
+	public:
+		static const int MODEL_MATRIX_ATTRIBUTE_INDEX; // First vertex attribute index of instance model matrix (3, occupies 3 - 6)
+		static const int MATERIAL_LAYER_ATTRIBUTE_INDEX; // Vertex attribute index of instance material layer (7)
+
+		InstanceBuffer() = default;
+		InstanceBuffer(const InstanceBuffer&) = delete;
+		InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+		~InstanceBuffer();
+
+		/**
+		 * Uploads model matrices of all instances, replacing previous ones. All instances use material layer 0.
+		 *
+		 * @param modelMatrices  One model matrix per instance
+		 * @param usageHint      Hint for OpenGL, how is the data intended to be used (GL_STATIC_DRAW, GL_DYNAMIC_DRAW)
+		 */
+		void setModelMatrices(const std::vector<glm::mat4>& modelMatrices, GLenum usageHint = GL_STATIC_DRAW);
+
+		/**
+		 * Uploads model matrices and material layers of all instances, replacing previous ones.
+		 *
+		 * @param modelMatrices   One model matrix per instance
+		 * @param materialLayers  One material layer per instance
+		 * @param usageHint       Hint for OpenGL, how is the data intended to be used (GL_STATIC_DRAW, GL_DYNAMIC_DRAW)
+		 */
+		void setInstances(const std::vector<glm::mat4>& modelMatrices, const std::vector<GLuint>& materialLayers, GLenum usageHint = GL_STATIC_DRAW);
+
+		/**
+		 * Writes model matrices and material layers of all instances to the region of this frame of a streaming
+		 * buffer, instead of our own buffer. Must be repeated every frame the instances are drawn.
+		 *
+		 * @param stream          Streaming buffer between its beginFrame and finishWrites
+		 * @param modelMatrices   One model matrix per instance
+		 * @param materialLayers  One material layer per instance
+		 *
+		 * @return True, if the instances fit into the stream, otherwise the previous instances stay.
+		 */
+		bool streamInstances(StreamingBuffer& stream, const std::vector<glm::mat4>& modelMatrices, const std::vector<GLuint>& materialLayers);
+
+		/**
+		 * Gets number of instances currently held in the buffer.
+		 */
+		GLsizei getInstanceCount() const;
+
+		/**
+		 * Gets OpenGL-assigned buffer ID.
+		 */
+		GLuint getBufferID() const;
+
+		/**
+		 * Gets byte offset of the first instance in the buffer (non-zero only for streamed instances).
+		 */
+		GLintptr getBufferOffset() const;
+
+		/**
+		 * Deletes the buffer and frees GPU memory.
+		 */
+		void deleteBuffer();
+
+	private:
+		VertexBufferObject _vbo; // Our VBO wrapper class holding InstanceData of all instances
+		GLsizei _numInstances = 0; // Number of uploaded instances
+		GLuint _streamBufferID = 0; // Streaming buffer holding the instances, 0 when they are in our VBO
+		GLintptr _streamOffset = 0; // Offset of the instances in the streaming buffer
+	};
+
+} // namespace static_meshes_3D
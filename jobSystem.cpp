@@ -0,0 +1,225 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code runs small jobs on a pool of worker threads, idle workers steal jobs queued by the busy ones
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Project
+#include "jobSystem.h"
+
+namespace {
+
+    struct Job
+    {
+        std::function<void()> function;
+        JobCounter* counter = nullptr;
+    };
+
+    /**
+     * Job queue of one worker, the owner works on the back and thieves take from the front.
+     */
+    struct WorkerQueue
+    {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues; // One per worker
+    std::vector<std::thread> workers;
+    std::atomic<int> queuedJobs{ 0 }; // Jobs sitting in queues, workers sleep while this is zero
+    std::atomic<unsigned int> nextQueue{ 0 }; // Round-robin queue for jobs submitted by non-worker threads
+    std::atomic<bool> isRunning{ false };
+    std::mutex sleepMutex;
+    std::condition_variable wakeCondition;
+
+    thread_local int workerIndex = -1; // Queue owned by this thread, -1 for threads outside the pool
+
+    bool popOwnJob(int index, Job& job)
+    {
+        auto& queue = *queues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.jobs.empty()) {
+            return false;
+        }
+
+        job = std::move(queue.jobs.back());
+        queue.jobs.pop_back();
+        queuedJobs--;
+        return true;
+    }
+
+    /**
+     * Takes the oldest job of another queue. With a counter given, only jobs of that counter are taken.
+     */
+    bool stealJob(int thiefIndex, Job& job, const JobCounter* onlyCounter = nullptr)
+    {
+        const auto numQueues = static_cast<int>(queues.size());
+        for (auto offset = 1; offset <= numQueues; offset++)
+        {
+            const auto victim = (std::max(thiefIndex, 0) + offset) % numQueues;
+            auto& queue = *queues[victim];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            const auto found = onlyCounter == nullptr ? queue.jobs.begin()
+                : std::find_if(queue.jobs.begin(), queue.jobs.end(), [onlyCounter](const Job& queued) { return queued.counter == onlyCounter; });
+            if (found == queue.jobs.end()) {
+                continue;
+            }
+
+            job = std::move(*found);
+            queue.jobs.erase(found);
+            queuedJobs--;
+            return true;
+        }
+
+        return false;
+    }
+
+    bool takeJob(Job& job)
+    {
+        return (workerIndex >= 0 && popOwnJob(workerIndex, job)) || stealJob(workerIndex, job);
+    }
+
+    void runJob(Job& job)
+    {
+        job.function();
+        if (job.counter != nullptr) {
+            job.counter->pending--;
+        }
+    }
+
+    void workerLoop(int index)
+    {
+        workerIndex = index;
+        while (true)
+        {
+            Job job;
+            if (takeJob(job))
+            {
+                runJob(job);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wakeCondition.wait(lock, [] { return !isRunning || queuedJobs > 0; });
+            if (!isRunning && queuedJobs == 0) {
+                return;
+            }
+        }
+    }
+
+} // namespace
+
+void JobSystem::init(unsigned int numWorkers)
+{
+    if (isRunning) {
+        return;
+    }
+
+    if (numWorkers == 0) {
+        numWorkers = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    }
+
+    isRunning = true;
+    for (unsigned int i = 0; i < numWorkers; i++) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (unsigned int i = 0; i < numWorkers; i++) {
+        workers.emplace_back(workerLoop, static_cast<int>(i));
+    }
+}
+
+void JobSystem::shutdown()
+{
+    if (!isRunning) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        isRunning = false;
+    }
+    wakeCondition.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    workers.clear();
+    queues.clear();
+}
+
+unsigned int JobSystem::getNumWorkers()
+{
+    return static_cast<unsigned int>(workers.size());
+}
+
+void JobSystem::submit(std::function<void()> job, JobCounter* counter)
+{
+    if (counter != nullptr) {
+        counter->pending++;
+    }
+
+    if (queues.empty())
+    {
+        Job inlineJob{ std::move(job), counter };
+        runJob(inlineJob);
+        return;
+    }
+
+    // Workers push to their own queue, other threads spread jobs over all queues
+    const auto index = workerIndex >= 0 ? static_cast<size_t>(workerIndex) : nextQueue++ % queues.size();
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->jobs.push_back(Job{ std::move(job), counter });
+        queuedJobs++;
+    }
+
+    // Taking the lock makes sure a worker about to sleep sees the new job
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wakeCondition.notify_one();
+}
+
+void JobSystem::wait(JobCounter& counter)
+{
+    // Threads outside the pool (the render thread) help only with the jobs they wait for - picking up
+    // a texture decode or the occlusion job there would stall the frame for as long as that job runs
+    while (counter.pending > 0)
+    {
+        Job job;
+        const auto hasJob = !queues.empty() && (workerIndex >= 0 ? takeJob(job) : stealJob(workerIndex, job, &counter));
+        if (hasJob) {
+            runJob(job);
+        }
+        else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::parallelFor(size_t count, size_t chunkSize, const std::function<void(size_t, size_t)>& body)
+{
+    chunkSize = std::max(chunkSize, size_t(1));
+    if (queues.empty() || count <= chunkSize)
+    {
+        if (count > 0) {
+            body(0, count);
+        }
+        return;
+    }
+
+    JobCounter counter;
+    for (size_t begin = 0; begin < count; begin += chunkSize)
+    {
+        const auto end = std::min(begin + chunkSize, count);
+        submit([&body, begin, end] { body(begin, end); }, &counter);
+    }
+    wait(counter);
+}
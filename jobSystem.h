@@ -0,0 +1,69 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code runs small jobs on a pool of worker threads, idle workers steal jobs queued by the busy ones
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <functional>
+
+/**
+ * Counts unfinished jobs of a group, so the submitter can wait for all of them.
+ */
+struct JobCounter
+{
+    std::atomic<int> pending{ 0 };
+};
+
+/**
+ * Work-stealing job system. Every worker owns a job queue - it takes its newest jobs from the back
+ * and idle workers steal the oldest ones from the front of other queues. A thread waiting for
+ * a counter runs queued jobs instead of blocking, so jobs may submit and wait for other jobs.
+ * Threads outside the pool run only jobs of the counter they wait for.
+ * Jobs must not call OpenGL, the context belongs to the main thread.
+ * Without init (or with zero workers) every job simply runs on the submitting thread.
+ */
+class JobSystem
+{
+public:
+    /**
+     * Starts worker threads.
+     *
+     * @param numWorkers  Number of worker threads, 0 means one less than the number of hardware threads
+     */
+    static void init(unsigned int numWorkers = 0);
+
+    /**
+     * Waits for queued jobs to finish and stops worker threads.
+     */
+    static void shutdown();
+
+    /**
+     * Gets number of worker threads (the main thread helps too while waiting, so one more runs jobs).
+     */
+    static unsigned int getNumWorkers();
+
+    /**
+     * Queues a job.
+     *
+     * @param job      Work to run on some worker
+     * @param counter  Optional counter incremented now and decremented once the job is done
+     */
+    static void submit(std::function<void()> job, JobCounter* counter = nullptr);
+
+    /**
+     * Runs queued jobs on the calling thread until all jobs of the counter are done. Workers run any
+     * queued job meanwhile, other threads only jobs submitted with this counter.
+     */
+    static void wait(JobCounter& counter);
+
+    /**
+     * Splits range [0, count) into chunks, runs body on every chunk in parallel and waits for all of them.
+     *
+     * @param count      Number of items
+     * @param chunkSize  Number of items per job, bigger chunks mean less overhead but worse balancing
+     * @param body       Called with [begin, end) of every chunk
+     */
+    static void parallelFor(size_t count, size_t chunkSize, const std::function<void(size_t, size_t)>& body);
+};
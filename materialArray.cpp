@@ -0,0 +1,184 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code packs same-sized material textures into layers of one texture array, instances pick their layer
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+// Project
+#include "materialArray.h"
+#include "glStateCache.h"
+#include "gpuResourceTracker.h"
+#include "jobSystem.h"
+#include "stb_image.h"
+#include "textureCooker.h"
+#include "textureFile.h"
+
+const GLsizei MaterialArray::DEFAULT_LAYER_SIZE = 512;
+
+namespace {
+
+    const unsigned char MISSING_LAYER_GREY = 128;
+
+} // namespace
+
+MaterialArray::~MaterialArray()
+{
+    deleteArray();
+}
+
+bool MaterialArray::create(const std::vector<std::string>& layerPaths, GLsizei layerSize)
+{
+    if (textureID_ != 0)
+    {
+        std::cerr << "This material array is already created! You need to delete it before re-creating it!" << std::endl;
+        return false;
+    }
+
+    GLint maxLayers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+    for (const auto& path : layerPaths)
+    {
+        if (std::find(layerPaths_.begin(), layerPaths_.end(), path) == layerPaths_.end()) {
+            layerPaths_.push_back(path);
+        }
+    }
+    if (layerPaths_.empty() || static_cast<GLint>(layerPaths_.size()) > maxLayers)
+    {
+        std::cerr << "Material array needs 1 to " << maxLayers << " layers, got " << layerPaths_.size() << "!" << std::endl;
+        layerPaths_.clear();
+        return false;
+    }
+
+    layerSize_ = layerSize;
+    GpuResourceTracker::genTextures(1, &textureID_);
+    GLStateCache::bindTexture(GL_TEXTURE_2D_ARRAY, textureID_);
+    if (!uploadCookedLayers()) {
+        uploadDecodedLayers();
+    }
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    GLStateCache::bindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    return true;
+}
+
+GLuint MaterialArray::getLayer(const std::string& path) const
+{
+    const auto it = std::find(layerPaths_.begin(), layerPaths_.end(), path);
+    return it != layerPaths_.end() ? static_cast<GLuint>(it - layerPaths_.begin()) : 0;
+}
+
+GLsizei MaterialArray::getNumLayers() const
+{
+    return static_cast<GLsizei>(layerPaths_.size());
+}
+
+GLuint MaterialArray::getTextureID() const
+{
+    return textureID_;
+}
+
+void MaterialArray::bind(GLuint textureUnit) const
+{
+    GLStateCache::bindTextureUnit(textureUnit, GL_TEXTURE_2D_ARRAY, textureID_);
+}
+
+void MaterialArray::deleteArray()
+{
+    if (textureID_ == 0) {
+        return;
+    }
+
+    GpuResourceTracker::deleteTextures(1, &textureID_);
+    textureID_ = 0;
+    layerPaths_.clear();
+}
+
+bool MaterialArray::uploadCookedLayers()
+{
+    // All layers share one format and mip chain, so every cooked file must have been cooked the same way
+    std::vector<std::unique_ptr<TextureFile>> files;
+    for (const auto& path : layerPaths_)
+    {
+        std::unique_ptr<TextureFile> file(new TextureFile());
+        if (!file->open(getCookedTexturePath(path)) || !file->isFormatSupported()) {
+            return false;
+        }
+
+        const auto& header = file->getHeader();
+        const auto& first = files.empty() ? header : files[0]->getHeader();
+        if (static_cast<GLsizei>(header.width) != layerSize_ || static_cast<GLsizei>(header.height) != layerSize_
+            || header.format != first.format || header.numLevels != first.numLevels) {
+            return false;
+        }
+        files.push_back(std::move(file));
+    }
+
+    const auto& header = files[0]->getHeader();
+    const auto internalFormat = getTextureInternalFormat(header.format);
+    const auto numLayers = static_cast<GLsizei>(files.size());
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(header.numLevels - 1));
+    for (uint32_t level = 0; level < header.numLevels; level++)
+    {
+        const auto& levelInfo = files[0]->getLevel(level);
+        const auto width = static_cast<GLsizei>(levelInfo.width);
+        const auto height = static_cast<GLsizei>(levelInfo.height);
+        const auto levelBytes = static_cast<GLsizei>(levelInfo.byteSize);
+
+        // Storage of the level first, then every layer straight from its mapped file
+        if (header.format == TextureFileFormat::RGBA8) {
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, level, internalFormat, width, height, numLayers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        }
+        else {
+            glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, internalFormat, width, height, numLayers, 0, levelBytes * numLayers, nullptr);
+        }
+
+        for (GLsizei layer = 0; layer < numLayers; layer++)
+        {
+            const auto* data = files[layer]->getLevelData(level);
+            if (header.format == TextureFileFormat::RGBA8) {
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, data);
+            }
+            else {
+                glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, width, height, 1, internalFormat, levelBytes, data);
+            }
+        }
+    }
+
+    return true;
+}
+
+void MaterialArray::uploadDecodedLayers()
+{
+    const auto layerBytes = static_cast<size_t>(layerSize_) * layerSize_ * 4;
+    std::vector<unsigned char> pixels(layerBytes * layerPaths_.size(), MISSING_LAYER_GREY);
+
+    // Layers are independent, each one is decoded and resized as its own job
+    JobSystem::parallelFor(layerPaths_.size(), 1, [&](size_t first, size_t last) {
+        for (auto layer = first; layer < last; layer++)
+        {
+            int width, height, numComponents;
+            auto* source = stbi_load(layerPaths_[layer].c_str(), &width, &height, &numComponents, 4);
+            if (source == nullptr)
+            {
+                std::cerr << std::string("Texture failed to load at path: ") + layerPaths_[layer] + "\n";
+                continue;
+            }
+
+            const auto resized = TextureCooker::resize(source, width, height, layerSize_, layerSize_);
+            std::memcpy(pixels.data() + layer * layerBytes, resized.data(), layerBytes);
+            stbi_image_free(source);
+        }
+    });
+
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, layerSize_, layerSize_, static_cast<GLsizei>(layerPaths_.size()), 0,
+        GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+}
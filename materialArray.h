@@ -0,0 +1,82 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code packs same-sized material textures into layers of one texture array, instances pick their layer
+
+#pragma once
+#include <string>
+#include <vector>
+
+// GLAD
+#include <glad/glad.h>
+
+/**
+ * Diffuse textures of several materials as layers of one GL_TEXTURE_2D_ARRAY. Meshes sharing geometry
+ * but not textures can then go out in one instanced draw - every instance carries its layer index
+ * (see InstanceBuffer::setInstances) and the shader is compiled with MATERIAL_ARRAY defined.
+ * Layers are square. Images cooked to the layer size (--texcook-size) are uploaded straight from their
+ * .ctex files, otherwise sources are decoded on the job system and resized on the CPU.
+ */
+class MaterialArray
+{
+public:
+    static const GLsizei DEFAULT_LAYER_SIZE; // Width and height of a layer when none is given (512)
+
+    MaterialArray() = default;
+    MaterialArray(const MaterialArray&) = delete;
+    MaterialArray& operator=(const MaterialArray&) = delete;
+    ~MaterialArray();
+
+    /**
+     * Creates the array, one layer per distinct path.
+     *
+     * @param layerPaths  Source images, repeated paths share a layer
+     * @param layerSize   Width and height of every layer
+     *
+     * @return True, if the array was created (images that fail to load leave their layer grey).
+     */
+    bool create(const std::vector<std::string>& layerPaths, GLsizei layerSize = DEFAULT_LAYER_SIZE);
+
+    /**
+     * Gets layer of an image passed to create.
+     *
+     * @return Layer index, 0 for unknown paths.
+     */
+    GLuint getLayer(const std::string& path) const;
+
+    GLsizei getNumLayers() const;
+
+    /**
+     * Gets OpenGL name of the GL_TEXTURE_2D_ARRAY texture.
+     */
+    GLuint getTextureID() const;
+
+    /**
+     * Binds the array to a texture unit.
+     *
+     * @param textureUnit  Unit index (0 for GL_TEXTURE0)
+     */
+    void bind(GLuint textureUnit) const;
+
+    /**
+     * Deletes the texture.
+     */
+    void deleteArray();
+
+private:
+    /**
+     * Fills all layers from cooked files, if every layer has one matching the layer size and format.
+     *
+     * @return True, if the cooked files were used.
+     */
+    bool uploadCookedLayers();
+
+    /**
+     * Fills all layers by decoding and resizing the source images.
+     */
+    void uploadDecodedLayers();
+
+    GLuint textureID_{ 0 };
+    GLsizei layerSize_{ 0 };
+    std::vector<std::string> layerPaths_; // Distinct paths, index is the layer
+};
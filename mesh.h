@@ -12,6 +12,8 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "shader.h"
+#include "glStateCache.h"
+#include "gpuResourceTracker.h"
 
 #include <string>
 #include <vector>
@@ -65,7 +67,6 @@ public:
 		unsigned int heightNr = 1;
 		for (unsigned int i = 0; i < textures.size(); i++)
 		{
-			glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
 			// retrieve texture number (the N in diffuse_textureN)
 			string number;
 			string name = textures[i].type;
@@ -79,18 +80,18 @@ public:
 				number = std::to_string(heightNr++); // transfer unsigned int to stream
 
 			// now set the sampler to the correct texture unit
-			glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
-			// and finally bind the texture
-			glBindTexture(GL_TEXTURE_2D, textures[i].id);
+			shader.setInt(name + number, i);
+			// and finally bind the texture, the cache switches the active unit only if it is not bound there yet
+			GLStateCache::bindTextureUnit(i, GL_TEXTURE_2D, textures[i].id);
 		}
 
 		// draw mesh
-		glBindVertexArray(VAO);
+		// VAO stays bound, so drawing this mesh again does not have to rebind it
+		GLStateCache::bindVertexArray(VAO);
 		glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-		glBindVertexArray(0);
 
 		// always good practice to set everything back to defaults once configured.
-		glActiveTexture(GL_TEXTURE0);
+		GLStateCache::activeTexture(GL_TEXTURE0);
 	}
 
 private:
@@ -101,11 +102,11 @@ private:
 	void setupMesh()
 	{
 		// create buffers/arrays
-		glGenVertexArrays(1, &VAO);
-		glGenBuffers(1, &VBO);
-		glGenBuffers(1, &EBO);
+		GpuResourceTracker::genVertexArrays(1, &VAO);
+		GpuResourceTracker::genBuffers(1, &VBO);
+		GpuResourceTracker::genBuffers(1, &EBO);
 
-		glBindVertexArray(VAO);
+		GLStateCache::bindVertexArray(VAO);
 		// load data into vertex buffers
 		glBindBuffer(GL_ARRAY_BUFFER, VBO);
 		// A great thing about structs is that their memory layout is sequential for all its items.
@@ -133,7 +134,7 @@ private:
 		glEnableVertexAttribArray(4);
 		glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
 
-		glBindVertexArray(0);
+		GLStateCache::bindVertexArray(0);
 	}
 };
 #endif
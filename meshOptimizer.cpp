@@ -0,0 +1,284 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code reorders shape indices and vertices so the GPU runs the vertex shader fewer times and fetches vertices in order
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+// Project
+#include "meshOptimizer.h"
+
+const int MeshOptimizer::STATS_CACHE_SIZE = 16;
+
+namespace {
+
+    // Parameters of the Forsyth scoring function, values from the original article
+    const int MAX_CACHE_SIZE = 32; // Size of the modelled LRU cache
+    const float CACHE_DECAY_POWER = 1.5f;
+    const float LAST_TRIANGLE_SCORE = 0.75f; // Vertices of the last triangle get fixed score, so the next one does not simply reuse them
+    const float VALENCE_BOOST_SCALE = 2.0f; // Boost of vertices with few triangles left, so they get finished instead of left behind
+    const float VALENCE_BOOST_POWER = 0.5f;
+
+    const uint32_t NO_TRIANGLE = UINT32_MAX;
+
+    float getVertexScore(int cachePosition, uint32_t numRemainingTriangles)
+    {
+        if (numRemainingTriangles == 0) {
+            return -1.0f;
+        }
+
+        auto score = 0.0f;
+        if (cachePosition >= 0)
+        {
+            if (cachePosition < 3) {
+                score = LAST_TRIANGLE_SCORE;
+            }
+            else
+            {
+                const auto scaler = 1.0f / (MAX_CACHE_SIZE - 3);
+                score = std::pow(1.0f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+            }
+        }
+
+        return score + VALENCE_BOOST_SCALE * std::pow(static_cast<float>(numRemainingTriangles), -VALENCE_BOOST_POWER);
+    }
+
+    template<typename Index>
+    VertexCacheStats analyzeVertexCacheImpl(const Index* indices, size_t numIndices, size_t numVertices, int cacheSize)
+    {
+        VertexCacheStats result;
+
+        // FIFO cache - vertex is a hit if it was inserted during the last cacheSize misses, 0 means never inserted
+        std::vector<size_t> insertedAtMiss(numVertices, 0);
+        size_t numReferencedVertices = 0;
+        for (size_t i = 0; i < numIndices; i++)
+        {
+            const auto vertex = indices[i];
+            if (insertedAtMiss[vertex] == 0) {
+                numReferencedVertices++;
+            }
+            else if (result.transformedVertices - insertedAtMiss[vertex] < static_cast<size_t>(cacheSize)) {
+                continue;
+            }
+
+            result.transformedVertices++;
+            insertedAtMiss[vertex] = result.transformedVertices;
+        }
+
+        const auto numTriangles = numIndices / 3;
+        result.acmr = numTriangles > 0 ? static_cast<double>(result.transformedVertices) / numTriangles : 0.0;
+        result.atvr = numReferencedVertices > 0 ? static_cast<double>(result.transformedVertices) / numReferencedVertices : 0.0;
+        return result;
+    }
+
+    template<typename Index>
+    void optimizeVertexCacheImpl(Index* indices, size_t numIndices, size_t numVertices)
+    {
+        const auto numTriangles = numIndices / 3;
+        if (numTriangles == 0) {
+            return;
+        }
+
+        // Triangles of every vertex in one array, vertex v owns range starting at triangleOffsets[v].
+        // Its first numRemainingTriangles[v] entries are triangles not emitted yet.
+        std::vector<uint32_t> triangleOffsets(numVertices + 1, 0);
+        for (size_t i = 0; i < numTriangles * 3; i++) {
+            triangleOffsets[indices[i] + 1]++;
+        }
+        for (size_t v = 0; v < numVertices; v++) {
+            triangleOffsets[v + 1] += triangleOffsets[v];
+        }
+
+        std::vector<uint32_t> numRemainingTriangles(numVertices, 0);
+        std::vector<uint32_t> vertexTriangles(numTriangles * 3);
+        for (size_t i = 0; i < numTriangles * 3; i++)
+        {
+            const auto vertex = indices[i];
+            vertexTriangles[triangleOffsets[vertex] + numRemainingTriangles[vertex]++] = static_cast<uint32_t>(i / 3);
+        }
+
+        std::vector<int> cachePositions(numVertices, -1);
+        std::vector<float> vertexScores(numVertices);
+        for (size_t v = 0; v < numVertices; v++) {
+            vertexScores[v] = getVertexScore(-1, numRemainingTriangles[v]);
+        }
+
+        std::vector<float> triangleScores(numTriangles);
+        auto bestTriangle = NO_TRIANGLE;
+        for (size_t t = 0; t < numTriangles; t++)
+        {
+            triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+            if (bestTriangle == NO_TRIANGLE || triangleScores[t] > triangleScores[bestTriangle]) {
+                bestTriangle = static_cast<uint32_t>(t);
+            }
+        }
+
+        std::vector<bool> isEmitted(numTriangles, false);
+        std::vector<Index> output;
+        output.reserve(numTriangles * 3);
+        std::vector<uint32_t> cache, newCache;
+        cache.reserve(MAX_CACHE_SIZE + 3);
+        newCache.reserve(MAX_CACHE_SIZE + 3);
+        size_t deadEndCursor = 0; // Triangles before this one are all emitted
+
+        while (output.size() < numTriangles * 3)
+        {
+            // Nothing left around the cache - continue with the first triangle not emitted yet
+            if (bestTriangle == NO_TRIANGLE)
+            {
+                while (isEmitted[deadEndCursor]) {
+                    deadEndCursor++;
+                }
+                bestTriangle = static_cast<uint32_t>(deadEndCursor);
+            }
+
+            const Index triangle[3] = { indices[bestTriangle * 3], indices[bestTriangle * 3 + 1], indices[bestTriangle * 3 + 2] };
+            isEmitted[bestTriangle] = true;
+            output.insert(output.end(), triangle, triangle + 3);
+
+            // Take emitted triangle out of triangle lists of its vertices
+            for (const auto vertex : triangle)
+            {
+                const auto first = vertexTriangles.begin() + triangleOffsets[vertex];
+                const auto last = first + numRemainingTriangles[vertex];
+                std::iter_swap(std::find(first, last, bestTriangle), last - 1);
+                numRemainingTriangles[vertex]--;
+            }
+
+            // LRU cache - vertices of the emitted triangle move to the front
+            newCache.assign(triangle, triangle + 3);
+            for (const auto vertex : cache)
+            {
+                if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2]) {
+                    newCache.push_back(vertex);
+                }
+            }
+
+            // Rescore every vertex whose cache position changed (including the ones that fell out) and its triangles
+            for (size_t i = 0; i < newCache.size(); i++)
+            {
+                const auto vertex = newCache[i];
+                cachePositions[vertex] = i < MAX_CACHE_SIZE ? static_cast<int>(i) : -1;
+
+                const auto score = getVertexScore(cachePositions[vertex], numRemainingTriangles[vertex]);
+                const auto scoreDelta = score - vertexScores[vertex];
+                vertexScores[vertex] = score;
+                for (auto j = triangleOffsets[vertex]; j < triangleOffsets[vertex] + numRemainingTriangles[vertex]; j++) {
+                    triangleScores[vertexTriangles[j]] += scoreDelta;
+                }
+            }
+            if (newCache.size() > MAX_CACHE_SIZE) {
+                newCache.resize(MAX_CACHE_SIZE);
+            }
+            cache.swap(newCache);
+
+            // Next triangle is the best one touching the cache
+            bestTriangle = NO_TRIANGLE;
+            for (const auto vertex : cache)
+            {
+                for (auto j = triangleOffsets[vertex]; j < triangleOffsets[vertex] + numRemainingTriangles[vertex]; j++)
+                {
+                    const auto candidate = vertexTriangles[j];
+                    if (bestTriangle == NO_TRIANGLE || triangleScores[candidate] > triangleScores[bestTriangle]) {
+                        bestTriangle = candidate;
+                    }
+                }
+            }
+        }
+
+        std::copy(output.begin(), output.end(), indices);
+    }
+
+    template<typename Index>
+    void optimizeVertexFetchImpl(Vertex* vertices, size_t numVertices, Index* indices, size_t numIndices)
+    {
+        const auto UNUSED = UINT32_MAX;
+        std::vector<uint32_t> remap(numVertices, UNUSED);
+        uint32_t nextVertex = 0;
+        for (size_t i = 0; i < numIndices; i++)
+        {
+            auto& newIndex = remap[indices[i]];
+            if (newIndex == UNUSED) {
+                newIndex = nextVertex++;
+            }
+            indices[i] = static_cast<Index>(newIndex);
+        }
+
+        // Unreferenced vertices keep their order behind the referenced ones
+        for (auto& newIndex : remap)
+        {
+            if (newIndex == UNUSED) {
+                newIndex = nextVertex++;
+            }
+        }
+
+        std::vector<Vertex> reordered(numVertices);
+        for (size_t v = 0; v < numVertices; v++) {
+            reordered[remap[v]] = vertices[v];
+        }
+        std::copy(reordered.begin(), reordered.end(), vertices);
+    }
+
+} // namespace
+
+VertexCacheStats MeshOptimizer::analyzeVertexCache(const GLushort* indices, size_t numIndices, size_t numVertices, int cacheSize)
+{
+    return analyzeVertexCacheImpl(indices, numIndices, numVertices, cacheSize);
+}
+
+VertexCacheStats MeshOptimizer::analyzeVertexCache(const GLuint* indices, size_t numIndices, size_t numVertices, int cacheSize)
+{
+    return analyzeVertexCacheImpl(indices, numIndices, numVertices, cacheSize);
+}
+
+void MeshOptimizer::optimizeVertexCache(GLushort* indices, size_t numIndices, size_t numVertices)
+{
+    optimizeVertexCacheImpl(indices, numIndices, numVertices);
+}
+
+void MeshOptimizer::optimizeVertexCache(GLuint* indices, size_t numIndices, size_t numVertices)
+{
+    optimizeVertexCacheImpl(indices, numIndices, numVertices);
+}
+
+void MeshOptimizer::optimizeVertexFetch(Vertex* vertices, size_t numVertices, GLushort* indices, size_t numIndices)
+{
+    optimizeVertexFetchImpl(vertices, numVertices, indices, numIndices);
+}
+
+void MeshOptimizer::optimizeVertexFetch(Vertex* vertices, size_t numVertices, GLuint* indices, size_t numIndices)
+{
+    optimizeVertexFetchImpl(vertices, numVertices, indices, numIndices);
+}
+
+void MeshOptimizer::optimize(ShapeData& shape, const char* name)
+{
+    VertexCacheStats before, after;
+    if (shape.indexType == GL_UNSIGNED_SHORT)
+    {
+        before = analyzeVertexCache(shape.shortIndices.data(), shape.shortIndices.size(), shape.vertices.size());
+        optimizeVertexCache(shape.shortIndices.data(), shape.shortIndices.size(), shape.vertices.size());
+        optimizeVertexFetch(shape.vertices.data(), shape.vertices.size(), shape.shortIndices.data(), shape.shortIndices.size());
+        after = analyzeVertexCache(shape.shortIndices.data(), shape.shortIndices.size(), shape.vertices.size());
+    }
+    else
+    {
+        before = analyzeVertexCache(shape.intIndices.data(), shape.intIndices.size(), shape.vertices.size());
+        optimizeVertexCache(shape.intIndices.data(), shape.intIndices.size(), shape.vertices.size());
+        optimizeVertexFetch(shape.vertices.data(), shape.vertices.size(), shape.intIndices.data(), shape.intIndices.size());
+        after = analyzeVertexCache(shape.intIndices.data(), shape.intIndices.size(), shape.vertices.size());
+    }
+
+    // Whole line goes out at once, shapes may be optimized on several job system threads
+    std::ostringstream report;
+    report << std::fixed << std::setprecision(3) << "Optimized " << name << " (" << shape.numVertices() << " vertices, "
+        << shape.numIndices() / 3 << " triangles): ACMR " << before.acmr << " -> " << after.acmr
+        << ", ATVR " << before.atvr << " -> " << after.atvr << "\n";
+    std::cout << report.str() << std::flush;
+}
@@ -0,0 +1,67 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code reorders shape indices and vertices so the GPU runs the vertex shader fewer times and fetches vertices in order
+
+#pragma once
+#include <cstddef>
+
+// GLAD
+#include <glad/glad.h>
+
+// Project
+#include "ShapeData.h"
+
+/**
+ * Post-transform vertex cache efficiency of an index buffer, measured on a FIFO cache model.
+ */
+struct VertexCacheStats
+{
+    size_t transformedVertices = 0; // Vertex shader invocations (cache misses)
+    double acmr = 0.0; // Average cache miss ratio - invocations per triangle, 3 is the worst, about 0.5 is the best for grids
+    double atvr = 0.0; // Average transformed vertex ratio - invocations per referenced vertex, 1 is the best
+};
+
+/**
+ * Optimizes indexed triangle lists before they are uploaded.
+ * Vertex cache pass reorders triangles with Tom Forsyth's linear-speed algorithm, so triangles
+ * sharing vertices are drawn close together. Vertex fetch pass then renumbers vertices in order
+ * of first use, so the vertex buffer is read front to back.
+ */
+class MeshOptimizer
+{
+public:
+    static const int STATS_CACHE_SIZE; // FIFO cache size used for statistics (16, typical for current GPUs)
+
+    /**
+     * Simulates FIFO post-transform cache over the index buffer.
+     *
+     * @param indices      Triangle list indices
+     * @param numIndices   Number of indices
+     * @param numVertices  Number of vertices the indices point to
+     * @param cacheSize    Number of entries of the simulated cache
+     */
+    static VertexCacheStats analyzeVertexCache(const GLushort* indices, size_t numIndices, size_t numVertices, int cacheSize = STATS_CACHE_SIZE);
+    static VertexCacheStats analyzeVertexCache(const GLuint* indices, size_t numIndices, size_t numVertices, int cacheSize = STATS_CACHE_SIZE);
+
+    /**
+     * Reorders triangles of the triangle list in place for better post-transform cache use.
+     */
+    static void optimizeVertexCache(GLushort* indices, size_t numIndices, size_t numVertices);
+    static void optimizeVertexCache(GLuint* indices, size_t numIndices, size_t numVertices);
+
+    /**
+     * Reorders vertices in order of their first use and rewrites indices to match.
+     * Vertices not referenced by any index are moved to the end.
+     */
+    static void optimizeVertexFetch(Vertex* vertices, size_t numVertices, GLushort* indices, size_t numIndices);
+    static void optimizeVertexFetch(Vertex* vertices, size_t numVertices, GLuint* indices, size_t numIndices);
+
+    /**
+     * Runs both passes over the shape and prints its ACMR / ATVR before and after.
+     *
+     * @param shape  Shape with triangle list indices
+     * @param name   Name of the shape used in the printed report
+     */
+    static void optimize(ShapeData& shape, const char* name);
+};
@@ -0,0 +1,114 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code builds static meshes on first request and hands out handles to the cached instances afterwards
+
+#include <iostream>
+#include <tuple>
+
+// Project
+#include "meshRegistry.h"
+#include "cylinder.h"
+#include "indexedCylinder.h"
+#include "jobSystem.h"
+
+namespace static_meshes_3D {
+
+	MeshRegistry::~MeshRegistry()
+	{
+		clear();
+	}
+
+	MeshHandle MeshRegistry::getCylinder(float radius, int numSlices, float height, bool withPositions, bool withTextureCoordinates, bool withNormals,
+		VertexLayout vertexLayout, MeshInitialization initialization)
+	{
+		const MeshKey key{ MeshShape::Cylinder, radius, numSlices, height, makeAttributeFlags(withPositions, withTextureCoordinates, withNormals), vertexLayout };
+		const auto it = _handlesByKey.find(key);
+		if (it != _handlesByKey.end()) {
+			return it->second;
+		}
+
+		return registerMesh(key, std::make_unique<Cylinder>(radius, numSlices, height, withPositions, withTextureCoordinates, withNormals, vertexLayout, initialization),
+			initialization);
+	}
+
+	MeshHandle MeshRegistry::getIndexedCylinder(float radius, int numSlices, float height, bool withPositions, bool withTextureCoordinates, bool withNormals,
+		VertexLayout vertexLayout, MeshInitialization initialization)
+	{
+		const MeshKey key{ MeshShape::IndexedCylinder, radius, numSlices, height, makeAttributeFlags(withPositions, withTextureCoordinates, withNormals), vertexLayout };
+		const auto it = _handlesByKey.find(key);
+		if (it != _handlesByKey.end()) {
+			return it->second;
+		}
+
+		return registerMesh(key, std::make_unique<IndexedCylinder>(radius, numSlices, height, withPositions, withTextureCoordinates, withNormals, vertexLayout, initialization),
+			initialization);
+	}
+
+	void MeshRegistry::buildPending()
+	{
+		if (_pendingMeshes.empty()) {
+			return;
+		}
+
+		// One job per mesh, generation touches only the mesh's own CPU-side buffers
+		JobSystem::parallelFor(_pendingMeshes.size(), 1, [this](size_t begin, size_t end) {
+			for (auto i = begin; i < end; i++) {
+				_meshes[_pendingMeshes[i]]->generateData();
+			}
+		});
+
+		for (const auto index : _pendingMeshes) {
+			_meshes[index]->uploadData();
+		}
+		_pendingMeshes.clear();
+	}
+
+	StaticMesh3D* MeshRegistry::get(MeshHandle handle) const
+	{
+		if (!handle.isValid() || handle.index >= static_cast<int>(_meshes.size()))
+		{
+			std::cerr << "Mesh handle " << handle.index << " is not valid in this registry!" << std::endl;
+			return nullptr;
+		}
+
+		return _meshes[handle.index].get();
+	}
+
+	size_t MeshRegistry::size() const
+	{
+		return _meshes.size();
+	}
+
+	void MeshRegistry::clear()
+	{
+		// Meshes delete their VAO / VBO in destructor, so this has to happen before the context is gone
+		_meshes.clear();
+		_handlesByKey.clear();
+		_pendingMeshes.clear();
+	}
+
+	bool MeshRegistry::MeshKey::operator<(const MeshKey& other) const
+	{
+		return std::tie(shape, radius, numSlices, height, attributeFlags, vertexLayout)
+			< std::tie(other.shape, other.radius, other.numSlices, other.height, other.attributeFlags, other.vertexLayout);
+	}
+
+	unsigned int MeshRegistry::makeAttributeFlags(bool withPositions, bool withTextureCoordinates, bool withNormals)
+	{
+		return (withPositions ? 1u : 0u) | (withTextureCoordinates ? 2u : 0u) | (withNormals ? 4u : 0u);
+	}
+
+	MeshHandle MeshRegistry::registerMesh(const MeshKey& key, std::unique_ptr<StaticMesh3D> mesh, MeshInitialization initialization)
+	{
+		MeshHandle handle;
+		handle.index = static_cast<int>(_meshes.size());
+		if (initialization == MeshInitialization::Deferred) {
+			_pendingMeshes.push_back(handle.index);
+		}
+		_meshes.push_back(std::move(mesh));
+		_handlesByKey[key] = handle;
+		return handle;
+	}
+
+} // namespace static_meshes_3D
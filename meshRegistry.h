@@ -0,0 +1,128 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code keeps our static meshes alive for the life of the OpenGL context so every shape is only built once
+
+#pragma once
+#include <map>
+#include <memory>
+#include <vector>
+
+// Project
+#include "staticMesh3D.h"
+
+namespace static_meshes_3D {
+
+	/**
+	 * Kinds of static meshes the registry knows how to build.
+	 */
+	enum class MeshShape
+	{
+		Cylinder,
+		IndexedCylinder
+	};
+
+	/**
+	 * Lightweight handle to a mesh owned by the registry. Stays valid until the registry is cleared.
+	 */
+	struct MeshHandle
+	{
+		int index = -1; // Index of the mesh inside the registry, -1 means invalid handle
+
+		bool isValid() const { return index >= 0; }
+	};
+
+	/**
+	 * Owns static meshes for the life of the OpenGL context and hands out handles to them.
+	 * Requesting the same shape with the same parameters twice returns the same handle,
+	 * so geometry is generated and uploaded to the GPU only once.
+	 */
+	class MeshRegistry
+	{
+	public:
+		MeshRegistry() = default;
+		MeshRegistry(const MeshRegistry&) = delete;
+		MeshRegistry& operator=(const MeshRegistry&) = delete;
+		~MeshRegistry();
+
+		/**
+		 * Gets handle to a cylinder with given parameters, building it on first request.
+		 * Deferred meshes are only built by buildPending, so many of them can be generated in parallel.
+		 *
+		 * @param radius          Cylinder radius
+		 * @param numSlices       Number of cylinder slices
+		 * @param height          Height of the cylinder
+		 * @param initialization  Build now, or later in buildPending
+		 */
+		MeshHandle getCylinder(float radius, int numSlices, float height,
+			bool withPositions = true, bool withTextureCoordinates = true, bool withNormals = true,
+			VertexLayout vertexLayout = VertexLayout::Interleaved, MeshInitialization initialization = MeshInitialization::Immediate);
+
+		/**
+		 * Gets handle to an indexed cylinder (single draw call, shared vertices) with given parameters,
+		 * building it on first request (or in buildPending, when deferred).
+		 *
+		 * @param radius          Cylinder radius
+		 * @param numSlices       Number of cylinder slices
+		 * @param height          Height of the cylinder
+		 * @param initialization  Build now, or later in buildPending
+		 */
+		MeshHandle getIndexedCylinder(float radius, int numSlices, float height,
+			bool withPositions = true, bool withTextureCoordinates = true, bool withNormals = true,
+			VertexLayout vertexLayout = VertexLayout::Interleaved, MeshInitialization initialization = MeshInitialization::Immediate);
+
+		/**
+		 * Builds all deferred meshes - vertex data of all of them is generated in parallel on the job system,
+		 * then everything is uploaded on the calling thread, which must own the OpenGL context.
+		 */
+		void buildPending();
+
+		/**
+		 * Gets mesh behind the handle.
+		 *
+		 * @return Pointer to the mesh, or nullptr, if the handle is not valid.
+		 */
+		StaticMesh3D* get(MeshHandle handle) const;
+
+		/**
+		 * Gets number of meshes owned by the registry.
+		 */
+		size_t size() const;
+
+		/**
+		 * Deletes all owned meshes. Must be called while the OpenGL context is still alive.
+		 */
+		void clear();
+
+	private:
+		/**
+		 * Identifies one unique mesh - shape type, its dimensions, present vertex attributes and their layout.
+		 */
+		struct MeshKey
+		{
+			MeshShape shape;
+			float radius;
+			int numSlices;
+			float height;
+			unsigned int attributeFlags;
+			VertexLayout vertexLayout;
+
+			bool operator<(const MeshKey& other) const;
+		};
+
+		std::map<MeshKey, MeshHandle> _handlesByKey; // Lookup of already built meshes
+		std::vector<std::unique_ptr<StaticMesh3D>> _meshes; // Owned meshes, indexed by handle
+		std::vector<int> _pendingMeshes; // Deferred meshes waiting for buildPending
+
+		/**
+		 * Packs present vertex attributes into bit flags used in the mesh key.
+		 */
+		static unsigned int makeAttributeFlags(bool withPositions, bool withTextureCoordinates, bool withNormals);
+
+		/**
+		 * Takes ownership of freshly built mesh and registers it under given key.
+		 */
+		MeshHandle registerMesh(const MeshKey& key, std::unique_ptr<StaticMesh3D> mesh, MeshInitialization initialization);
+	};
+
+} // namespace static_meshes_3D
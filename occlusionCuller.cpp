@@ -0,0 +1,391 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code rasterizes big occluders into a small CPU depth buffer and drops objects hidden behind them before they are drawn
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OCCLUSION_CULLER_SSE
+#include <emmintrin.h>
+#endif
+
+// x64 configurations of the project build with /arch:AVX2, which defines __AVX__ for MSVC
+#if defined(__AVX__)
+#define OCCLUSION_CULLER_AVX
+#include <immintrin.h>
+#endif
+
+// Project
+#include "occlusionCuller.h"
+#include "profiler.h"
+
+const int OcclusionCuller::DEFAULT_WIDTH = 256;
+const int OcclusionCuller::DEFAULT_HEIGHT = 128;
+const int OcclusionCuller::TILE_SIZE = 8;
+const size_t OcclusionCuller::NO_CANDIDATE = ~size_t(0);
+
+namespace {
+
+    // Corner order of a box - bit 0 picks max x, bit 1 max y, bit 2 max z
+    const int NUM_CORNERS = 8;
+
+    // Two counter-clockwise triangles per face, seen from the outside
+    const int BOX_TRIANGLES[12][3] = {
+        { 0, 2, 3 }, { 0, 3, 1 }, // -z
+        { 4, 5, 7 }, { 4, 7, 6 }, // +z
+        { 0, 4, 6 }, { 0, 6, 2 }, // -x
+        { 1, 3, 7 }, { 1, 7, 5 }, // +x
+        { 0, 1, 5 }, { 0, 5, 4 }, // -y
+        { 2, 6, 7 }, { 2, 7, 3 }, // +y
+    };
+
+    glm::vec3 getCorner(const glm::vec3& min, const glm::vec3& max, int index)
+    {
+        return glm::vec3(index & 1 ? max.x : min.x, index & 2 ? max.y : min.y, index & 4 ? max.z : min.z);
+    }
+
+    /**
+     * Checks, if a clip space point is in front of the near plane, where the perspective divide
+     * would flip or blow it up.
+     */
+    bool isBeforeNearPlane(const glm::vec4& clip)
+    {
+        return clip.w <= 0.0f || clip.z < -clip.w;
+    }
+
+    /**
+     * Screen position in pixels and depth in [0, 1] of a clip space point.
+     */
+    glm::vec3 toScreen(const glm::vec4& clip, int width, int height)
+    {
+        const auto ndc = glm::vec3(clip) / clip.w;
+        return glm::vec3((ndc.x * 0.5f + 0.5f) * width, (ndc.y * 0.5f + 0.5f) * height, ndc.z * 0.5f + 0.5f);
+    }
+
+    /**
+     * Edge function A * x + B * y + C, positive on the inner side of edge from -> to of a counter-clockwise triangle.
+     */
+    struct Edge
+    {
+        float a, b, c;
+
+        Edge(const glm::vec3& from, const glm::vec3& to)
+            : a(from.y - to.y)
+            , b(to.x - from.x)
+            , c(-(a * from.x + b * from.y))
+        {
+        }
+    };
+
+} // namespace
+
+OcclusionCuller::~OcclusionCuller()
+{
+    if (isRunning_) {
+        JobSystem::wait(job_);
+    }
+}
+
+void OcclusionCuller::create(int width, int height)
+{
+    width_ = (std::max(width, TILE_SIZE) + TILE_SIZE - 1) / TILE_SIZE * TILE_SIZE;
+    height_ = (std::max(height, TILE_SIZE) + TILE_SIZE - 1) / TILE_SIZE * TILE_SIZE;
+    tilesX_ = width_ / TILE_SIZE;
+    tilesY_ = height_ / TILE_SIZE;
+    depth_.assign(static_cast<size_t>(width_) * height_, 1.0f);
+    tileMaxDepth_.assign(static_cast<size_t>(tilesX_) * tilesY_, 1.0f);
+}
+
+void OcclusionCuller::addOccluder(const BoundingBox& localBox, const glm::mat4& model, size_t candidate)
+{
+    if (localBox.isEmpty()) {
+        return;
+    }
+
+    if (candidate != NO_CANDIDATE) {
+        occluderCandidates_.push_back(candidate);
+    }
+
+    for (auto corner = 0; corner < NUM_CORNERS; corner++) {
+        occluderCorners_.push_back(glm::vec3(model * glm::vec4(getCorner(localBox.min, localBox.max, corner), 1.0f)));
+    }
+}
+
+void OcclusionCuller::clearOccluders()
+{
+    occluderCorners_.clear();
+    occluderCandidates_.clear();
+}
+
+void OcclusionCuller::beginCulling(const glm::mat4& viewProjection, const CullList& candidates, const std::vector<uint8_t>& visibility)
+{
+    if (isRunning_) {
+        JobSystem::wait(job_);
+    }
+
+    viewProjection_ = viewProjection;
+    candidates_ = &candidates;
+    visibility_ = &visibility;
+    isOccluded_.assign(candidates.size(), 0);
+    isRunning_ = true;
+    JobSystem::submit([this] { cull(); }, &job_);
+}
+
+size_t OcclusionCuller::finishCulling(std::vector<uint8_t>& visibility)
+{
+    if (!isRunning_) {
+        return 0;
+    }
+
+    JobSystem::wait(job_);
+    isRunning_ = false;
+
+    size_t numOccluded = 0;
+    const auto count = std::min(visibility.size(), isOccluded_.size());
+    for (size_t i = 0; i < count; i++)
+    {
+        if (isOccluded_[i] && visibility[i])
+        {
+            visibility[i] = 0;
+            numOccluded++;
+        }
+    }
+
+    // The profiler belongs to the main thread, so the job only fills stats
+    Profiler::addCounter("occluder triangles", static_cast<double>(stats_.numOccluderTriangles));
+    Profiler::addCounter("objects occluded", static_cast<double>(numOccluded));
+    return numOccluded;
+}
+
+const OcclusionCuller::Stats& OcclusionCuller::getStats() const
+{
+    return stats_;
+}
+
+void OcclusionCuller::cull()
+{
+    if (depth_.empty()) {
+        create();
+    }
+
+    stats_ = Stats();
+    rasterizeOccluders();
+    buildHierarchy();
+
+    const auto& candidates = *candidates_;
+    const auto& visibility = *visibility_;
+    const auto count = std::min(candidates.size(), visibility.size());
+    std::vector<uint8_t> isOccluder(count, 0);
+    for (const auto candidate : occluderCandidates_)
+    {
+        if (candidate < count) {
+            isOccluder[candidate] = 1;
+        }
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!visibility[i] || isOccluder[i]) {
+            continue;
+        }
+
+        stats_.numTested++;
+        const glm::vec3 center(candidates.boxCenterX_[i], candidates.boxCenterY_[i], candidates.boxCenterZ_[i]);
+        const glm::vec3 extent(candidates.boxExtentX_[i], candidates.boxExtentY_[i], candidates.boxExtentZ_[i]);
+        if (isBoxOccluded(center, extent))
+        {
+            isOccluded_[i] = 1;
+            stats_.numOccluded++;
+        }
+    }
+}
+
+void OcclusionCuller::rasterizeOccluders()
+{
+    std::fill(depth_.begin(), depth_.end(), 1.0f);
+
+    glm::vec4 clip[NUM_CORNERS];
+    for (size_t first = 0; first + NUM_CORNERS <= occluderCorners_.size(); first += NUM_CORNERS)
+    {
+        for (auto corner = 0; corner < NUM_CORNERS; corner++) {
+            clip[corner] = viewProjection_ * glm::vec4(occluderCorners_[first + corner], 1.0f);
+        }
+
+        for (const auto& triangle : BOX_TRIANGLES) {
+            rasterizeTriangle(clip[triangle[0]], clip[triangle[1]], clip[triangle[2]]);
+        }
+    }
+}
+
+void OcclusionCuller::rasterizeTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c)
+{
+    // Without clipping, a triangle reaching in front of the near plane is skipped - it only makes
+    // the occluder smaller, so nothing visible gets culled
+    if (isBeforeNearPlane(a) || isBeforeNearPlane(b) || isBeforeNearPlane(c)) {
+        return;
+    }
+
+    auto v0 = toScreen(a, width_, height_);
+    auto v1 = toScreen(b, width_, height_);
+    auto v2 = toScreen(c, width_, height_);
+    auto area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+    if (area == 0.0f) {
+        return;
+    }
+
+    // Both sides are rasterized, the box is closed and the nearest depth wins anyway
+    if (area < 0.0f)
+    {
+        std::swap(v1, v2);
+        area = -area;
+    }
+
+    const auto minX = std::max(0, static_cast<int>(std::floor(std::min({ v0.x, v1.x, v2.x }))));
+    const auto maxX = std::min(width_ - 1, static_cast<int>(std::ceil(std::max({ v0.x, v1.x, v2.x }))));
+    const auto minY = std::max(0, static_cast<int>(std::floor(std::min({ v0.y, v1.y, v2.y }))));
+    const auto maxY = std::min(height_ - 1, static_cast<int>(std::ceil(std::max({ v0.y, v1.y, v2.y }))));
+    if (minX > maxX || minY > maxY) {
+        return;
+    }
+    stats_.numOccluderTriangles++;
+
+    const Edge edge0(v1, v2), edge1(v2, v0), edge2(v0, v1);
+
+    // Depth after the perspective divide is linear in screen space - a plane through the three vertices
+    const auto depthX = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+    const auto depthY = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) / area;
+    const auto depthC = v0.z - depthX * v0.x - depthY * v0.y;
+
+    // Rows start at a multiple of 8, so SIMD loads stay inside the row (width is a multiple of 8 too)
+    const auto firstX = minX & ~(TILE_SIZE - 1);
+    for (auto y = minY; y <= maxY; y++)
+    {
+        const auto pixelY = y + 0.5f;
+        const auto row0 = edge0.b * pixelY + edge0.c;
+        const auto row1 = edge1.b * pixelY + edge1.c;
+        const auto row2 = edge2.b * pixelY + edge2.c;
+        const auto rowDepth = depthY * pixelY + depthC;
+        auto* depthRow = &depth_[static_cast<size_t>(y) * width_];
+        auto x = firstX;
+
+#ifdef OCCLUSION_CULLER_AVX
+        const auto laneOffsets = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+        for (; x <= maxX; x += 8)
+        {
+            const auto pixelX = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(x)), laneOffsets);
+            const auto e0 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(edge0.a), pixelX), _mm256_set1_ps(row0));
+            const auto e1 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(edge1.a), pixelX), _mm256_set1_ps(row1));
+            const auto e2 = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(edge2.a), pixelX), _mm256_set1_ps(row2));
+            const auto inside = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(e0, _mm256_setzero_ps(), _CMP_GE_OQ),
+                _mm256_cmp_ps(e1, _mm256_setzero_ps(), _CMP_GE_OQ)), _mm256_cmp_ps(e2, _mm256_setzero_ps(), _CMP_GE_OQ));
+            if (_mm256_movemask_ps(inside) == 0) {
+                continue;
+            }
+
+            const auto depth = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(depthX), pixelX), _mm256_set1_ps(rowDepth));
+            const auto previous = _mm256_loadu_ps(depthRow + x);
+            _mm256_storeu_ps(depthRow + x, _mm256_blendv_ps(previous, _mm256_min_ps(previous, depth), inside));
+        }
+#endif
+
+#ifdef OCCLUSION_CULLER_SSE
+        const auto laneOffsets4 = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+        for (; x <= maxX; x += 4)
+        {
+            const auto pixelX = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneOffsets4);
+            const auto e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edge0.a), pixelX), _mm_set1_ps(row0));
+            const auto e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edge1.a), pixelX), _mm_set1_ps(row1));
+            const auto e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edge2.a), pixelX), _mm_set1_ps(row2));
+            const auto inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, _mm_setzero_ps()), _mm_cmpge_ps(e1, _mm_setzero_ps())),
+                _mm_cmpge_ps(e2, _mm_setzero_ps()));
+            if (_mm_movemask_ps(inside) == 0) {
+                continue;
+            }
+
+            const auto depth = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(depthX), pixelX), _mm_set1_ps(rowDepth));
+            const auto previous = _mm_loadu_ps(depthRow + x);
+            const auto nearest = _mm_min_ps(previous, depth);
+            _mm_storeu_ps(depthRow + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, previous)));
+        }
+#endif
+
+        for (; x <= maxX; x++)
+        {
+            const auto pixelX = x + 0.5f;
+            if (edge0.a * pixelX + row0 >= 0.0f && edge1.a * pixelX + row1 >= 0.0f && edge2.a * pixelX + row2 >= 0.0f) {
+                depthRow[x] = std::min(depthRow[x], depthX * pixelX + rowDepth);
+            }
+        }
+    }
+}
+
+void OcclusionCuller::buildHierarchy()
+{
+    for (auto tileY = 0; tileY < tilesY_; tileY++)
+    {
+        for (auto tileX = 0; tileX < tilesX_; tileX++)
+        {
+            auto maxDepth = 0.0f;
+            for (auto y = tileY * TILE_SIZE; y < (tileY + 1) * TILE_SIZE; y++)
+            {
+                const auto* depthRow = &depth_[static_cast<size_t>(y) * width_ + tileX * TILE_SIZE];
+                maxDepth = std::max(maxDepth, *std::max_element(depthRow, depthRow + TILE_SIZE));
+            }
+            tileMaxDepth_[static_cast<size_t>(tileY) * tilesX_ + tileX] = maxDepth;
+        }
+    }
+}
+
+bool OcclusionCuller::isBoxOccluded(const glm::vec3& center, const glm::vec3& extent) const
+{
+    glm::vec3 screenMin(FLT_MAX), screenMax(-FLT_MAX);
+    for (auto corner = 0; corner < NUM_CORNERS; corner++)
+    {
+        const auto clip = viewProjection_ * glm::vec4(getCorner(center - extent, center + extent, corner), 1.0f);
+        if (isBeforeNearPlane(clip)) {
+            return false;
+        }
+
+        const auto screen = toScreen(clip, width_, height_);
+        screenMin = glm::min(screenMin, screen);
+        screenMax = glm::max(screenMax, screen);
+    }
+
+    // Every pixel the rectangle touches must hold a depth nearer than the nearest point of the box
+    const auto minX = std::max(0, static_cast<int>(std::floor(screenMin.x)));
+    const auto maxX = std::min(width_ - 1, static_cast<int>(std::ceil(screenMax.x)) - 1);
+    const auto minY = std::max(0, static_cast<int>(std::floor(screenMin.y)));
+    const auto maxY = std::min(height_ - 1, static_cast<int>(std::ceil(screenMax.y)) - 1);
+    if (minX > maxX || minY > maxY) {
+        return false;
+    }
+
+    const auto nearestDepth = screenMin.z;
+    for (auto tileY = minY / TILE_SIZE; tileY <= maxY / TILE_SIZE; tileY++)
+    {
+        for (auto tileX = minX / TILE_SIZE; tileX <= maxX / TILE_SIZE; tileX++)
+        {
+            if (tileMaxDepth_[static_cast<size_t>(tileY) * tilesX_ + tileX] < nearestDepth) {
+                continue;
+            }
+
+            // Tile is not conclusive, its part covered by the rectangle decides
+            const auto lastY = std::min(maxY, (tileY + 1) * TILE_SIZE - 1);
+            const auto lastX = std::min(maxX, (tileX + 1) * TILE_SIZE - 1);
+            for (auto y = std::max(minY, tileY * TILE_SIZE); y <= lastY; y++)
+            {
+                const auto* depthRow = &depth_[static_cast<size_t>(y) * width_];
+                for (auto x = std::max(minX, tileX * TILE_SIZE); x <= lastX; x++)
+                {
+                    if (depthRow[x] >= nearestDepth) {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,129 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code rasterizes big occluders into a small CPU depth buffer and drops objects hidden behind them before they are drawn
+
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Project
+#include "boundingVolume.h"
+#include "frustumCuller.h"
+#include "jobSystem.h"
+
+/**
+ * Software occlusion culling. Occluders are oriented boxes (a local box of a mesh and its model matrix),
+ * they must lie completely inside the mesh they stand for, so that nothing is hidden by depth the GPU
+ * will not draw. Every frame their triangles are rasterized into a low resolution depth buffer (8 pixels
+ * at a time with AVX, 4 with SSE), tiles of 8x8 pixels keep the farthest depth of their pixels, and the
+ * screen rectangle of every candidate box is tested against the tiles first and against pixels only where
+ * a tile is not conclusive. The work runs as one job on the job system - it starts as soon as the camera
+ * of the frame is known and the main thread picks up the result right before it queues the draws.
+ */
+class OcclusionCuller
+{
+public:
+    static const int DEFAULT_WIDTH; // Depth buffer width in pixels (256)
+    static const int DEFAULT_HEIGHT; // Depth buffer height in pixels (128)
+    static const int TILE_SIZE; // Width and height of a hierarchy tile in pixels (8)
+
+    /**
+     * Work done by the last culling.
+     */
+    struct Stats
+    {
+        size_t numOccluderTriangles = 0; // Triangles rasterized (the ones crossing the near plane are skipped)
+        size_t numTested = 0; // Candidates visible to the frustum culler
+        size_t numOccluded = 0; // Candidates hidden behind occluders
+    };
+
+    OcclusionCuller() = default;
+    OcclusionCuller(const OcclusionCuller&) = delete;
+    OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+    ~OcclusionCuller();
+
+    /**
+     * Allocates the depth buffer.
+     *
+     * @param width   Width in pixels, rounded up to a multiple of TILE_SIZE
+     * @param height  Height in pixels, rounded up to a multiple of TILE_SIZE
+     */
+    void create(int width = DEFAULT_WIDTH, int height = DEFAULT_HEIGHT);
+
+    static const size_t NO_CANDIDATE;
+
+    /**
+     * Adds an occluder. Must not be called while culling runs.
+     *
+     * @param localBox   Box inside the mesh, in its local space
+     * @param model      Model matrix of the mesh, affine (the lit shaders ignore W)
+     * @param candidate  Index of the same mesh in the candidate list, it is never culled - the occluder
+     *                   would hide the mesh behind its own front faces
+     */
+    void addOccluder(const BoundingBox& localBox, const glm::mat4& model, size_t candidate = NO_CANDIDATE);
+
+    void clearOccluders();
+
+    /**
+     * Starts culling on the job system. Candidates and visibility must stay unchanged until finishCulling.
+     *
+     * @param viewProjection  projection * view of the frame
+     * @param candidates      World bounds of objects to test
+     * @param visibility      Frustum culling result, only visible candidates are tested
+     */
+    void beginCulling(const glm::mat4& viewProjection, const CullList& candidates, const std::vector<uint8_t>& visibility);
+
+    /**
+     * Waits for the culling job, clears visibility of occluded candidates and counts the results into the
+     * "occluder triangles" / "objects occluded" profiler counters.
+     *
+     * @return Number of candidates occluded.
+     */
+    size_t finishCulling(std::vector<uint8_t>& visibility);
+
+    const Stats& getStats() const;
+
+private:
+    /**
+     * Body of the culling job.
+     */
+    void cull();
+
+    void rasterizeOccluders();
+
+    /**
+     * Rasterizes one triangle given in clip space, keeping the nearest depth of every pixel.
+     */
+    void rasterizeTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c);
+
+    /**
+     * Fills tile depths with the farthest depth of their pixels.
+     */
+    void buildHierarchy();
+
+    /**
+     * Checks, if a world box lies completely behind the depth buffer.
+     */
+    bool isBoxOccluded(const glm::vec3& center, const glm::vec3& extent) const;
+
+    int width_{ 0 };
+    int height_{ 0 };
+    int tilesX_{ 0 };
+    int tilesY_{ 0 };
+    std::vector<float> depth_; // Row by row, 0 is the near plane and 1 the far one
+    std::vector<float> tileMaxDepth_;
+    std::vector<glm::vec3> occluderCorners_; // 8 world corners per occluder
+    std::vector<size_t> occluderCandidates_;
+
+    glm::mat4 viewProjection_ = glm::mat4(1.0f);
+    const CullList* candidates_{ nullptr };
+    const std::vector<uint8_t>* visibility_{ nullptr };
+    std::vector<uint8_t> isOccluded_; // Written by the job, one per candidate
+    JobCounter job_;
+    bool isRunning_{ false };
+    Stats stats_;
+};
@@ -0,0 +1,107 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code hands out ranges of a fixed size space (elements of a GPU buffer) and merges freed ranges back together
+
+#include <iterator>
+
+// Project
+#include "offsetAllocator.h"
+
+const uint32_t OffsetAllocator::NO_SPACE = ~0u;
+
+void OffsetAllocator::reset(uint32_t capacity)
+{
+    freeByOffset_.clear();
+    freeBySize_.clear();
+    capacity_ = capacity;
+    freeSize_ = 0;
+    if (capacity > 0) {
+        addFreeRange(0, capacity);
+    }
+}
+
+uint32_t OffsetAllocator::allocate(uint32_t size)
+{
+    if (size == 0) {
+        return NO_SPACE;
+    }
+
+    const auto bestFit = freeBySize_.lower_bound(size);
+    if (bestFit == freeBySize_.end()) {
+        return NO_SPACE;
+    }
+
+    // Range is taken from the start of the free range, the rest stays free
+    const auto offset = bestFit->second;
+    const auto rangeSize = bestFit->first;
+    removeFreeRange(freeByOffset_.find(offset));
+    if (rangeSize > size) {
+        addFreeRange(offset + size, rangeSize - size);
+    }
+    return offset;
+}
+
+void OffsetAllocator::free(uint32_t offset, uint32_t size)
+{
+    if (size == 0) {
+        return;
+    }
+
+    // Free neighbours on both sides become one range with the freed one
+    auto next = freeByOffset_.lower_bound(offset);
+    if (next != freeByOffset_.end() && offset + size == next->first)
+    {
+        size += next->second;
+        removeFreeRange(next);
+    }
+
+    next = freeByOffset_.lower_bound(offset);
+    if (next != freeByOffset_.begin())
+    {
+        const auto previous = std::prev(next);
+        if (previous->first + previous->second == offset)
+        {
+            offset = previous->first;
+            size += previous->second;
+            removeFreeRange(previous);
+        }
+    }
+
+    addFreeRange(offset, size);
+}
+
+uint32_t OffsetAllocator::getCapacity() const
+{
+    return capacity_;
+}
+
+uint32_t OffsetAllocator::getFreeSize() const
+{
+    return freeSize_;
+}
+
+uint32_t OffsetAllocator::getLargestFreeRange() const
+{
+    return freeBySize_.empty() ? 0 : freeBySize_.rbegin()->first;
+}
+
+void OffsetAllocator::addFreeRange(uint32_t offset, uint32_t size)
+{
+    freeByOffset_[offset] = size;
+    freeBySize_.emplace(size, offset);
+    freeSize_ += size;
+}
+
+void OffsetAllocator::removeFreeRange(std::map<uint32_t, uint32_t>::iterator range)
+{
+    // Several free ranges may have the same size, the one with this offset is removed
+    auto bySize = freeBySize_.lower_bound(range->second);
+    while (bySize->second != range->first) {
+        ++bySize;
+    }
+
+    freeSize_ -= range->second;
+    freeBySize_.erase(bySize);
+    freeByOffset_.erase(range);
+}
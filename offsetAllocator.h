@@ -0,0 +1,55 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code hands out ranges of a fixed size space (elements of a GPU buffer) and merges freed ranges back together
+
+#pragma once
+#include <cstdint>
+#include <map>
+
+/**
+ * Allocator of ranges inside [0, capacity). It stores no memory, only offsets, so it can manage
+ * anything addressed by offset - here vertices and indices of big GL buffers. Free ranges are kept
+ * by offset (to merge neighbours when a range is freed) and by size (best fit allocation), both
+ * in O(log n) of the number of free ranges.
+ */
+class OffsetAllocator
+{
+public:
+    static const uint32_t NO_SPACE; // Returned by allocate, when no free range is big enough
+
+    /**
+     * Forgets all allocations, the whole capacity becomes one free range.
+     */
+    void reset(uint32_t capacity);
+
+    /**
+     * Allocates a range from the smallest free range that fits it.
+     *
+     * @param size  Number of elements
+     *
+     * @return Offset of the range, NO_SPACE if it does not fit.
+     */
+    uint32_t allocate(uint32_t size);
+
+    /**
+     * Frees a range returned by allocate.
+     *
+     * @param offset  Offset returned by allocate
+     * @param size    Size passed to allocate
+     */
+    void free(uint32_t offset, uint32_t size);
+
+    uint32_t getCapacity() const;
+    uint32_t getFreeSize() const;
+    uint32_t getLargestFreeRange() const;
+
+private:
+    void addFreeRange(uint32_t offset, uint32_t size);
+    void removeFreeRange(std::map<uint32_t, uint32_t>::iterator range);
+
+    std::map<uint32_t, uint32_t> freeByOffset_; // Offset -> size
+    std::multimap<uint32_t, uint32_t> freeBySize_; // Size -> offset
+    uint32_t capacity_{ 0 };
+    uint32_t freeSize_{ 0 };
+};
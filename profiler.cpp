@@ -0,0 +1,513 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code measures named CPU and GPU scopes every frame and reports their percentiles when the program ends
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+// Project
+#include "profiler.h"
+#include "gpuResourceTracker.h"
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    // Trace events beyond this count are dropped, so that long runs do not eat all the memory
+    const size_t MAX_TRACE_EVENTS = 1000000;
+
+    // GPU results are read this many frames after they were issued
+    const int NUM_QUERY_SETS = 2;
+
+    const char* FRAME_SCOPE_NAME = "frame";
+
+    /**
+     * Per-frame totals of one named scope.
+     */
+    struct ScopeData
+    {
+        std::string name;
+        std::vector<float> cpuMs; // One sample per frame, in which the scope was entered
+        std::vector<float> gpuMs;
+        double cpuFrameMs = 0.0; // Sum of the current frame
+        bool usedThisFrame = false;
+    };
+
+    /**
+     * Per-frame values of one named counter.
+     */
+    struct CounterData
+    {
+        std::string name;
+        std::vector<float> values;
+        double frameValue = 0.0;
+    };
+
+    struct OpenScope
+    {
+        int scopeIndex;
+        Clock::time_point start;
+    };
+
+    struct PendingQuery
+    {
+        int scopeIndex;
+        GLuint queryID;
+        double startUs; // CPU time the scope started at, GPU events are placed there in the trace
+    };
+
+    struct TraceEvent
+    {
+        int scopeIndex; // -1 for the whole frame
+        bool isGpu;
+        double startUs;
+        double durationUs;
+    };
+
+    std::vector<ScopeData> scopes;
+    std::unordered_map<const char*, int> scopeByPointer; // Fast lookup, names are string literals
+    std::unordered_map<std::string, int> scopeByName; // Same literal may live at different addresses in different files
+    std::vector<CounterData> counters;
+    std::unordered_map<const char*, int> counterByPointer;
+    std::unordered_map<std::string, int> counterByName;
+
+    std::vector<OpenScope> openScopes;
+    std::vector<float> frameMs;
+    std::vector<TraceEvent> traceEvents;
+    long long droppedTraceEvents = 0;
+
+    Clock::time_point startTime = Clock::now();
+    Clock::time_point frameStartTime;
+    bool isFrameStarted = false;
+    long long frameIndex = 0;
+
+    std::vector<GLuint> queryPool[NUM_QUERY_SETS];
+    std::vector<PendingQuery> pendingQueries[NUM_QUERY_SETS];
+    int openGpuScopeIndex = -1;
+    long long nestedGpuScopes = 0;
+    long long droppedGpuScopes = 0;
+    long long lateGpuResults = 0;
+
+    double toMicroseconds(Clock::time_point time)
+    {
+        return std::chrono::duration<double, std::micro>(time - startTime).count();
+    }
+
+    int findOrAdd(const char* name, std::unordered_map<const char*, int>& byPointer, std::unordered_map<std::string, int>& byName, int nextIndex)
+    {
+        const auto pointerIt = byPointer.find(name);
+        if (pointerIt != byPointer.end()) {
+            return pointerIt->second;
+        }
+
+        const auto nameIt = byName.emplace(name, nextIndex).first;
+        byPointer[name] = nameIt->second;
+        return nameIt->second;
+    }
+
+    int getScopeIndex(const char* name)
+    {
+        const auto index = findOrAdd(name, scopeByPointer, scopeByName, static_cast<int>(scopes.size()));
+        if (index == static_cast<int>(scopes.size()))
+        {
+            scopes.emplace_back();
+            scopes.back().name = name;
+        }
+        return index;
+    }
+
+    void addTraceEvent(int scopeIndex, bool isGpu, double startUs, double durationUs)
+    {
+        if (traceEvents.size() >= MAX_TRACE_EVENTS)
+        {
+            droppedTraceEvents++;
+            return;
+        }
+        traceEvents.push_back({ scopeIndex, isGpu, startUs, durationUs });
+    }
+
+    // Reads finished queries of given set, results that are not ready yet are dropped instead of waited for
+    void collectGpuResults(int querySet)
+    {
+        std::vector<double> frameTotals(scopes.size(), -1.0);
+        for (const auto& pending : pendingQueries[querySet])
+        {
+            GLint isAvailable = GL_FALSE;
+            glGetQueryObjectiv(pending.queryID, GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+            if (!isAvailable)
+            {
+                lateGpuResults++;
+                continue;
+            }
+
+            GLuint64 elapsedNs = 0;
+            glGetQueryObjectui64v(pending.queryID, GL_QUERY_RESULT, &elapsedNs);
+            const auto elapsedMs = elapsedNs / 1.0e6;
+            auto& total = frameTotals[pending.scopeIndex];
+            total = std::max(total, 0.0) + elapsedMs;
+            addTraceEvent(pending.scopeIndex, true, pending.startUs, elapsedMs * 1000.0);
+        }
+        pendingQueries[querySet].clear();
+
+        for (size_t i = 0; i < scopes.size(); i++)
+        {
+            if (frameTotals[i] >= 0.0) {
+                scopes[i].gpuMs.push_back(static_cast<float>(frameTotals[i]));
+            }
+        }
+    }
+
+    ProfileStats computeStats(const std::vector<float>& samples)
+    {
+        ProfileStats stats;
+        if (samples.empty()) {
+            return stats;
+        }
+
+        auto sorted = samples;
+        std::sort(sorted.begin(), sorted.end());
+        const auto percentile = [&sorted](double p) {
+            const auto rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+            return static_cast<double>(sorted[std::max(rank, static_cast<size_t>(1)) - 1]);
+        };
+
+        double sum = 0.0;
+        for (const auto sample : sorted) {
+            sum += sample;
+        }
+
+        stats.count = sorted.size();
+        stats.average = sum / sorted.size();
+        stats.p50 = percentile(50.0);
+        stats.p95 = percentile(95.0);
+        stats.p99 = percentile(99.0);
+        stats.max = sorted.back();
+        return stats;
+    }
+
+    /**
+     * One row of the summary, shared by the console output and the CSV.
+     */
+    struct SummaryRow
+    {
+        std::string name;
+        const char* kind;
+        ProfileStats stats;
+    };
+
+    std::vector<SummaryRow> buildSummary()
+    {
+        std::vector<SummaryRow> rows;
+        rows.push_back({ FRAME_SCOPE_NAME, "frame_ms", computeStats(frameMs) });
+        for (const auto& scope : scopes)
+        {
+            if (!scope.cpuMs.empty()) {
+                rows.push_back({ scope.name, "cpu_ms", computeStats(scope.cpuMs) });
+            }
+            if (!scope.gpuMs.empty()) {
+                rows.push_back({ scope.name, "gpu_ms", computeStats(scope.gpuMs) });
+            }
+        }
+        for (const auto& counter : counters) {
+            rows.push_back({ counter.name, "counter", computeStats(counter.values) });
+        }
+        return rows;
+    }
+
+    std::string escapeJson(const std::string& text)
+    {
+        std::string escaped;
+        for (const auto character : text)
+        {
+            if (character == '"' || character == '\\') {
+                escaped += '\\';
+            }
+            escaped += character;
+        }
+        return escaped;
+    }
+
+} // namespace
+
+void Profiler::init(int maxGpuScopesPerFrame)
+{
+    for (auto set = 0; set < NUM_QUERY_SETS; set++)
+    {
+        if (!queryPool[set].empty())
+        {
+            std::cerr << "Profiler is already initialized!" << std::endl;
+            return;
+        }
+
+        queryPool[set].resize(maxGpuScopesPerFrame);
+        GpuResourceTracker::genQueries(maxGpuScopesPerFrame, queryPool[set].data());
+    }
+}
+
+void Profiler::beginFrame()
+{
+    const auto now = Clock::now();
+    if (isFrameStarted)
+    {
+        const auto durationUs = toMicroseconds(now) - toMicroseconds(frameStartTime);
+        frameMs.push_back(static_cast<float>(durationUs / 1000.0));
+        addTraceEvent(-1, false, toMicroseconds(frameStartTime), durationUs);
+    }
+
+    frameStartTime = now;
+    isFrameStarted = true;
+    frameIndex++;
+
+    // The set we are about to reuse was issued two frames ago, the GPU has had time to finish it
+    collectGpuResults(frameIndex % NUM_QUERY_SETS);
+}
+
+void Profiler::endFrame()
+{
+    if (!openScopes.empty())
+    {
+        std::cerr << "Profiler frame ended with " << openScopes.size() << " scopes still open!" << std::endl;
+        openScopes.clear();
+    }
+
+    for (auto& scope : scopes)
+    {
+        if (scope.usedThisFrame) {
+            scope.cpuMs.push_back(static_cast<float>(scope.cpuFrameMs));
+        }
+        scope.cpuFrameMs = 0.0;
+        scope.usedThisFrame = false;
+    }
+
+    for (auto& counter : counters)
+    {
+        counter.values.push_back(static_cast<float>(counter.frameValue));
+        counter.frameValue = 0.0;
+    }
+}
+
+void Profiler::beginCpuScope(const char* name)
+{
+    openScopes.push_back({ getScopeIndex(name), Clock::now() });
+}
+
+void Profiler::endCpuScope()
+{
+    if (openScopes.empty())
+    {
+        std::cerr << "Profiler scope ended without being started!" << std::endl;
+        return;
+    }
+
+    const auto endTime = Clock::now();
+    const auto& openScope = openScopes.back();
+    const auto startUs = toMicroseconds(openScope.start);
+    const auto durationUs = toMicroseconds(endTime) - startUs;
+
+    auto& scope = scopes[openScope.scopeIndex];
+    scope.cpuFrameMs += durationUs / 1000.0;
+    scope.usedThisFrame = true;
+    addTraceEvent(openScope.scopeIndex, false, startUs, durationUs);
+    openScopes.pop_back();
+}
+
+bool Profiler::beginGpuScope(const char* name)
+{
+    // GL_TIME_ELAPSED queries cannot be nested
+    if (openGpuScopeIndex >= 0)
+    {
+        nestedGpuScopes++;
+        return false;
+    }
+
+    const auto querySet = frameIndex % NUM_QUERY_SETS;
+    auto& pending = pendingQueries[querySet];
+    if (pending.size() >= queryPool[querySet].size())
+    {
+        droppedGpuScopes++;
+        return false;
+    }
+
+    openGpuScopeIndex = getScopeIndex(name);
+    const auto queryID = queryPool[querySet][pending.size()];
+    pending.push_back({ openGpuScopeIndex, queryID, toMicroseconds(Clock::now()) });
+    glBeginQuery(GL_TIME_ELAPSED, queryID);
+    return true;
+}
+
+void Profiler::endGpuScope()
+{
+    if (openGpuScopeIndex < 0) {
+        return;
+    }
+
+    glEndQuery(GL_TIME_ELAPSED);
+    openGpuScopeIndex = -1;
+}
+
+void Profiler::addCounter(const char* name, double value)
+{
+    const auto index = findOrAdd(name, counterByPointer, counterByName, static_cast<int>(counters.size()));
+    if (index == static_cast<int>(counters.size()))
+    {
+        counters.emplace_back();
+        counters.back().name = name;
+    }
+    counters[index].frameValue += value;
+}
+
+void Profiler::countDraw(GLenum mode, GLsizei vertexCount, GLsizei instanceCount)
+{
+    GLsizei trianglesPerInstance = 0;
+    if (mode == GL_TRIANGLES) {
+        trianglesPerInstance = vertexCount / 3;
+    }
+    else if (mode == GL_TRIANGLE_STRIP || mode == GL_TRIANGLE_FAN) {
+        trianglesPerInstance = std::max(vertexCount - 2, 0);
+    }
+
+    countDrawTriangles(trianglesPerInstance, instanceCount);
+}
+
+void Profiler::countDrawTriangles(GLsizei numTriangles, GLsizei instanceCount)
+{
+    addCounter("draw calls", 1.0);
+    addCounter("triangles", static_cast<double>(numTriangles) * instanceCount);
+}
+
+double Profiler::getRecentFrameMs(int numFrames)
+{
+    const auto count = std::min(static_cast<size_t>(std::max(numFrames, 0)), frameMs.size());
+    if (count == 0) {
+        return 0.0;
+    }
+
+    double sum = 0.0;
+    for (auto i = frameMs.size() - count; i < frameMs.size(); i++) {
+        sum += frameMs[i];
+    }
+    return sum / count;
+}
+
+ProfileStats Profiler::getFrameTimeStats()
+{
+    return computeStats(frameMs);
+}
+
+ProfileStats Profiler::getCounterStats(const std::string& name)
+{
+    const auto it = counterByName.find(name);
+    return it != counterByName.end() ? computeStats(counters[it->second].values) : ProfileStats();
+}
+
+void Profiler::printSummary(std::ostream& os)
+{
+    os << "==== Profiler: " << frameMs.size() << " frames ====" << std::endl;
+    os << std::left << std::setw(24) << "name" << std::setw(10) << "kind" << std::right << std::setw(8) << "samples"
+        << std::setw(10) << "avg" << std::setw(10) << "p50" << std::setw(10) << "p95" << std::setw(10) << "p99" << std::setw(10) << "max" << std::endl;
+
+    os << std::fixed << std::setprecision(3);
+    for (const auto& row : buildSummary())
+    {
+        os << std::left << std::setw(24) << row.name << std::setw(10) << row.kind << std::right << std::setw(8) << row.stats.count
+            << std::setw(10) << row.stats.average << std::setw(10) << row.stats.p50 << std::setw(10) << row.stats.p95
+            << std::setw(10) << row.stats.p99 << std::setw(10) << row.stats.max << std::endl;
+    }
+    os << std::defaultfloat;
+
+    if (nestedGpuScopes > 0 || droppedGpuScopes > 0 || lateGpuResults > 0)
+    {
+        os << "GPU scopes ignored: " << nestedGpuScopes << " nested, " << droppedGpuScopes << " over the query pool, "
+            << lateGpuResults << " results not ready in time" << std::endl;
+    }
+}
+
+bool Profiler::writeCsv(const std::string& path)
+{
+    std::ofstream file(path);
+    if (!file.is_open())
+    {
+        std::cerr << "Could not open profiler report " << path << " for writing!" << std::endl;
+        return false;
+    }
+
+    file << "name,kind,samples,avg,p50,p95,p99,max" << std::endl;
+    for (const auto& row : buildSummary())
+    {
+        file << row.name << "," << row.kind << "," << row.stats.count << "," << row.stats.average << "," << row.stats.p50
+            << "," << row.stats.p95 << "," << row.stats.p99 << "," << row.stats.max << std::endl;
+    }
+    return file.good();
+}
+
+bool Profiler::writeChromeTrace(const std::string& path)
+{
+    std::ofstream file(path);
+    if (!file.is_open())
+    {
+        std::cerr << "Could not open profiler trace " << path << " for writing!" << std::endl;
+        return false;
+    }
+
+    // Frames and CPU scopes on one track, GPU scopes (placed at the CPU time they were issued) on another
+    file << "{\"traceEvents\":[" << std::endl;
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}}," << std::endl;
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+    file << std::fixed << std::setprecision(3);
+    for (const auto& event : traceEvents)
+    {
+        const auto& name = event.scopeIndex < 0 ? std::string(FRAME_SCOPE_NAME) : scopes[event.scopeIndex].name;
+        file << "," << std::endl << "{\"name\":\"" << escapeJson(name) << "\",\"cat\":\"" << (event.isGpu ? "gpu" : "cpu")
+            << "\",\"ph\":\"X\",\"ts\":" << event.startUs << ",\"dur\":" << event.durationUs
+            << ",\"pid\":1,\"tid\":" << (event.isGpu ? 2 : 1) << "}";
+    }
+    file << std::endl << "]}" << std::endl;
+
+    if (droppedTraceEvents > 0) {
+        std::cerr << "Profiler trace is missing " << droppedTraceEvents << " events over the limit of " << MAX_TRACE_EVENTS << std::endl;
+    }
+    return file.good();
+}
+
+bool Profiler::writeReport(const std::string& path)
+{
+    const std::string jsonExtension = ".json";
+    const auto isJson = path.size() >= jsonExtension.size()
+        && path.compare(path.size() - jsonExtension.size(), jsonExtension.size(), jsonExtension) == 0;
+    return isJson ? writeChromeTrace(path) : writeCsv(path);
+}
+
+void Profiler::shutdown()
+{
+    if (openGpuScopeIndex >= 0) {
+        endGpuScope();
+    }
+
+    for (auto set = 0; set < NUM_QUERY_SETS; set++)
+    {
+        GpuResourceTracker::deleteQueries(static_cast<GLsizei>(queryPool[set].size()), queryPool[set].data());
+        queryPool[set].clear();
+        pendingQueries[set].clear();
+    }
+}
+
+ProfileScope::ProfileScope(const char* name, bool timeGpu)
+{
+    Profiler::beginCpuScope(name);
+    isGpuTimed_ = timeGpu && Profiler::beginGpuScope(name);
+}
+
+ProfileScope::~ProfileScope()
+{
+    if (isGpuTimed_) {
+        Profiler::endGpuScope();
+    }
+    Profiler::endCpuScope();
+}
@@ -0,0 +1,167 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code measures named CPU and GPU scopes every frame and reports their percentiles when the program ends
+
+#pragma once
+#include <ostream>
+#include <string>
+
+// GLAD
+#include <glad/glad.h>
+
+/**
+ * Average, percentiles and maximum of per-frame samples of a scope or counter.
+ */
+struct ProfileStats
+{
+    size_t count = 0;
+    double average = 0.0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+/**
+ * Built-in frame profiler. CPU scopes are timed with a steady clock and may nest, GPU scopes
+ * are timed with GL_TIME_ELAPSED queries. GPU queries are double-buffered - results of a frame
+ * are read two frames later, when the GPU is done with them, so the profiler never stalls the pipeline.
+ * Per-frame totals of every scope and counter are kept for the whole run and reported as p50 / p95 / p99.
+ */
+class Profiler
+{
+public:
+    /**
+     * Creates GPU query pool. Must be called once the OpenGL context exists.
+     *
+     * @param maxGpuScopesPerFrame  GPU scopes beyond this count in one frame are not timed
+     */
+    static void init(int maxGpuScopesPerFrame = 64);
+
+    /**
+     * Marks start of a frame - records duration of the previous frame and collects GPU results
+     * of the frame before it.
+     */
+    static void beginFrame();
+
+    /**
+     * Marks end of a frame - stores per-frame totals of all scopes and counters.
+     */
+    static void endFrame();
+
+    /**
+     * Starts / ends CPU scope, prefer ProfileScope over calling these directly.
+     *
+     * @param name  Scope name, pointer must stay valid for the whole run (string literal)
+     */
+    static void beginCpuScope(const char* name);
+    static void endCpuScope();
+
+    /**
+     * Starts / ends GPU scope. GPU scopes must not nest, nested scope is ignored.
+     * endGpuScope must be called only when beginGpuScope returned true.
+     *
+     * @param name  Scope name, pointer must stay valid for the whole run (string literal)
+     *
+     * @return True, if the GPU query was started.
+     */
+    static bool beginGpuScope(const char* name);
+    static void endGpuScope();
+
+    /**
+     * Adds value to a per-frame counter (draw calls, lights...), counters start at zero every frame.
+     *
+     * @param name   Counter name, pointer must stay valid for the whole run (string literal)
+     * @param value  Value to add
+     */
+    static void addCounter(const char* name, double value);
+
+    /**
+     * Counts one draw call and the triangles it renders into the "draw calls" and "triangles" counters.
+     *
+     * @param mode           Primitive mode of the draw call (GL_TRIANGLES, GL_TRIANGLE_STRIP...)
+     * @param vertexCount    Number of vertices / indices drawn per instance
+     * @param instanceCount  Number of instances drawn
+     */
+    static void countDraw(GLenum mode, GLsizei vertexCount, GLsizei instanceCount = 1);
+
+    /**
+     * Counts one draw call with known number of triangles, for draws where the count cannot be
+     * derived from the vertex count (strips joined with primitive restart).
+     *
+     * @param numTriangles   Number of triangles drawn per instance
+     * @param instanceCount  Number of instances drawn
+     */
+    static void countDrawTriangles(GLsizei numTriangles, GLsizei instanceCount = 1);
+
+    /**
+     * Gets average duration of last recorded frames.
+     *
+     * @param numFrames  How many of the last frames to average
+     *
+     * @return Average frame time in milliseconds, zero if no frame was recorded yet.
+     */
+    static double getRecentFrameMs(int numFrames);
+
+    /**
+     * Gets statistics of frame time of all recorded frames, in milliseconds.
+     */
+    static ProfileStats getFrameTimeStats();
+
+    /**
+     * Gets statistics of per-frame values of a counter, empty statistics if the counter was never used.
+     */
+    static ProfileStats getCounterStats(const std::string& name);
+
+    /**
+     * Prints p50 / p95 / p99 of frame time, every scope and every counter.
+     */
+    static void printSummary(std::ostream& os);
+
+    /**
+     * Writes the summary as CSV (one row per scope / counter).
+     *
+     * @return True, if the file was written successfully.
+     */
+    static bool writeCsv(const std::string& path);
+
+    /**
+     * Writes recorded scopes as Chrome trace event JSON (open in chrome://tracing or Perfetto).
+     *
+     * @return True, if the file was written successfully.
+     */
+    static bool writeChromeTrace(const std::string& path);
+
+    /**
+     * Writes CSV or Chrome trace, depending on extension of the path (.json means Chrome trace).
+     *
+     * @return True, if the file was written successfully.
+     */
+    static bool writeReport(const std::string& path);
+
+    /**
+     * Deletes GPU queries. Must be called while the OpenGL context still exists.
+     */
+    static void shutdown();
+};
+
+/**
+ * RAII marker of a profiled scope, times the CPU and optionally the GPU work between construction and destruction.
+ */
+class ProfileScope
+{
+public:
+    /**
+     * @param name     Scope name, pointer must stay valid for the whole run (string literal)
+     * @param timeGpu  True to also time GPU commands issued in the scope
+     */
+    explicit ProfileScope(const char* name, bool timeGpu = false);
+    ~ProfileScope();
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    bool isGpuTimed_; // GPU query was started by this scope
+};
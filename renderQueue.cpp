@@ -0,0 +1,239 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code collects the draws of a frame, sorts them by render state and submits them with as few state changes as possible
+
+#include <iostream>
+
+// GLM
+#include <glm/gtc/type_ptr.hpp>
+
+// Project
+#include "renderQueue.h"
+#include "glStateCache.h"
+#include "profiler.h"
+
+namespace {
+
+    // Fields of the sort key from the most significant bit down, program changes cost the most
+    const int PROGRAM_BITS = 12;
+    const int TEXTURE_BITS = 14;
+    const int VAO_BITS = 14;
+    const int DEPTH_BITS = 24;
+
+    const int VAO_SHIFT = DEPTH_BITS;
+    const int TEXTURE_SHIFT = VAO_SHIFT + VAO_BITS;
+    const int PROGRAM_SHIFT = TEXTURE_SHIFT + TEXTURE_BITS;
+
+    const uint64_t DEPTH_MAX = (uint64_t(1) << DEPTH_BITS) - 1;
+
+    const int RADIX_BITS = 8;
+    const int RADIX_BUCKETS = 1 << RADIX_BITS;
+    const int RADIX_PASSES = 64 / RADIX_BITS;
+
+} // namespace
+
+void RenderQueue::begin(const glm::mat4& view, float maxDepth)
+{
+    view_ = view;
+    maxDepth_ = maxDepth > 0.0f ? maxDepth : 1.0f;
+    packets_.clear();
+    entries_.clear();
+}
+
+void RenderQueue::push(const DrawPacket& packet, const glm::vec3& position)
+{
+    if (packet.count <= 0 || packet.instanceCount <= 0) {
+        return;
+    }
+
+    // Front to back - camera looks down negative Z of the view space
+    const auto viewDepth = -(view_ * glm::vec4(position, 1.0f)).z;
+    const auto depth = static_cast<uint64_t>(glm::clamp(viewDepth / maxDepth_, 0.0f, 1.0f) * static_cast<float>(DEPTH_MAX));
+
+    // Slot 0 of the texture field stays for packets without texture, they sort ahead of the textured ones
+    const auto textureSlot = packet.texture == 0 ? 0 : getSlot(textureSlots_, packet.texture, (uint64_t(1) << TEXTURE_BITS) - 1) + 1;
+    const auto key = getSlot(programSlots_, packet.program, uint64_t(1) << PROGRAM_BITS) << PROGRAM_SHIFT
+        | textureSlot << TEXTURE_SHIFT
+        | getSlot(vaoSlots_, packet.vao, uint64_t(1) << VAO_BITS) << VAO_SHIFT
+        | depth;
+
+    entries_.push_back({ key, static_cast<uint32_t>(packets_.size()) });
+    packets_.push_back(packet);
+}
+
+void RenderQueue::submit()
+{
+    stats_ = Stats();
+    if (packets_.empty()) {
+        return;
+    }
+
+    // What binds would the packets cost unsorted and unfiltered (every draw sets its program, texture and VAO)
+    size_t unfilteredBinds = 0;
+    for (const auto& packet : packets_) {
+        unfilteredBinds += packet.texture != 0 ? 3 : 2;
+    }
+
+    radixSort();
+
+    // Nothing is known about the state set before the queue, so the first packet binds everything
+    auto isFirst = true;
+    GLuint currentProgram = 0, currentTexture = 0, currentVao = 0;
+    GLenum currentTextureTarget = GL_TEXTURE_2D;
+    auto isRestartEnabled = false;
+    GLuint currentRestartIndex = 0;
+
+    GLStateCache::activeTexture(GL_TEXTURE0);
+    for (const auto& entry : entries_)
+    {
+        const auto& packet = packets_[entry.packetIndex];
+        if (isFirst || packet.program != currentProgram)
+        {
+            GLStateCache::useProgram(packet.program);
+            currentProgram = packet.program;
+            stats_.programBinds++;
+        }
+        if (packet.texture != 0 && (isFirst || packet.texture != currentTexture || packet.textureTarget != currentTextureTarget))
+        {
+            GLStateCache::bindTexture(packet.textureTarget, packet.texture);
+            currentTexture = packet.texture;
+            currentTextureTarget = packet.textureTarget;
+            stats_.textureBinds++;
+        }
+        if (isFirst || packet.vao != currentVao)
+        {
+            GLStateCache::bindVertexArray(packet.vao);
+            currentVao = packet.vao;
+            stats_.vaoBinds++;
+        }
+        isFirst = false;
+
+        if (packet.isPrimitiveRestart != isRestartEnabled)
+        {
+            packet.isPrimitiveRestart ? glEnable(GL_PRIMITIVE_RESTART) : glDisable(GL_PRIMITIVE_RESTART);
+            isRestartEnabled = packet.isPrimitiveRestart;
+            currentRestartIndex = ~packet.primitiveRestartIndex; // Forces the index to be set below
+        }
+        if (isRestartEnabled && packet.primitiveRestartIndex != currentRestartIndex)
+        {
+            glPrimitiveRestartIndex(packet.primitiveRestartIndex);
+            currentRestartIndex = packet.primitiveRestartIndex;
+        }
+
+        if (packet.modelLocation >= 0) {
+            glUniformMatrix4fv(packet.modelLocation, 1, GL_FALSE, glm::value_ptr(packet.model));
+        }
+
+        if (packet.kind == DrawKind::Arrays)
+        {
+            if (packet.instanceCount == 1) {
+                glDrawArrays(packet.mode, packet.first, packet.count);
+            }
+            else {
+                glDrawArraysInstanced(packet.mode, packet.first, packet.count, packet.instanceCount);
+            }
+        }
+        else
+        {
+            auto* indices = reinterpret_cast<void*>(packet.indexOffset);
+            if (packet.baseVertex != 0) {
+                glDrawElementsInstancedBaseVertex(packet.mode, packet.count, packet.indexType, indices, packet.instanceCount, packet.baseVertex);
+            }
+            else if (packet.instanceCount == 1) {
+                glDrawElements(packet.mode, packet.count, packet.indexType, indices);
+            }
+            else {
+                glDrawElementsInstanced(packet.mode, packet.count, packet.indexType, indices, packet.instanceCount);
+            }
+        }
+
+        if (packet.numTriangles >= 0) {
+            Profiler::countDrawTriangles(packet.numTriangles, packet.instanceCount);
+        }
+        else {
+            Profiler::countDraw(packet.mode, packet.count, packet.instanceCount);
+        }
+    }
+
+    // Meshes drawn outside of the queue expect primitive restart off
+    if (isRestartEnabled) {
+        glDisable(GL_PRIMITIVE_RESTART);
+    }
+
+    stats_.numDraws = packets_.size();
+    const auto binds = stats_.programBinds + stats_.textureBinds + stats_.vaoBinds;
+    stats_.bindsAvoided = unfilteredBinds - binds;
+    Profiler::addCounter("queued draws", static_cast<double>(stats_.numDraws));
+    Profiler::addCounter("state changes", static_cast<double>(binds));
+    Profiler::addCounter("state changes avoided", static_cast<double>(stats_.bindsAvoided));
+}
+
+size_t RenderQueue::getNumPackets() const
+{
+    return packets_.size();
+}
+
+const RenderQueue::Stats& RenderQueue::getStats() const
+{
+    return stats_;
+}
+
+uint64_t RenderQueue::getSlot(std::unordered_map<GLuint, uint64_t>& slots, GLuint name, uint64_t maxSlots)
+{
+    const auto it = slots.find(name);
+    if (it != slots.end()) {
+        return it->second;
+    }
+
+    // Slots are handed out in order of first use and kept, so the order of states stays the same frame to frame
+    if (slots.size() >= maxSlots)
+    {
+        std::cerr << "Render queue ran out of sort key slots, object " << name << " shares the last one!" << std::endl;
+        slots[name] = maxSlots - 1;
+        return maxSlots - 1;
+    }
+
+    const auto slot = static_cast<uint64_t>(slots.size());
+    slots[name] = slot;
+    return slot;
+}
+
+void RenderQueue::radixSort()
+{
+    const auto numEntries = entries_.size();
+    sortScratch_.resize(numEntries);
+
+    // Histograms of all digits in one pass over the keys
+    size_t counts[RADIX_PASSES][RADIX_BUCKETS] = {};
+    for (const auto& entry : entries_)
+    {
+        for (auto pass = 0; pass < RADIX_PASSES; pass++) {
+            counts[pass][(entry.key >> (pass * RADIX_BITS)) & (RADIX_BUCKETS - 1)]++;
+        }
+    }
+
+    // Least significant digit first, every pass is stable so the order of lower digits survives
+    for (auto pass = 0; pass < RADIX_PASSES; pass++)
+    {
+        const auto shift = pass * RADIX_BITS;
+
+        // Digit shared by all keys would not move anything (high bits of program slots mostly)
+        if (counts[pass][(entries_[0].key >> shift) & (RADIX_BUCKETS - 1)] == numEntries) {
+            continue;
+        }
+
+        size_t offsets[RADIX_BUCKETS];
+        size_t offset = 0;
+        for (auto bucket = 0; bucket < RADIX_BUCKETS; bucket++)
+        {
+            offsets[bucket] = offset;
+            offset += counts[pass][bucket];
+        }
+
+        for (const auto& entry : entries_) {
+            sortScratch_[offsets[(entry.key >> shift) & (RADIX_BUCKETS - 1)]++] = entry;
+        }
+        entries_.swap(sortScratch_);
+    }
+}
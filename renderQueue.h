@@ -0,0 +1,122 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code collects the draws of a frame, sorts them by render state and submits them with as few state changes as possible
+
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// GLAD
+#include <glad/glad.h>
+
+// GLM
+#include <glm/glm.hpp>
+
+/**
+ * How a draw packet is drawn.
+ */
+enum class DrawKind : uint8_t
+{
+    Arrays, // glDrawArrays(Instanced) of count vertices from first
+    Elements // glDrawElements(Instanced) of count indices from indexOffset
+};
+
+/**
+ * Everything one draw call needs - the state it must run with and its parameters.
+ */
+struct DrawPacket
+{
+    GLuint program = 0;
+    GLenum textureTarget = GL_TEXTURE_2D;
+    GLuint texture = 0; // Bound to unit 0, 0 means the draw samples no texture
+    GLuint vao = 0;
+    GLint modelLocation = -1; // Uniform the model matrix goes to, -1 when instances bring their own
+    glm::mat4 model = glm::mat4(1.0f);
+
+    DrawKind kind = DrawKind::Arrays;
+    GLenum mode = GL_TRIANGLES;
+    GLint first = 0;
+    GLsizei count = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+    uintptr_t indexOffset = 0; // Byte offset into the element buffer of the VAO
+    GLint baseVertex = 0; // Added to every index, meshes sharing buffers of a GeometryPool keep their indices local
+    GLsizei instanceCount = 1;
+    bool isPrimitiveRestart = false;
+    GLuint primitiveRestartIndex = 0;
+    GLsizei numTriangles = -1; // Triangles per instance for the profiler, -1 derives them from mode and count
+};
+
+/**
+ * Per-frame draw queue. The scene pushes draw packets in any order, every packet gets a 64-bit sort key
+ * (from the top: program, texture, VAO, depth) and the keys are radix sorted, so draws sharing a program,
+ * texture and VAO end up next to each other and go front to back inside such a run (early depth test
+ * rejects more hidden fragments). Submission binds only state that differs from the previous packet.
+ */
+class RenderQueue
+{
+public:
+    /**
+     * State changes of the last submit.
+     */
+    struct Stats
+    {
+        size_t numDraws = 0;
+        size_t programBinds = 0;
+        size_t textureBinds = 0;
+        size_t vaoBinds = 0;
+        size_t bindsAvoided = 0; // Binds the draws would have done in push order without filtering
+    };
+
+    /**
+     * Starts a frame - drops packets of the previous one.
+     *
+     * @param view      View matrix of the camera, for depth of the packets
+     * @param maxDepth  View distance mapped to the largest depth key (far plane)
+     */
+    void begin(const glm::mat4& view, float maxDepth);
+
+    /**
+     * Adds a draw.
+     *
+     * @param packet    Draw and its state
+     * @param position  World position of the object, used only for sorting by depth
+     */
+    void push(const DrawPacket& packet, const glm::vec3& position);
+
+    /**
+     * Sorts the packets and issues their draw calls. Leaves texture unit 0 active.
+     */
+    void submit();
+
+    size_t getNumPackets() const;
+    const Stats& getStats() const;
+
+private:
+    /**
+     * Sort key with index of its packet.
+     */
+    struct SortEntry
+    {
+        uint64_t key;
+        uint32_t packetIndex;
+    };
+
+    /**
+     * Gets small stable number of an OpenGL object, so it fits into its field of the sort key.
+     */
+    static uint64_t getSlot(std::unordered_map<GLuint, uint64_t>& slots, GLuint name, uint64_t maxSlots);
+
+    void radixSort();
+
+    glm::mat4 view_ = glm::mat4(1.0f);
+    float maxDepth_ = 1.0f;
+    std::vector<DrawPacket> packets_;
+    std::vector<SortEntry> entries_;
+    std::vector<SortEntry> sortScratch_;
+    std::unordered_map<GLuint, uint64_t> programSlots_;
+    std::unordered_map<GLuint, uint64_t> textureSlots_;
+    std::unordered_map<GLuint, uint64_t> vaoSlots_;
+    Stats stats_;
+};
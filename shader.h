@@ -10,18 +10,31 @@
 
 #include <glm/glm.hpp>
 
+#include "glStateCache.h"
+#include "uniformBlocks.h"
+
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
+#include <vector>
+
+// handle of an active uniform, resolved once with Shader::getUniformId and then used in the set* functions
+// without any string lookups. Invalid (-1) handles are silently ignored by OpenGL, same as unknown names.
+struct UniformId
+{
+	GLint location = -1;
+};
 
 class Shader
 {
 public:
 	unsigned int ID;
-	// constructor generates the shader on the fly
+	// constructor generates the shader on the fly, defines (lines like "#define MATERIAL_ARRAY\n") go
+	// right after the #version line of every stage, so one file can build several variants
 	// ------------------------------------------------------------------------
-	Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr)
+	Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr, const char* defines = nullptr)
 	{
 		// 1. retrieve the vertex/fragment source code from filePath
 		std::string vertexCode;
@@ -63,6 +76,12 @@ public:
 		{
 			std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
 		}
+		if (defines != nullptr)
+		{
+			insertDefines(vertexCode, defines);
+			insertDefines(fragmentCode, defines);
+			insertDefines(geometryCode, defines);
+		}
 		const char* vShaderCode = vertexCode.c_str();
 		const char * fShaderCode = fragmentCode.c_str();
 		// 2. compile shaders
@@ -100,74 +119,215 @@ public:
 		glDeleteShader(fragment);
 		if (geometryPath != nullptr)
 			glDeleteShader(geometry);
-
+		// 3. resolve locations of all active uniforms, so we never have to ask the driver again
+		cacheUniformLocations();
+		// 4. attach shared uniform blocks to their fixed binding points
+		bindUniformBlock(CAMERA_BLOCK_NAME, CAMERA_BLOCK_BINDING);
+		bindUniformBlock(LIGHTS_BLOCK_NAME, LIGHTS_BLOCK_BINDING);
+		bindUniformBlock(CLUSTERS_BLOCK_NAME, CLUSTERS_BLOCK_BINDING);
+	}
+	// constructor for a compute program, it has no other stages and no uniform blocks
+	// ------------------------------------------------------------------------
+	explicit Shader(const char* computePath)
+	{
+		std::string computeCode;
+		std::ifstream cShaderFile;
+		cShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+		try
+		{
+			cShaderFile.open(computePath);
+			std::stringstream cShaderStream;
+			cShaderStream << cShaderFile.rdbuf();
+			cShaderFile.close();
+			computeCode = cShaderStream.str();
+		}
+		catch (std::ifstream::failure& e)
+		{
+			std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
+		}
+		const char* cShaderCode = computeCode.c_str();
+		unsigned int compute = glCreateShader(GL_COMPUTE_SHADER);
+		glShaderSource(compute, 1, &cShaderCode, NULL);
+		glCompileShader(compute);
+		checkCompileErrors(compute, "COMPUTE");
+		ID = glCreateProgram();
+		glAttachShader(ID, compute);
+		glLinkProgram(ID);
+		checkCompileErrors(ID, "PROGRAM");
+		glDeleteShader(compute);
+		cacheUniformLocations();
 	}
 	// activate the shader
 	// ------------------------------------------------------------------------
 	void use()
 	{
-		glUseProgram(ID);
+		GLStateCache::useProgram(ID);
+	}
+	// resolves handle of an active uniform, meant to be done once at init for uniforms updated every frame
+	// ------------------------------------------------------------------------
+	UniformId getUniformId(const std::string &name) const
+	{
+		UniformId id;
+		id.location = findUniformLocation(name);
+		return id;
 	}
 	// utility uniform functions
 	// ------------------------------------------------------------------------
 	void setBool(const std::string &name, bool value) const
 	{
-		glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+		glUniform1i(findUniformLocation(name), (int)value);
+	}
+	void setBool(UniformId id, bool value) const
+	{
+		glUniform1i(id.location, (int)value);
 	}
 	// ------------------------------------------------------------------------
 	void setInt(const std::string &name, int value) const
 	{
-		glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+		glUniform1i(findUniformLocation(name), value);
+	}
+	void setInt(UniformId id, int value) const
+	{
+		glUniform1i(id.location, value);
 	}
 	// ------------------------------------------------------------------------
 	void setFloat(const std::string &name, float value) const
 	{
-		glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+		glUniform1f(findUniformLocation(name), value);
+	}
+	void setFloat(UniformId id, float value) const
+	{
+		glUniform1f(id.location, value);
 	}
 	// ------------------------------------------------------------------------
 	void setVec2(const std::string &name, const glm::vec2 &value) const
 	{
-		glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+		glUniform2fv(findUniformLocation(name), 1, &value[0]);
 	}
 	void setVec2(const std::string &name, float x, float y) const
 	{
-		glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+		glUniform2f(findUniformLocation(name), x, y);
+	}
+	void setVec2(UniformId id, const glm::vec2 &value) const
+	{
+		glUniform2fv(id.location, 1, &value[0]);
 	}
 	// ------------------------------------------------------------------------
 	void setVec3(const std::string &name, const glm::vec3 &value) const
 	{
-		glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+		glUniform3fv(findUniformLocation(name), 1, &value[0]);
 	}
 	void setVec3(const std::string &name, float x, float y, float z) const
 	{
-		glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+		glUniform3f(findUniformLocation(name), x, y, z);
+	}
+	void setVec3(UniformId id, const glm::vec3 &value) const
+	{
+		glUniform3fv(id.location, 1, &value[0]);
 	}
 	// ------------------------------------------------------------------------
 	void setVec4(const std::string &name, const glm::vec4 &value) const
 	{
-		glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+		glUniform4fv(findUniformLocation(name), 1, &value[0]);
 	}
 	void setVec4(const std::string &name, float x, float y, float z, float w)
 	{
-		glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+		glUniform4f(findUniformLocation(name), x, y, z, w);
+	}
+	void setVec4(UniformId id, const glm::vec4 &value) const
+	{
+		glUniform4fv(id.location, 1, &value[0]);
 	}
 	// ------------------------------------------------------------------------
 	void setMat2(const std::string &name, const glm::mat2 &mat) const
 	{
-		glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+		glUniformMatrix2fv(findUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
 	}
 	// ------------------------------------------------------------------------
 	void setMat3(const std::string &name, const glm::mat3 &mat) const
 	{
-		glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+		glUniformMatrix3fv(findUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
+	}
+	void setMat3(UniformId id, const glm::mat3 &mat) const
+	{
+		glUniformMatrix3fv(id.location, 1, GL_FALSE, &mat[0][0]);
 	}
 	// ------------------------------------------------------------------------
 	void setMat4(const std::string &name, const glm::mat4 &mat) const
 	{
-		glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+		glUniformMatrix4fv(findUniformLocation(name), 1, GL_FALSE, &mat[0][0]);
+	}
+	void setMat4(UniformId id, const glm::mat4 &mat) const
+	{
+		glUniformMatrix4fv(id.location, 1, GL_FALSE, &mat[0][0]);
 	}
 
 private:
+	// locations of all active uniforms by name, filled once after linking
+	std::unordered_map<std::string, GLint> uniformLocations;
+
+	// looks up cached uniform location, -1 for names that are not active in this program
+	// ------------------------------------------------------------------------
+	GLint findUniformLocation(const std::string &name) const
+	{
+		const auto it = uniformLocations.find(name);
+		return it != uniformLocations.end() ? it->second : -1;
+	}
+	// asks the driver for every active uniform once and remembers its location
+	// ------------------------------------------------------------------------
+	void cacheUniformLocations()
+	{
+		GLint numUniforms = 0;
+		GLint maxNameLength = 0;
+		glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &numUniforms);
+		glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+		std::vector<GLchar> nameBuffer(maxNameLength > 0 ? maxNameLength : 1);
+		for (GLint i = 0; i < numUniforms; i++)
+		{
+			GLint size = 0;
+			GLenum type = 0;
+			GLsizei length = 0;
+			glGetActiveUniform(ID, i, (GLsizei)nameBuffer.size(), &length, &size, &type, nameBuffer.data());
+			const std::string name(nameBuffer.data(), length);
+			const GLint location = glGetUniformLocation(ID, name.c_str());
+			// members of uniform blocks have no location, they are not set through here
+			if (location < 0)
+				continue;
+			uniformLocations[name] = location;
+			// arrays of basic types are reported once as "name[0]", so register every element and the bare name too
+			const std::string arraySuffix = "[0]";
+			if (name.size() > arraySuffix.size() && name.compare(name.size() - arraySuffix.size(), arraySuffix.size(), arraySuffix) == 0)
+			{
+				const std::string baseName = name.substr(0, name.size() - arraySuffix.size());
+				uniformLocations[baseName] = location;
+				for (GLint element = 1; element < size; element++)
+				{
+					const std::string elementName = baseName + "[" + std::to_string(element) + "]";
+					uniformLocations[elementName] = glGetUniformLocation(ID, elementName.c_str());
+				}
+			}
+		}
+	}
+	// puts defines after the #version line, which must stay the first line of the source
+	// ------------------------------------------------------------------------
+	static void insertDefines(std::string &code, const char* defines)
+	{
+		if (code.empty())
+			return;
+		const std::string::size_type versionEnd = code.compare(0, 8, "#version") == 0 ? code.find('\n') : std::string::npos;
+		if (versionEnd == std::string::npos)
+			code.insert(0, defines);
+		else
+			code.insert(versionEnd + 1, defines);
+	}
+	// attaches uniform block to a binding point, programs not using the block are left alone
+	// ------------------------------------------------------------------------
+	void bindUniformBlock(const char* blockName, GLuint bindingPoint)
+	{
+		const GLuint blockIndex = glGetUniformBlockIndex(ID, blockName);
+		if (blockIndex != GL_INVALID_INDEX)
+			glUniformBlockBinding(ID, blockIndex, bindingPoint);
+	}
 	// utility function for checking shader compilation/linking errors.
 	// ------------------------------------------------------------------------
 	void checkCompileErrors(GLuint shader, std::string type)
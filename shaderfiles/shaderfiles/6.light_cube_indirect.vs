@@ -0,0 +1,26 @@
+#version 430 core
+// GPU driven scene: light cubes read their model matrix from the object buffer (GpuDrivenScene)
+layout (location = 0) in vec3 aPos;
+layout (location = 3) in uint aObjectId;
+
+struct Object
+{
+    mat4 model;
+    vec4 boundingSphere;
+    uint mesh;
+    uint materialLayer;
+};
+
+layout (std430, binding = 0) readonly buffer Objects { Object objects[]; };
+
+layout (std140) uniform Camera
+{
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
+
+void main()
+{
+    gl_Position = projection * view * objects[aObjectId].model * vec4(aPos, 1.0);
+}
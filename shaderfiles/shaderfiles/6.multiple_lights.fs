@@ -1,12 +1,26 @@
 #version 330 core
 out vec4 FragColor;
 
+#ifdef MATERIAL_ARRAY
+// maps are layers of texture arrays (MaterialArray), every instance brings its own layer
+struct Material {
+    sampler2DArray diffuse;
+    sampler2DArray specular;
+    float shininess;
+};
+flat in uint MaterialLayer;
+#define SAMPLE_MATERIAL(map) texture(map, vec3(TexCoords, float(MaterialLayer)))
+#else
 struct Material {
     sampler2D diffuse;
     sampler2D specular;
     float shininess;
 }; 
+#define SAMPLE_MATERIAL(map) texture(map, TexCoords)
+#endif
 
+// light structs live in the std140 Lights block and the clustered light data texture buffer,
+// members are ordered so that scalars fill the gaps after vec3s (mirrored by the *Block structs in uniformBlocks.h)
 struct DirLight {
     vec3 direction;
 	
@@ -17,47 +31,65 @@ struct DirLight {
 
 struct PointLight {
     vec3 position;
-    
     float constant;
-    float linear;
-    float quadratic;
-	
     vec3 ambient;
+    float linear;
     vec3 diffuse;
+    float quadratic;
     vec3 specular;
+    float radius;
 };
 
 struct SpotLight {
     vec3 position;
-    vec3 direction;
     float cutOff;
+    vec3 direction;
     float outerCutOff;
-  
+    vec3 ambient;
     float constant;
+    vec3 diffuse;
     float linear;
+    vec3 specular;
     float quadratic;
-  
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;       
 };
 
-#define NR_POINT_LIGHTS 4
-
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoords;
 
-uniform vec3 viewPos;
-uniform DirLight dirLight;
-uniform PointLight pointLights[NR_POINT_LIGHTS];
-uniform SpotLight spotLight;
+layout (std140) uniform Camera
+{
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
+
+layout (std140) uniform Lights
+{
+    DirLight dirLight;
+    SpotLight spotLight;
+};
+
+// point lights are binned into a grid of view frustum clusters by ClusteredLightGrid
+layout (std140) uniform Clusters
+{
+    uvec4 clusterGridSize;    // x, y screen tiles and z depth slices
+    vec4 clusterDepthParams;  // zNear, zFar, slice scale, slice bias
+    vec2 clusterScreenSize;
+};
+
+uniform samplerBuffer clusterLightData;      // 4 texels per light, see PointLight
+uniform usamplerBuffer clusterGrid;          // offset and count of lights per cluster
+uniform usamplerBuffer clusterLightIndices;  // light indices of all clusters
+
 uniform Material material;
 
 // function prototypes
 vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir);
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
 vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+uint GetClusterIndex(vec3 fragPos);
+PointLight FetchPointLight(uint lightIndex);
 
 void main()
 {    
@@ -73,9 +105,13 @@ void main()
     // == =====================================================
     // phase 1: directional lighting
     vec3 result = CalcDirLight(dirLight, norm, viewDir);
-    // phase 2: point lights
-    for(int i = 0; i < NR_POINT_LIGHTS; i++)
-        result += CalcPointLight(pointLights[i], norm, FragPos, viewDir);    
+    // phase 2: point lights, only the ones listed in the cluster of this fragment
+    uvec2 cluster = texelFetch(clusterGrid, int(GetClusterIndex(FragPos))).xy;
+    for(uint i = 0u; i < cluster.y; i++)
+    {
+        uint lightIndex = texelFetch(clusterLightIndices, int(cluster.x + i)).x;
+        result += CalcPointLight(FetchPointLight(lightIndex), norm, FragPos, viewDir);
+    }
     // phase 3: spot light
     result += CalcSpotLight(spotLight, norm, FragPos, viewDir);    
     
@@ -92,9 +128,9 @@ vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir)
     vec3 reflectDir = reflect(-lightDir, normal);
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
     // combine results
-    vec3 ambient = light.ambient * vec3(texture(material.diffuse, TexCoords));
-    vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords));
-    vec3 specular = light.specular * spec * vec3(texture(material.specular, TexCoords));
+    vec3 ambient = light.ambient * vec3(SAMPLE_MATERIAL(material.diffuse));
+    vec3 diffuse = light.diffuse * diff * vec3(SAMPLE_MATERIAL(material.diffuse));
+    vec3 specular = light.specular * spec * vec3(SAMPLE_MATERIAL(material.specular));
     return (ambient + diffuse + specular);
 }
 
@@ -110,10 +146,13 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     // attenuation
     float distance = length(light.position - fragPos);
     float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));    
+    // fade out towards the radius the light was binned with, so cluster borders do not show
+    float falloff = clamp(1.0 - pow(distance / light.radius, 4.0), 0.0, 1.0);
+    attenuation *= falloff * falloff;
     // combine results
-    vec3 ambient = light.ambient * vec3(texture(material.diffuse, TexCoords));
-    vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords));
-    vec3 specular = light.specular * spec * vec3(texture(material.specular, TexCoords));
+    vec3 ambient = light.ambient * vec3(SAMPLE_MATERIAL(material.diffuse));
+    vec3 diffuse = light.diffuse * diff * vec3(SAMPLE_MATERIAL(material.diffuse));
+    vec3 specular = light.specular * spec * vec3(SAMPLE_MATERIAL(material.specular));
     ambient *= attenuation;
     diffuse *= attenuation;
     specular *= attenuation;
@@ -137,11 +176,43 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     float epsilon = light.cutOff - light.outerCutOff;
     float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
     // combine results
-    vec3 ambient = light.ambient * vec3(texture(material.diffuse, TexCoords));
-    vec3 diffuse = light.diffuse * diff * vec3(texture(material.diffuse, TexCoords));
-    vec3 specular = light.specular * spec * vec3(texture(material.specular, TexCoords));
+    vec3 ambient = light.ambient * vec3(SAMPLE_MATERIAL(material.diffuse));
+    vec3 diffuse = light.diffuse * diff * vec3(SAMPLE_MATERIAL(material.diffuse));
+    vec3 specular = light.specular * spec * vec3(SAMPLE_MATERIAL(material.specular));
     ambient *= attenuation * intensity;
     diffuse *= attenuation * intensity;
     specular *= attenuation * intensity;
     return (ambient + diffuse + specular);
+}
+
+// finds the cluster of the light grid containing the fragment.
+uint GetClusterIndex(vec3 fragPos)
+{
+    float depth = -(view * vec4(fragPos, 1.0)).z;
+    uvec2 tile = uvec2(gl_FragCoord.xy / clusterScreenSize * vec2(clusterGridSize.xy));
+    uint slice = uint(max(log(depth) * clusterDepthParams.z - clusterDepthParams.w, 0.0));
+    tile = min(tile, clusterGridSize.xy - 1u);
+    slice = min(slice, clusterGridSize.z - 1u);
+    return tile.x + tile.y * clusterGridSize.x + slice * clusterGridSize.x * clusterGridSize.y;
+}
+
+// reads point light from the light data texture buffer.
+PointLight FetchPointLight(uint lightIndex)
+{
+    int texel = int(lightIndex) * 4;
+    vec4 positionConstant = texelFetch(clusterLightData, texel);
+    vec4 ambientLinear = texelFetch(clusterLightData, texel + 1);
+    vec4 diffuseQuadratic = texelFetch(clusterLightData, texel + 2);
+    vec4 specularRadius = texelFetch(clusterLightData, texel + 3);
+
+    PointLight light;
+    light.position = positionConstant.xyz;
+    light.constant = positionConstant.w;
+    light.ambient = ambientLinear.xyz;
+    light.linear = ambientLinear.w;
+    light.diffuse = diffuseQuadratic.xyz;
+    light.quadratic = diffuseQuadratic.w;
+    light.specular = specularRadius.xyz;
+    light.radius = specularRadius.w;
+    return light;
 }
\ No newline at end of file
@@ -0,0 +1,40 @@
+#version 430 core
+// GPU driven scene: same lighting inputs as 6.multiple_lights.vs, but the model matrix and the material
+// layer come from the object buffer, at the index passed in by the per-instance attribute (GpuDrivenScene)
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 3) in uint aObjectId;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoords;
+flat out uint MaterialLayer;
+
+struct Object
+{
+    mat4 model;
+    vec4 boundingSphere;
+    uint mesh;
+    uint materialLayer;
+};
+
+layout (std430, binding = 0) readonly buffer Objects { Object objects[]; };
+
+layout (std140) uniform Camera
+{
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
+
+void main()
+{
+    mat4 model = objects[aObjectId].model;
+    FragPos = vec3(model * vec4(aPos, 1.0));
+    Normal = mat3(transpose(inverse(model))) * aNormal;  
+    TexCoords = aTexCoords;
+    MaterialLayer = objects[aObjectId].materialLayer;
+    
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
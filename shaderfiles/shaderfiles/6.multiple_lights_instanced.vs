@@ -0,0 +1,31 @@
+#version 330 core
+// attribute locations follow StaticMesh3D (position 0, texture coordinate 1, normal 2)
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aTexCoords;
+layout (location = 2) in vec3 aNormal;
+// per-instance model matrix (attribute divisor 1), takes locations 3 - 6
+layout (location = 3) in mat4 aInstanceModel;
+// per-instance layer of the material texture arrays, sampled by the fragment shader built with MATERIAL_ARRAY
+layout (location = 7) in uint aMaterialLayer;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoords;
+flat out uint MaterialLayer;
+
+layout (std140) uniform Camera
+{
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
+
+void main()
+{
+    FragPos = vec3(aInstanceModel * vec4(aPos, 1.0));
+    Normal = mat3(transpose(inverse(aInstanceModel))) * aNormal;  
+    TexCoords = aTexCoords;
+    MaterialLayer = aMaterialLayer;
+    
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
@@ -0,0 +1,7 @@
+#version 330 core
+out vec4 FragColor;
+
+void main()
+{
+    FragColor = vec4(1.0); // never runs, rasterizer discard is on while benchmarking
+}
\ No newline at end of file
@@ -0,0 +1,10 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aTexCoords;
+layout (location = 2) in vec3 aNormal;
+
+// vertex layout benchmark: every attribute feeds gl_Position, so the compiler cannot skip fetching any of them
+void main()
+{
+    gl_Position = vec4(aPos + aNormal * 0.001 + vec3(aTexCoords, 0.0) * 0.001, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,134 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code keeps several detail levels of the sphere on the GPU and picks one by how big the sphere is on screen
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+// Project
+#include "sphereLodChain.h"
+#include "ShapeGenerator.h"
+#include "jobSystem.h"
+#include "meshOptimizer.h"
+
+const int SphereLodChain::NUM_LEVELS = 5;
+
+namespace {
+
+    // Smallest projected diameter in pixels for each level, the last level takes everything smaller
+    const float LEVEL_MIN_SCREEN_SIZE[] = { 240.0f, 96.0f, 40.0f, 16.0f, 0.0f };
+
+} // namespace
+
+SphereLodChain::~SphereLodChain()
+{
+    deleteChain();
+}
+
+bool SphereLodChain::create(GeometryPool& pool)
+{
+    if (pool_ != nullptr)
+    {
+        std::cerr << "This sphere LOD chain is already created! You need to delete it before re-creating it!" << std::endl;
+        return false;
+    }
+
+    // Levels are independent, each one is generated and optimized as its own job
+    std::vector<ShapeData> shapes(NUM_LEVELS);
+    JobSystem::parallelFor(NUM_LEVELS, 1, [&shapes](size_t first, size_t last) {
+        for (auto level = first; level < last; level++)
+        {
+            shapes[level] = ShapeGenerator::makeIcosphere(static_cast<uint>(NUM_LEVELS - 1 - level));
+            const auto name = "sphere LOD " + std::to_string(level);
+            MeshOptimizer::optimize(shapes[level], name.c_str());
+        }
+    });
+
+    // Vertices of every level lie on the unit sphere, coarser levels are inside the finest one
+    localBounds_ = shapes[0].bounds;
+
+    // Every level is its own mesh of the pool, drawn with its base vertex, so indices stay as generated
+    pool_ = &pool;
+    for (const auto& shape : shapes)
+    {
+        const auto mesh = pool.add(shape.vertices.data(), shape.numVertices(), shape.indexData(), shape.numIndices(), shape.indexType);
+        if (!mesh.isValid())
+        {
+            std::cerr << "Sphere LOD chain does not fit its geometry pool!" << std::endl;
+            deleteChain();
+            return false;
+        }
+        levels_.push_back(mesh);
+    }
+
+    return true;
+}
+
+int SphereLodChain::selectLevel(const glm::vec3& center, float radius, const glm::mat4& view, const glm::mat4& projection, int viewportHeight) const
+{
+    // Camera inside or right at the sphere - it covers the whole screen
+    const auto distance = -(view * glm::vec4(center, 1.0f)).z;
+    if (distance <= radius) {
+        return 0;
+    }
+
+    // projection[1][1] is cot(fovY / 2), so this is diameter / (2 * distance * tan(fovY / 2)) of the viewport height
+    const auto screenSize = radius * projection[1][1] * static_cast<float>(viewportHeight) / distance;
+    auto level = 0;
+    while (level < NUM_LEVELS - 1 && screenSize < LEVEL_MIN_SCREEN_SIZE[level]) {
+        level++;
+    }
+
+    return level;
+}
+
+void SphereLodChain::render(int level) const
+{
+    if (levels_.empty()) {
+        return;
+    }
+
+    pool_->draw(getLevelMesh(level));
+}
+
+void SphereLodChain::enqueue(RenderQueue& queue, DrawPacket packet, int level, const glm::vec3& position) const
+{
+    if (levels_.empty()) {
+        return;
+    }
+
+    // Offsets in the pool may move when it grows, so they are taken again for every draw
+    pool_->fillPacket(getLevelMesh(level), packet);
+    packet.mode = GL_TRIANGLES;
+    queue.push(packet, position);
+}
+
+int SphereLodChain::getNumTriangles(int level) const
+{
+    return level >= 0 && level < static_cast<int>(levels_.size()) ? pool_->getNumIndices(levels_[level]) / 3 : 0;
+}
+
+const Bounds& SphereLodChain::getLocalBounds() const
+{
+    return localBounds_;
+}
+
+void SphereLodChain::deleteChain()
+{
+    if (pool_ == nullptr) {
+        return;
+    }
+
+    for (const auto mesh : levels_) {
+        pool_->remove(mesh);
+    }
+    levels_.clear();
+    pool_ = nullptr;
+}
+
+GeometryHandle SphereLodChain::getLevelMesh(int level) const
+{
+    return levels_[std::max(0, std::min(level, static_cast<int>(levels_.size()) - 1))];
+}
@@ -0,0 +1,97 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code keeps several detail levels of the sphere on the GPU and picks one by how big the sphere is on screen
+
+#pragma once
+#include <vector>
+
+// GLAD
+#include <glad/glad.h>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Project
+#include "boundingVolume.h"
+#include "geometryPool.h"
+#include "renderQueue.h"
+
+/**
+ * Unit icosphere in several levels of detail, every level is a mesh of a GeometryPool of the ShapeData
+ * vertex format (position, color, normal at attribute locations 0, 1, 2), so the sphere shares its VAO
+ * with other generated shapes. Level 0 is the most detailed one (5120 triangles), every next level has
+ * 4 times fewer triangles, the last one is the plain icosahedron (20 triangles).
+ */
+class SphereLodChain
+{
+public:
+    static const int NUM_LEVELS; // Number of detail levels (5)
+
+    SphereLodChain() = default;
+    SphereLodChain(const SphereLodChain&) = delete;
+    SphereLodChain& operator=(const SphereLodChain&) = delete;
+    ~SphereLodChain();
+
+    /**
+     * Generates all levels, optimizes them for vertex cache and uploads them.
+     *
+     * @param pool  Pool of VertexFormat::shapeData() format the levels go to, must outlive the chain
+     *
+     * @return True, if the chain was created.
+     */
+    bool create(GeometryPool& pool);
+
+    /**
+     * Picks detail level of a sphere by its projected diameter in pixels.
+     *
+     * @param center          World position of the sphere center
+     * @param radius          World radius of the sphere
+     * @param view            View matrix of the camera
+     * @param projection      Perspective projection matrix of the camera
+     * @param viewportHeight  Height of the render target in pixels
+     *
+     * @return Level to render, 0 is the most detailed one.
+     */
+    int selectLevel(const glm::vec3& center, float radius, const glm::mat4& view, const glm::mat4& projection, int viewportHeight) const;
+
+    /**
+     * Renders given detail level, model matrix must already be set.
+     */
+    void render(int level) const;
+
+    /**
+     * Pushes draw of given detail level to a render queue.
+     *
+     * @param queue     Queue of the current frame
+     * @param packet    Program, texture and model matrix of the sphere, draw fields are filled in here
+     * @param level     Level to draw
+     * @param position  World position the draw is depth sorted by
+     */
+    void enqueue(RenderQueue& queue, DrawPacket packet, int level, const glm::vec3& position) const;
+
+    /**
+     * Gets number of triangles of given detail level.
+     */
+    int getNumTriangles(int level) const;
+
+    /**
+     * Gets bounds of the unit sphere, taken from the most detailed level (every level fits inside it).
+     */
+    const Bounds& getLocalBounds() const;
+
+    /**
+     * Removes the levels from the pool.
+     */
+    void deleteChain();
+
+private:
+    /**
+     * Gets mesh of a level, level is clamped to the existing ones.
+     */
+    GeometryHandle getLevelMesh(int level) const;
+
+    GeometryPool* pool_{ nullptr };
+    std::vector<GeometryHandle> levels_;
+    Bounds localBounds_;
+};
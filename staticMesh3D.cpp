@@ -3,9 +3,74 @@
 //version 2.1
 //This code provides a foundation for managing static 3D meshes in an OpenGL application, including initialization, attribute setup, and memory management
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
 #include "staticMesh3D.h"
+#include "glStateCache.h"
+#include "gpuResourceTracker.h"
 #include <glm/glm.hpp>
 
+namespace {
+
+    /**
+     * Converts float to IEEE half float, rounding to nearest.
+     */
+    uint16_t packHalf(float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+
+        const auto sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+        const auto exponent = static_cast<int>((bits >> 23) & 0xFFu) - 127 + 15;
+        auto mantissa = bits & 0x7FFFFFu;
+
+        if (exponent <= 0)
+        {
+            // Too small for a normal half float - becomes subnormal or zero
+            if (exponent < -10) {
+                return sign;
+            }
+
+            mantissa |= 0x800000u;
+            const auto shift = static_cast<uint32_t>(14 - exponent);
+            auto result = static_cast<uint16_t>(mantissa >> shift);
+            if ((mantissa >> (shift - 1)) & 1u) {
+                result++;
+            }
+            return sign | result;
+        }
+
+        if (exponent >= 31) {
+            return sign | 0x7C00u; // Too big (or NaN), becomes infinity
+        }
+
+        // Rounding may carry into exponent, which is still the correctly rounded result
+        auto result = static_cast<uint16_t>(sign | (exponent << 10) | (mantissa >> 13));
+        if (mantissa & 0x1000u) {
+            result++;
+        }
+        return result;
+    }
+
+    /**
+     * Packs unit vector to GL_INT_2_10_10_10_REV - three 10-bit signed normalized components, W is left zero.
+     */
+    uint32_t packNormal(const glm::vec3& normal)
+    {
+        const auto packComponent = [](float value) {
+            const auto clamped = std::max(-1.0f, std::min(1.0f, value));
+            return static_cast<uint32_t>(static_cast<int>(std::round(clamped * 511.0f))) & 0x3FFu;
+        };
+
+        return packComponent(normal.x) | (packComponent(normal.y) << 10) | (packComponent(normal.z) << 20);
+    }
+
+} // namespace
+
 //Create mesh3D
 namespace static_meshes_3D {
 
@@ -13,10 +78,11 @@ namespace static_meshes_3D {
     const int StaticMesh3D::TEXTURE_COORDINATE_ATTRIBUTE_INDEX = 1;
     const int StaticMesh3D::NORMAL_ATTRIBUTE_INDEX = 2;
 
-    StaticMesh3D::StaticMesh3D(bool withPositions, bool withTextureCoordinates, bool withNormals)
+    StaticMesh3D::StaticMesh3D(bool withPositions, bool withTextureCoordinates, bool withNormals, VertexLayout vertexLayout)
         : _hasPositions(withPositions)
         , _hasTextureCoordinates(withTextureCoordinates)
-        , _hasNormals(withNormals) {}
+        , _hasNormals(withNormals)
+        , _vertexLayout(vertexLayout) {}
 
     StaticMesh3D::~StaticMesh3D()
     {
@@ -29,12 +95,27 @@ namespace static_meshes_3D {
             return;
         }
 
-        glDeleteVertexArrays(1, &_vao);
+        GpuResourceTracker::deleteVertexArrays(1, &_vao);
         _vbo.deleteVBO();
+        _boundInstanceBufferID = 0;
+        _boundInstanceOffset = 0;
 
         _isInitialized = false;
     }
 
+    bool StaticMesh3D::isInitialized() const
+    {
+        return _isInitialized;
+    }
+
+    void StaticMesh3D::initializeData()
+    {
+        _isOnGLThread = true;
+        generateData();
+        uploadData();
+        _isOnGLThread = false;
+    }
+
     bool StaticMesh3D::hasPositions() const
     {
         return _hasPositions;
@@ -50,48 +131,241 @@ namespace static_meshes_3D {
         return _hasNormals;
     }
 
+    VertexLayout StaticMesh3D::getVertexLayout() const
+    {
+        return _vertexLayout;
+    }
+
     int StaticMesh3D::getVertexByteSize() const
     {
         int result = 0;
-        if (hasPositions()) {
-            result += sizeof(glm::vec3);
+        for (auto attributeIndex = POSITION_ATTRIBUTE_INDEX; attributeIndex <= NORMAL_ATTRIBUTE_INDEX; attributeIndex++)
+        {
+            if (hasAttribute(attributeIndex)) {
+                result += getAttributeByteSize(attributeIndex);
+            }
         }
-        if (hasTextureCoordinates()) {
-            result += sizeof(glm::vec2);
+
+        return result;
+    }
+
+    Bounds StaticMesh3D::getLocalBounds() const
+    {
+        return Bounds::fromBox(_localBox);
+    }
+
+    bool StaticMesh3D::hasAttribute(int attributeIndex) const
+    {
+        if (attributeIndex == POSITION_ATTRIBUTE_INDEX) {
+            return hasPositions();
         }
-        if (hasNormals()) {
-            result += sizeof(glm::vec3);
+        if (attributeIndex == TEXTURE_COORDINATE_ATTRIBUTE_INDEX) {
+            return hasTextureCoordinates();
         }
+        return attributeIndex == NORMAL_ATTRIBUTE_INDEX && hasNormals();
+    }
 
-        return result;
+    int StaticMesh3D::getAttributeByteSize(int attributeIndex) const
+    {
+        const auto isPacked = _vertexLayout == VertexLayout::InterleavedPacked;
+        if (attributeIndex == TEXTURE_COORDINATE_ATTRIBUTE_INDEX) {
+            return isPacked ? 2 * sizeof(uint16_t) : sizeof(glm::vec2);
+        }
+        if (attributeIndex == NORMAL_ATTRIBUTE_INDEX) {
+            return isPacked ? sizeof(uint32_t) : sizeof(glm::vec3);
+        }
+        return sizeof(glm::vec3);
+    }
+
+    size_t StaticMesh3D::getAttributeOffset(int attributeIndex, int numVertices) const
+    {
+        // Planar layout has whole arrays of previous attributes in front, interleaved only their single values
+        const auto numPrecedingValues = _vertexLayout == VertexLayout::Planar ? static_cast<size_t>(numVertices) : size_t(1);
+
+        size_t offset = 0;
+        for (auto i = POSITION_ATTRIBUTE_INDEX; i < attributeIndex; i++)
+        {
+            if (hasAttribute(i)) {
+                offset += getAttributeByteSize(i) * numPrecedingValues;
+            }
+        }
+
+        return offset;
+    }
+
+    int StaticMesh3D::getAttributeStride(int attributeIndex) const
+    {
+        return _vertexLayout == VertexLayout::Planar ? getAttributeByteSize(attributeIndex) : getVertexByteSize();
+    }
+
+    void StaticMesh3D::beginVertices(int numVertices)
+    {
+        const auto dataSizeBytes = static_cast<size_t>(getVertexByteSize()) * numVertices;
+        _vertexData = nullptr;
+        if (_isOnGLThread && dataSizeBytes > 0)
+        {
+            // No in-memory copy at all - the generator writes into the GPU buffer and uploadVertices unmaps it
+            _vbo.createVBO();
+            _vbo.bindVBO();
+            _vertexData = static_cast<unsigned char*>(_vbo.mapNewBufferToMemory(dataSizeBytes, GL_STATIC_DRAW));
+        }
+        _isVertexDataMapped = _vertexData != nullptr;
+        if (!_isVertexDataMapped) {
+            _vertexData = static_cast<unsigned char*>(_vbo.appendRawData(dataSizeBytes));
+        }
+        _numVerticesInData = numVertices;
+    }
+
+    void StaticMesh3D::uploadVertices()
+    {
+        if (_isVertexDataMapped)
+        {
+            _vbo.bindVBO();
+            _vbo.unmapBuffer();
+            _isVertexDataMapped = false;
+            return;
+        }
+
+        if (_vbo.getBufferID() == 0) {
+            _vbo.createVBO();
+        }
+        _vbo.bindVBO();
+        _vbo.uploadDataToGPU(GL_STATIC_DRAW);
+    }
+
+    void StaticMesh3D::writeVertex(int index, const glm::vec3& position, const glm::vec2& textureCoordinate, const glm::vec3& normal)
+    {
+        if (index < 0 || index >= _numVerticesInData)
+        {
+            std::cerr << "Vertex " << index << " is out of the block of " << _numVerticesInData << " vertices started by beginVertices!" << std::endl;
+            return;
+        }
+
+        const auto attributeAddress = [this, index](int attributeIndex) {
+            return _vertexData + getAttributeOffset(attributeIndex, _numVerticesInData) + static_cast<size_t>(getAttributeStride(attributeIndex)) * index;
+        };
+
+        if (hasPositions())
+        {
+            memcpy(attributeAddress(POSITION_ATTRIBUTE_INDEX), &position, sizeof(glm::vec3));
+            _localBox.expand(position);
+        }
+
+        if (hasTextureCoordinates())
+        {
+            if (_vertexLayout == VertexLayout::InterleavedPacked)
+            {
+                const uint16_t packed[2] = { packHalf(textureCoordinate.x), packHalf(textureCoordinate.y) };
+                memcpy(attributeAddress(TEXTURE_COORDINATE_ATTRIBUTE_INDEX), packed, sizeof(packed));
+            }
+            else {
+                memcpy(attributeAddress(TEXTURE_COORDINATE_ATTRIBUTE_INDEX), &textureCoordinate, sizeof(glm::vec2));
+            }
+        }
+
+        if (hasNormals())
+        {
+            if (_vertexLayout == VertexLayout::InterleavedPacked)
+            {
+                const auto packed = packNormal(normal);
+                memcpy(attributeAddress(NORMAL_ATTRIBUTE_INDEX), &packed, sizeof(packed));
+            }
+            else {
+                memcpy(attributeAddress(NORMAL_ATTRIBUTE_INDEX), &normal, sizeof(glm::vec3));
+            }
+        }
+    }
+
+    void StaticMesh3D::renderInstanced(const InstanceBuffer& instances) const
+    {
+        if (!_isInitialized || instances.getInstanceCount() == 0) {
+            return;
+        }
+
+        GLStateCache::bindVertexArray(_vao);
+        bindInstanceAttributes(instances);
+        renderInstancedGeometry(instances.getInstanceCount());
+    }
+
+    void StaticMesh3D::enqueueInstanced(RenderQueue& queue, const InstanceBuffer& instances, DrawPacket state, const glm::vec3& position) const
+    {
+        if (!_isInitialized || instances.getInstanceCount() == 0) {
+            return;
+        }
+
+        // Attribute setup is recorded in the VAO, so it can happen long before the queue draws
+        if (_boundInstanceBufferID != instances.getBufferID() || _boundInstanceOffset != instances.getBufferOffset())
+        {
+            GLStateCache::bindVertexArray(_vao);
+            bindInstanceAttributes(instances);
+        }
+
+        state.vao = _vao;
+        state.modelLocation = -1;
+        state.instanceCount = instances.getInstanceCount();
+        enqueueInstancedGeometry(queue, state, position);
     }
 
     void StaticMesh3D::setVertexAttributesPointers(int numVertices)
     {
-        uint64_t offset = 0;
+        const auto isPacked = _vertexLayout == VertexLayout::InterleavedPacked;
+        const auto attributePointer = [this, numVertices](int attributeIndex) {
+            return reinterpret_cast<void*>(static_cast<uintptr_t>(getAttributeOffset(attributeIndex, numVertices)));
+        };
+
         if (hasPositions())
         {
             glEnableVertexAttribArray(POSITION_ATTRIBUTE_INDEX);
-            glVertexAttribPointer(POSITION_ATTRIBUTE_INDEX, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), reinterpret_cast<void*>(offset));
-
-            offset += sizeof(glm::vec3) * numVertices;
+            glVertexAttribPointer(POSITION_ATTRIBUTE_INDEX, 3, GL_FLOAT, GL_FALSE,
+                getAttributeStride(POSITION_ATTRIBUTE_INDEX), attributePointer(POSITION_ATTRIBUTE_INDEX));
         }
 
         if (hasTextureCoordinates())
         {
             glEnableVertexAttribArray(TEXTURE_COORDINATE_ATTRIBUTE_INDEX);
-            glVertexAttribPointer(TEXTURE_COORDINATE_ATTRIBUTE_INDEX, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), reinterpret_cast<void*>(offset));
-
-            offset += sizeof(glm::vec2) * numVertices;
+            glVertexAttribPointer(TEXTURE_COORDINATE_ATTRIBUTE_INDEX, 2, isPacked ? GL_HALF_FLOAT : GL_FLOAT, GL_FALSE,
+                getAttributeStride(TEXTURE_COORDINATE_ATTRIBUTE_INDEX), attributePointer(TEXTURE_COORDINATE_ATTRIBUTE_INDEX));
         }
 
         if (hasNormals())
         {
+            // Packed normal must be fetched as 4 components, shader reads vec3 and W is dropped
             glEnableVertexAttribArray(NORMAL_ATTRIBUTE_INDEX);
-            glVertexAttribPointer(NORMAL_ATTRIBUTE_INDEX, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), reinterpret_cast<void*>(offset));
+            glVertexAttribPointer(NORMAL_ATTRIBUTE_INDEX, isPacked ? 4 : 3, isPacked ? GL_INT_2_10_10_10_REV : GL_FLOAT, isPacked ? GL_TRUE : GL_FALSE,
+                getAttributeStride(NORMAL_ATTRIBUTE_INDEX), attributePointer(NORMAL_ATTRIBUTE_INDEX));
+        }
+    }
+
+    void StaticMesh3D::bindInstanceAttributes(const InstanceBuffer& instances) const
+    {
+        // VAO remembers the attribute setup, so we only have to do this when instance buffer changes
+        // (streamed instances move to another region every frame)
+        if (_boundInstanceBufferID == instances.getBufferID() && _boundInstanceOffset == instances.getBufferOffset()) {
+            return;
+        }
+
+        const auto instanceOffset = static_cast<uintptr_t>(instances.getBufferOffset());
+
+        glBindBuffer(GL_ARRAY_BUFFER, instances.getBufferID());
 
-            offset += sizeof(glm::vec3) * numVertices;
+        // mat4 attribute takes 4 consecutive attribute slots, one per column
+        for (auto column = 0; column < 4; column++)
+        {
+            const auto attributeIndex = InstanceBuffer::MODEL_MATRIX_ATTRIBUTE_INDEX + column;
+            glEnableVertexAttribArray(attributeIndex);
+            glVertexAttribPointer(attributeIndex, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                reinterpret_cast<void*>(instanceOffset + offsetof(InstanceData, modelMatrix) + sizeof(glm::vec4) * column));
+            glVertexAttribDivisor(attributeIndex, 1);
         }
+
+        // Layer is an integer attribute, it must not go through float conversion
+        glEnableVertexAttribArray(InstanceBuffer::MATERIAL_LAYER_ATTRIBUTE_INDEX);
+        glVertexAttribIPointer(InstanceBuffer::MATERIAL_LAYER_ATTRIBUTE_INDEX, 1, GL_UNSIGNED_INT, sizeof(InstanceData),
+            reinterpret_cast<void*>(instanceOffset + offsetof(InstanceData, materialLayer)));
+        glVertexAttribDivisor(InstanceBuffer::MATERIAL_LAYER_ATTRIBUTE_INDEX, 1);
+
+        _boundInstanceBufferID = instances.getBufferID();
+        _boundInstanceOffset = instances.getBufferOffset();
     }
 
 } // namespace static_meshes_3D
@@ -4,11 +4,36 @@
 //this code creates our staticmesh3D functions
 
 #pragma once
+// GLM
+#include <glm/glm.hpp>
+
 // Project
 #include "vertexBufferObject.h"
+#include "instanceBuffer.h"
+#include "renderQueue.h"
+#include "boundingVolume.h"
 
 namespace static_meshes_3D {
 
+	/**
+	 * How vertex attributes are arranged in the vertex buffer.
+	 */
+	enum class VertexLayout
+	{
+		Planar, // All positions first, then all texture coordinates, then all normals
+		Interleaved, // Position, texture coordinate and normal of one vertex next to each other, all as floats
+		InterleavedPacked // Interleaved, texture coordinate as two half floats and normal as 2_10_10_10 signed normalized integer
+	};
+
+	/**
+	 * When mesh data gets generated and uploaded.
+	 */
+	enum class MeshInitialization
+	{
+		Immediate, // Constructor generates and uploads the data
+		Deferred // Owner calls generateData (any thread) and uploadData (OpenGL thread) later
+	};
+
 	/**
 	 * Represents generic 3D static mesh.
 	 */
@@ -19,7 +44,7 @@ namespace static_meshes_3D {
 		static const int TEXTURE_COORDINATE_ATTRIBUTE_INDEX; // Vertex attribute index of texture coordinate (1)
 		static const int NORMAL_ATTRIBUTE_INDEX; // Vertex attribute index of vertex normal (2)
 
-		StaticMesh3D(bool withPositions, bool withTextureCoordinates, bool withNormals);
+		StaticMesh3D(bool withPositions, bool withTextureCoordinates, bool withNormals, VertexLayout vertexLayout = VertexLayout::Interleaved);
 		virtual ~StaticMesh3D();
 
 		/**
@@ -33,11 +58,47 @@ namespace static_meshes_3D {
 		 */
 		virtual void renderPoints() const {}
 
+		/**
+		 * Renders all instances held in the instance buffer, using one draw call per mesh part.
+		 * Model matrix of every instance is fed as vertex attribute with divisor 1.
+		 *
+		 * @param instances  Buffer with per-instance model matrices
+		 */
+		void renderInstanced(const InstanceBuffer& instances) const;
+
+		/**
+		 * Pushes the instanced draws of renderInstanced to a render queue instead of drawing them now.
+		 * Instance attributes are wired into our VAO right away, the queue only binds it.
+		 *
+		 * @param queue      Queue of the current frame
+		 * @param instances  Buffer with per-instance model matrices, must not change until the queue is submitted
+		 * @param state      Program and texture the draws use, draw fields are filled in by the mesh
+		 * @param position   World position the draws are depth sorted by
+		 */
+		void enqueueInstanced(RenderQueue& queue, const InstanceBuffer& instances, DrawPacket state, const glm::vec3& position) const;
+
 		/**
 		 * Deletes static mesh data.
 		 */
 		virtual void deleteMesh();
 
+		/**
+		 * Generates vertex data on the CPU. Makes no OpenGL calls, so it may run on a worker thread.
+		 * Default implementation does nothing as its not needed for all classes.
+		 */
+		virtual void generateData() {}
+
+		/**
+		 * Creates VAO and uploads generated data, must run on the thread owning the OpenGL context.
+		 * Default implementation does nothing as its not needed for all classes.
+		 */
+		virtual void uploadData() {}
+
+		/**
+		 * Checks, if mesh data is uploaded and the mesh can be rendered.
+		 */
+		bool isInitialized() const;
+
 		/**
 		 * Checks, if static mesh has vertex positions.
 		 */
@@ -54,23 +115,42 @@ namespace static_meshes_3D {
 		bool hasNormals() const;
 
 		/**
-		 * Gets byte size of one vertex (depending on present vertex attributes).
+		 * Gets layout of vertex attributes in the vertex buffer.
+		 */
+		VertexLayout getVertexLayout() const;
+
+		/**
+		 * Gets byte size of one vertex (depending on present vertex attributes and vertex layout).
 		 */
 		int getVertexByteSize() const;
 
+		/**
+		 * Gets bounds of the mesh in its local space, gathered from the positions written by the generator.
+		 */
+		Bounds getLocalBounds() const;
+
 	protected:
 		bool _hasPositions = false; // Flag telling, if we have vertex positions
 		bool _hasTextureCoordinates = false; // Flag telling, if we have texture coordinates
 		bool _hasNormals = false; // Flag telling, if we have vertex normals
+		VertexLayout _vertexLayout = VertexLayout::Interleaved; // How attributes are arranged in the VBO
 
 		bool _isInitialized = false; // Is mesh initialized flag
 		GLuint _vao = 0; // VAO ID from OpenGL
 		VertexBufferObject _vbo; // Our VBO wrapper class holding static mesh data
+		mutable GLuint _boundInstanceBufferID = 0; // Instance buffer currently wired into our VAO
+		mutable GLintptr _boundInstanceOffset = 0; // Offset of the instances in that buffer
+
+		unsigned char* _vertexData = nullptr; // Vertex block appended to the VBO by beginVertices
+		bool _isVertexDataMapped = false; // Vertex block is the mapped VBO storage, not the in-memory buffer
+		bool _isOnGLThread = false; // Data is generated by initializeData, so the VBO may be mapped
+		int _numVerticesInData = 0; // Number of vertices in that block
+		BoundingBox _localBox; // Box of all positions passed to writeVertex
 
 		/**
-		 * Initializes vertex data. Default implementation does nothing as its not needed for all classes
+		 * Generates and uploads vertex data right away.
 		 */
-		virtual void initializeData() {}
+		void initializeData();
 
 		/**
 		* Sets vertex attribute pointers in a standard way.
@@ -78,6 +158,74 @@ namespace static_meshes_3D {
 		* @param numVertices  Number of vertices present in the buffer
 		*/
 		void setVertexAttributesPointers(int numVertices);
+
+		/**
+		 * Makes space for given number of vertices, they are then filled in with writeVertex. Meshes initialized
+		 * immediately (on the OpenGL thread) get the VBO storage mapped, so vertices go straight to the GPU buffer.
+		 * Deferred ones generate on any thread, their vertices are gathered in the VBO's in-memory buffer.
+		 *
+		 * @param numVertices  Number of vertices the mesh generator is going to write
+		 */
+		void beginVertices(int numVertices);
+
+		/**
+		 * Finishes upload of the vertices written since beginVertices - unmaps the VBO or uploads the gathered data.
+		 * Leaves the VBO bound to GL_ARRAY_BUFFER, ready for setVertexAttributesPointers.
+		 */
+		void uploadVertices();
+
+		/**
+		 * Writes vertex straight to its place in the current vertex layout, attributes the mesh does not have are skipped.
+		 *
+		 * @param index              Index of the vertex in the block started by beginVertices
+		 * @param position           Vertex position
+		 * @param textureCoordinate  Vertex texture coordinate
+		 * @param normal             Vertex normal (unit length)
+		 */
+		void writeVertex(int index, const glm::vec3& position, const glm::vec2& textureCoordinate, const glm::vec3& normal);
+
+		/**
+		 * Issues instanced draw calls of the mesh, VAO is already bound. Default implementation
+		 * does nothing, because different meshes have different logic for rendering.
+		 *
+		 * @param numInstances  Number of instances to render
+		 */
+		virtual void renderInstancedGeometry(GLsizei /*numInstances*/) const {}
+
+		/**
+		 * Pushes the same draws as renderInstancedGeometry to a queue. Default implementation does nothing.
+		 *
+		 * @param queue     Queue to push to
+		 * @param packet    Packet with state, VAO and instance count already set
+		 * @param position  World position the draws are depth sorted by
+		 */
+		virtual void enqueueInstancedGeometry(RenderQueue& /*queue*/, DrawPacket& /*packet*/, const glm::vec3& /*position*/) const {}
+
+	private:
+		/**
+		 * Gets byte size of one attribute of one vertex in the current vertex layout.
+		 */
+		int getAttributeByteSize(int attributeIndex) const;
+
+		/**
+		 * Gets byte offset of the first value of an attribute in a block of given number of vertices.
+		 */
+		size_t getAttributeOffset(int attributeIndex, int numVertices) const;
+
+		/**
+		 * Gets byte distance between values of an attribute of two consecutive vertices.
+		 */
+		int getAttributeStride(int attributeIndex) const;
+
+		/**
+		 * Checks, if mesh has given vertex attribute.
+		 */
+		bool hasAttribute(int attributeIndex) const;
+
+		/**
+		 * Points per-instance model matrix attributes of our VAO to given instance buffer.
+		 */
+		void bindInstanceAttributes(const InstanceBuffer& instances) const;
 	};
 
 }; // namespace static_meshes_3D
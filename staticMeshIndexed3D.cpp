@@ -3,13 +3,18 @@
 //version 2.1
 //  this code extends the functionality of the StaticMesh3D class to handle indexed meshes by introducing an index buffer object (_indicesVBO). It ensures proper resource management by deleting the index buffer object when the mesh is destroyed and follows the object-oriented principle of inheritance by extending the base class
 
+#include <algorithm>
+#include <limits>
+
 // Project
 #include "staticMeshIndexed3D.h"
+#include "glStateCache.h"
+#include "profiler.h"
 
 namespace static_meshes_3D {
 
-    StaticMeshIndexed3D::StaticMeshIndexed3D(bool withPositions, bool withTextureCoordinates, bool withNormals)
-        : StaticMesh3D(withPositions, withTextureCoordinates, withNormals) {}
+    StaticMeshIndexed3D::StaticMeshIndexed3D(bool withPositions, bool withTextureCoordinates, bool withNormals, VertexLayout vertexLayout)
+        : StaticMesh3D(withPositions, withTextureCoordinates, withNormals, vertexLayout) {}
 
     StaticMeshIndexed3D::~StaticMeshIndexed3D()
     {
@@ -27,4 +32,119 @@ namespace static_meshes_3D {
         }
     }
 
+    int StaticMeshIndexed3D::getNumVertices() const
+    {
+        return _numVertices;
+    }
+
+    int StaticMeshIndexed3D::getNumIndices() const
+    {
+        return _numIndices;
+    }
+
+    GLenum StaticMeshIndexed3D::getIndexType() const
+    {
+        return _indexType;
+    }
+
+    GLenum StaticMeshIndexed3D::chooseIndexType(int numVertices)
+    {
+        // Largest 16-bit value is taken by primitive restart, so 16-bit indices can address 65535 vertices
+        return numVertices < std::numeric_limits<GLushort>::max() ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    }
+
+    GLuint StaticMeshIndexed3D::getRestartIndex(int numVertices)
+    {
+        return chooseIndexType(numVertices) == GL_UNSIGNED_SHORT ? std::numeric_limits<GLushort>::max() : std::numeric_limits<GLuint>::max();
+    }
+
+    void StaticMeshIndexed3D::uploadIndices(const std::vector<GLuint>& indices, GLenum primitiveMode)
+    {
+        _indexType = chooseIndexType(_numVertices);
+        _primitiveRestartIndex = getRestartIndex(_numVertices);
+        _primitiveMode = primitiveMode;
+        _numIndices = static_cast<int>(indices.size());
+
+        // Count triangles strip by strip, restart index ends a strip
+        _numTriangles = 0;
+        auto stripLength = 0;
+        for (const auto index : indices)
+        {
+            if (index == _primitiveRestartIndex)
+            {
+                _numTriangles += primitiveMode == GL_TRIANGLES ? stripLength / 3 : std::max(stripLength - 2, 0);
+                stripLength = 0;
+                continue;
+            }
+            stripLength++;
+        }
+        _numTriangles += primitiveMode == GL_TRIANGLES ? stripLength / 3 : std::max(stripLength - 2, 0);
+
+        const auto indexByteSize = _indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+        _indicesVBO.createVBO(indexByteSize * indices.size());
+        if (_indexType == GL_UNSIGNED_SHORT)
+        {
+            auto shortIndices = _indicesVBO.appendWriter<GLushort>(indices.size());
+            for (const auto index : indices) {
+                shortIndices.append(static_cast<GLushort>(index));
+            }
+        }
+        else {
+            _indicesVBO.addRawData(indices.data(), sizeof(GLuint) * indices.size());
+        }
+
+        // Element buffer binding is part of VAO state, so the VAO remembers it from now on
+        _indicesVBO.bindVBO(GL_ELEMENT_ARRAY_BUFFER);
+        _indicesVBO.uploadDataToGPU(GL_STATIC_DRAW);
+    }
+
+    void StaticMeshIndexed3D::render() const
+    {
+        if (!_isInitialized) {
+            return;
+        }
+
+        GLStateCache::bindVertexArray(_vao);
+        renderInstancedGeometry(1);
+    }
+
+    void StaticMeshIndexed3D::renderInstancedGeometry(GLsizei numInstances) const
+    {
+        glEnable(GL_PRIMITIVE_RESTART);
+        glPrimitiveRestartIndex(_primitiveRestartIndex);
+        if (numInstances == 1) {
+            glDrawElements(_primitiveMode, _numIndices, _indexType, nullptr);
+        }
+        else {
+            glDrawElementsInstanced(_primitiveMode, _numIndices, _indexType, nullptr, numInstances);
+        }
+        glDisable(GL_PRIMITIVE_RESTART);
+
+        Profiler::countDrawTriangles(_numTriangles, numInstances);
+    }
+
+    void StaticMeshIndexed3D::enqueueInstancedGeometry(RenderQueue& queue, DrawPacket& packet, const glm::vec3& position) const
+    {
+        packet.kind = DrawKind::Elements;
+        packet.mode = _primitiveMode;
+        packet.count = _numIndices;
+        packet.indexType = _indexType;
+        packet.indexOffset = 0;
+        packet.isPrimitiveRestart = true;
+        packet.primitiveRestartIndex = _primitiveRestartIndex;
+        packet.numTriangles = _numTriangles;
+        queue.push(packet, position);
+    }
+
+    void StaticMeshIndexed3D::renderPoints() const
+    {
+        if (!_isInitialized) {
+            return;
+        }
+
+        // Every vertex is stored once, so just render all of them as they are stored in the VBO
+        GLStateCache::bindVertexArray(_vao);
+        glDrawArrays(GL_POINTS, 0, _numVertices);
+    }
+
 } // namespace static_meshes_3D
@@ -4,28 +4,76 @@
 //this code represents generic 3D static mesh rendered with indexed rendering.
 
 #pragma once
+#include <vector>
+
 // Project
 #include "staticMesh3D.h"
 
 namespace static_meshes_3D {
 
     /**
-     * Represents generic 3D static mesh rendered with indexed rendering.
+     * Represents generic 3D static mesh rendered with indexed rendering. Whole mesh is submitted
+     * with one glDrawElements - separate strips are joined with primitive restart index. Indices are
+     * stored as 16-bit whenever the vertex count allows it, 32-bit otherwise.
      */
     class StaticMeshIndexed3D : public StaticMesh3D
     {
     public:
-        StaticMeshIndexed3D(bool withPositions, bool withTextureCoordinates, bool withNormals);
+        StaticMeshIndexed3D(bool withPositions, bool withTextureCoordinates, bool withNormals, VertexLayout vertexLayout = VertexLayout::Interleaved);
         virtual ~StaticMeshIndexed3D();
 
+        void render() const override;
+        void renderPoints() const override;
         void deleteMesh() override;
 
+        /**
+         * Gets number of unique vertices of the mesh.
+         */
+        int getNumVertices() const;
+
+        /**
+         * Gets number of indices, primitive restart indices included.
+         */
+        int getNumIndices() const;
+
+        /**
+         * Gets type of stored indices (GL_UNSIGNED_SHORT or GL_UNSIGNED_INT).
+         */
+        GLenum getIndexType() const;
+
+        /**
+         * Picks smallest index type able to address given number of vertices, while keeping its
+         * largest value free for primitive restart.
+         */
+        static GLenum chooseIndexType(int numVertices);
+
     protected:
         VertexBufferObject _indicesVBO; // Our VBO wrapper class holding indices data
 
         int _numVertices = 0; // Holds the total number of generated vertices
         int _numIndices = 0; // Holds the number of generated indices used for rendering
-        int _primitiveRestartIndex = 0; // Index of primitive restart
+        int _numTriangles = 0; // Number of triangles the indices form, for profiler statistics
+        GLuint _primitiveRestartIndex = 0; // Index of primitive restart
+        GLenum _indexType = GL_UNSIGNED_INT; // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+        GLenum _primitiveMode = GL_TRIANGLES; // Primitive type drawn from the indices
+        std::vector<GLuint> _generatedIndices; // Indices waiting between generateData and uploadData
+
+        /**
+         * Returns primitive restart index for a mesh with given number of vertices, mesh generators
+         * write it between strips and uploadIndices keeps it as restart index of the chosen index type.
+         */
+        static GLuint getRestartIndex(int numVertices);
+
+        /**
+         * Creates index buffer, converts indices to the chosen index type and uploads them. VAO must be bound.
+         *
+         * @param indices        Indices of the mesh, strips separated by getRestartIndex(_numVertices)
+         * @param primitiveMode  Primitive type drawn from the indices
+         */
+        void uploadIndices(const std::vector<GLuint>& indices, GLenum primitiveMode);
+
+        void renderInstancedGeometry(GLsizei numInstances) const override;
+        void enqueueInstancedGeometry(RenderQueue& queue, DrawPacket& packet, const glm::vec3& position) const override;
     };
 
 }; // namespace static_meshes_3D
@@ -0,0 +1,257 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code streams per-frame data (uniform blocks, instances, dynamic vertices) to the GPU through one mapped ring buffer
+
+#include <cstring>
+#include <iostream>
+
+// Project
+#include "streamingBuffer.h"
+#include "gpuResourceTracker.h"
+#include "profiler.h"
+
+namespace {
+
+    PFNGLBUFFERSTORAGEPROC bufferStorage = nullptr; // glBufferStorage, when the context has it
+
+    /**
+     * Checks the extension list of the context (GL 3.0+ way, one string per extension).
+     */
+    bool hasExtension(const char* name)
+    {
+        GLint numExtensions = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+        for (GLint i = 0; i < numExtensions; i++)
+        {
+            const auto extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+            if (extension != nullptr && strcmp(extension, name) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+} // namespace
+
+const int StreamingBuffer::NUM_REGIONS = 3;
+
+bool StreamingBuffer::Allocation::isValid() const
+{
+    return data != nullptr;
+}
+
+bool StreamingBuffer::loadEntryPoints(GLADloadproc load)
+{
+    // Loaders hand out pointers for functions the context does not support, so the version is checked first
+    const auto isSupported = GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 4) || hasExtension("GL_ARB_buffer_storage");
+    bufferStorage = isSupported ? reinterpret_cast<PFNGLBUFFERSTORAGEPROC>(load("glBufferStorage")) : nullptr;
+    return bufferStorage != nullptr;
+}
+
+PFNGLBUFFERSTORAGEPROC StreamingBuffer::getBufferStorage()
+{
+    return bufferStorage;
+}
+
+StreamingBuffer::~StreamingBuffer()
+{
+    deleteBuffer();
+}
+
+bool StreamingBuffer::create(GLsizeiptr regionSize)
+{
+    if (bufferID_ != 0)
+    {
+        std::cerr << "This streaming buffer is already created! You need to delete it before re-creating it!" << std::endl;
+        return false;
+    }
+
+    // Regions start at offsets usable for uniform blocks
+    GLint uniformAlignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+    uniformAlignment_ = uniformAlignment;
+    regionSize_ = (regionSize + uniformAlignment_ - 1) / uniformAlignment_ * uniformAlignment_;
+    const auto bufferSize = regionSize_ * NUM_REGIONS;
+
+    GpuResourceTracker::genBuffers(1, &bufferID_);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, bufferID_);
+    stats_ = Stats();
+    if (bufferStorage != nullptr)
+    {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        bufferStorage(GL_COPY_WRITE_BUFFER, bufferSize, nullptr, flags);
+        mapped_ = static_cast<unsigned char*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, bufferSize, flags));
+        if (mapped_ == nullptr)
+        {
+            std::cerr << "Could not map streaming buffer of " << bufferSize << " bytes persistently!" << std::endl;
+            deleteBuffer();
+            return false;
+        }
+        isMapped_ = true;
+        stats_.isPersistent = true;
+    }
+    else
+    {
+        glBufferData(GL_COPY_WRITE_BUFFER, bufferSize, nullptr, GL_STREAM_DRAW);
+    }
+
+    fences_.assign(NUM_REGIONS, nullptr);
+    region_ = NUM_REGIONS - 1; // First frame starts at region 0
+    head_ = 0;
+    std::cout << "Created streaming buffer with ID " << bufferID_ << ", " << NUM_REGIONS << " regions of " << regionSize_ << " bytes"
+        << (stats_.isPersistent ? " (persistently mapped)" : " (mapped every frame)") << std::endl;
+    return true;
+}
+
+void StreamingBuffer::beginFrame()
+{
+    if (bufferID_ == 0) {
+        return;
+    }
+
+    finishWrites();
+    region_ = (region_ + 1) % NUM_REGIONS;
+    stats_.numStalls = 0;
+
+    // Region was last read NUM_REGIONS - 1 frames ago, normally its fence is long signaled
+    auto& fence = fences_[region_];
+    if (fence != nullptr)
+    {
+        auto result = glClientWaitSync(fence, 0, 0);
+        if (result == GL_TIMEOUT_EXPIRED)
+        {
+            stats_.numStalls++;
+            do {
+                result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+            } while (result == GL_TIMEOUT_EXPIRED);
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    head_ = 0;
+    mapRegion();
+}
+
+StreamingBuffer::Allocation StreamingBuffer::allocate(GLsizeiptr size, GLsizeiptr alignment)
+{
+    Allocation result;
+    if (!isMapped_) {
+        return result;
+    }
+
+    const auto offset = (head_ + alignment - 1) & ~(alignment - 1);
+    if (offset + size > regionSize_)
+    {
+        std::cerr << "Streaming buffer region is full (" << head_ << " of " << regionSize_ << " bytes used, " << size << " more requested)!" << std::endl;
+        return result;
+    }
+
+    // Persistent mapping covers the whole buffer, the per frame one only the current region
+    const auto regionStart = region_ * regionSize_;
+    result.data = mapped_ + (stats_.isPersistent ? regionStart : 0) + offset;
+    result.offset = regionStart + offset;
+    result.size = size;
+    head_ = offset + size;
+    return result;
+}
+
+StreamingBuffer::Allocation StreamingBuffer::push(const void* ptrData, GLsizeiptr size, GLsizeiptr alignment)
+{
+    const auto result = allocate(size, alignment);
+    if (result.isValid()) {
+        memcpy(result.data, ptrData, size);
+    }
+    return result;
+}
+
+void StreamingBuffer::bindRange(GLenum target, GLuint index, const Allocation& allocation) const
+{
+    if (allocation.isValid()) {
+        glBindBufferRange(target, index, bufferID_, allocation.offset, allocation.size);
+    }
+}
+
+void StreamingBuffer::finishWrites()
+{
+    // Coherent mapping makes writes visible by itself, the GPU may read while it stays mapped
+    if (stats_.isPersistent || !isMapped_) {
+        return;
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, bufferID_);
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    mapped_ = nullptr;
+    isMapped_ = false;
+}
+
+void StreamingBuffer::endFrame()
+{
+    if (bufferID_ == 0) {
+        return;
+    }
+
+    finishWrites();
+    fences_[region_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    stats_.bytesUsed = static_cast<size_t>(head_);
+    Profiler::addCounter("streamed bytes", static_cast<double>(stats_.bytesUsed));
+    Profiler::addCounter("streaming stalls", static_cast<double>(stats_.numStalls));
+}
+
+GLuint StreamingBuffer::getBufferID() const
+{
+    return bufferID_;
+}
+
+GLsizeiptr StreamingBuffer::getUniformAlignment() const
+{
+    return uniformAlignment_;
+}
+
+const StreamingBuffer::Stats& StreamingBuffer::getStats() const
+{
+    return stats_;
+}
+
+void StreamingBuffer::deleteBuffer()
+{
+    if (bufferID_ == 0) {
+        return;
+    }
+
+    if (isMapped_)
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, bufferID_);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    }
+    for (auto& fence : fences_)
+    {
+        if (fence != nullptr) {
+            glDeleteSync(fence);
+        }
+    }
+
+    GpuResourceTracker::deleteBuffers(1, &bufferID_);
+    bufferID_ = 0;
+    fences_.clear();
+    mapped_ = nullptr;
+    isMapped_ = false;
+    head_ = 0;
+}
+
+void StreamingBuffer::mapRegion()
+{
+    if (stats_.isPersistent) {
+        return;
+    }
+
+    // Unsynchronized, because the fence already told the GPU is done with the region
+    glBindBuffer(GL_COPY_WRITE_BUFFER, bufferID_);
+    mapped_ = static_cast<unsigned char*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, region_ * regionSize_, regionSize_,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+    isMapped_ = mapped_ != nullptr;
+    if (!isMapped_) {
+        std::cerr << "Could not map region " << region_ << " of streaming buffer " << bufferID_ << "!" << std::endl;
+    }
+}
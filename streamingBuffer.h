@@ -0,0 +1,145 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code streams per-frame data (uniform blocks, instances, dynamic vertices) to the GPU through one mapped ring buffer
+
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// GLAD
+#include <glad/glad.h>
+
+/**
+ * Ring buffer for data rewritten every frame. The buffer is split into NUM_REGIONS regions, one per
+ * frame in flight: the CPU writes the region of the current frame while the GPU still reads the two
+ * before it, and a fence placed after the draws of a frame tells when its region may be written again.
+ * Writes are bump allocations from the start of the region, so a frame costs no buffer (re)allocation
+ * and no copy inside the driver.
+ *
+ * With GL 4.4 or ARB_buffer_storage the storage is immutable and mapped once, persistently and coherently.
+ * Otherwise the region of the frame is mapped unsynchronized at the start of the frame and unmapped
+ * before drawing - the fences make that just as safe, only the map calls are extra.
+ */
+class StreamingBuffer
+{
+public:
+    static const int NUM_REGIONS; // Frames in flight (3)
+
+    /**
+     * Part of the current region returned by allocate.
+     */
+    struct Allocation
+    {
+        void* data = nullptr; // Where to write, nullptr if the allocation did not fit
+        GLintptr offset = 0; // Byte offset of data in the buffer, for binding and attribute pointers
+        GLsizeiptr size = 0;
+
+        bool isValid() const;
+    };
+
+    /**
+     * Work of the last finished frame.
+     */
+    struct Stats
+    {
+        size_t bytesUsed = 0; // Bytes allocated from the region
+        size_t numStalls = 0; // Times the CPU waited for the GPU to release the region (0 or 1)
+        bool isPersistent = false; // Buffer is mapped persistently
+    };
+
+    /**
+     * Loads glBufferStorage. The GL loader of the project stops at GL 4.3, so it is looked up here,
+     * right after the loader ran. Without it, buffers fall back to mapping every frame.
+     *
+     * @param load  Function loader, same as for gladLoadGLLoader
+     *
+     * @return True, if persistent mapping is available.
+     */
+    static bool loadEntryPoints(GLADloadproc load);
+
+    /**
+     * Gets glBufferStorage found by loadEntryPoints, nullptr when the context does not have it.
+     * Other persistently mapped buffers (texture upload ring) use it too.
+     */
+    static PFNGLBUFFERSTORAGEPROC getBufferStorage();
+
+    StreamingBuffer() = default;
+    StreamingBuffer(const StreamingBuffer&) = delete;
+    StreamingBuffer& operator=(const StreamingBuffer&) = delete;
+    ~StreamingBuffer();
+
+    /**
+     * Creates the buffer and maps it, if it can be mapped persistently.
+     *
+     * @param regionSize  Bytes available to one frame
+     *
+     * @return True, if the buffer was created.
+     */
+    bool create(GLsizeiptr regionSize);
+
+    /**
+     * Moves to the next region, waits for the GPU to finish reading it and resets allocations.
+     */
+    void beginFrame();
+
+    /**
+     * Allocates a part of the current region. Data must be written before finishWrites.
+     *
+     * @param size       Size in bytes
+     * @param alignment  Alignment of the offset, a power of two (getUniformAlignment for uniform blocks)
+     *
+     * @return The allocation, invalid if the region is full.
+     */
+    Allocation allocate(GLsizeiptr size, GLsizeiptr alignment = 16);
+
+    /**
+     * Allocates a part of the current region and copies data to it.
+     */
+    Allocation push(const void* ptrData, GLsizeiptr size, GLsizeiptr alignment = 16);
+
+    /**
+     * Binds an allocation to an indexed binding point, like a uniform block.
+     *
+     * @param target      GL_UNIFORM_BUFFER, GL_SHADER_STORAGE_BUFFER...
+     * @param index       Binding point
+     * @param allocation  Allocation of this frame
+     */
+    void bindRange(GLenum target, GLuint index, const Allocation& allocation) const;
+
+    /**
+     * Ends writing of the frame, must be called before the GPU reads the region (unmaps it, when
+     * the buffer is not persistent).
+     */
+    void finishWrites();
+
+    /**
+     * Fences the region after the last draw reading it was issued and reports frame counters.
+     */
+    void endFrame();
+
+    GLuint getBufferID() const;
+    GLsizeiptr getUniformAlignment() const;
+    const Stats& getStats() const;
+
+    /**
+     * Unmaps and deletes the buffer and the fences.
+     */
+    void deleteBuffer();
+
+private:
+    /**
+     * Maps the current region, when the buffer is not mapped persistently.
+     */
+    void mapRegion();
+
+    GLuint bufferID_{ 0 };
+    GLsizeiptr regionSize_{ 0 };
+    GLsizeiptr uniformAlignment_{ 256 };
+    unsigned char* mapped_{ nullptr }; // Whole buffer when persistent, the current region otherwise
+    std::vector<GLsync> fences_; // One per region, null when the GPU is done with it
+    int region_{ 0 };
+    GLsizeiptr head_{ 0 }; // Bytes allocated from the current region
+    bool isMapped_{ false };
+    Stats stats_;
+};
@@ -0,0 +1,510 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code cooks source images into .ctex files offline: precomputed mip chains, optionally BC1 / BC3 compressed
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TEXTURE_COOKER_SSE2
+#include <emmintrin.h>
+#endif
+
+// Project
+#include "textureCooker.h"
+#include "jobSystem.h"
+#include "stb_image.h"
+
+namespace {
+
+    const size_t BLOCK_ROWS_PER_JOB = 8;
+    const int POWER_ITERATIONS = 4; // Enough for the principal axis of 16 colors
+
+    /**
+     * Colors of a 4x4 block split by channel, so SSE2 can work on four pixels at once.
+     */
+    struct BlockColors
+    {
+        alignas(16) float r[16];
+        alignas(16) float g[16];
+        alignas(16) float b[16];
+    };
+
+    uint16_t packColor565(const float color[3])
+    {
+        const auto quantize = [](float value, int maxValue) {
+            return static_cast<uint16_t>(std::min(std::max(static_cast<int>(value * maxValue / 255.0f + 0.5f), 0), maxValue));
+        };
+        return static_cast<uint16_t>((quantize(color[0], 31) << 11) | (quantize(color[1], 63) << 5) | quantize(color[2], 31));
+    }
+
+    // Expands like the GPU does, by repeating the high bits
+    void unpackColor565(uint16_t packed, float color[3])
+    {
+        const auto r = (packed >> 11) & 31;
+        const auto g = (packed >> 5) & 63;
+        const auto b = packed & 31;
+        color[0] = static_cast<float>((r << 3) | (r >> 2));
+        color[1] = static_cast<float>((g << 2) | (g >> 4));
+        color[2] = static_cast<float>((b << 3) | (b >> 2));
+    }
+
+    /**
+     * Picks the two block colors lying furthest apart along the principal axis of the block.
+     */
+    void findEndpoints(const BlockColors& colors, float first[3], float second[3])
+    {
+        float mean[3] = { 0.0f, 0.0f, 0.0f };
+        for (auto i = 0; i < 16; i++)
+        {
+            mean[0] += colors.r[i];
+            mean[1] += colors.g[i];
+            mean[2] += colors.b[i];
+        }
+        for (auto& channel : mean) {
+            channel /= 16.0f;
+        }
+
+        // Covariance matrix, symmetric - rr, rg, rb, gg, gb, bb
+        float covariance[6] = {};
+        for (auto i = 0; i < 16; i++)
+        {
+            const auto r = colors.r[i] - mean[0];
+            const auto g = colors.g[i] - mean[1];
+            const auto b = colors.b[i] - mean[2];
+            covariance[0] += r * r;
+            covariance[1] += r * g;
+            covariance[2] += r * b;
+            covariance[3] += g * g;
+            covariance[4] += g * b;
+            covariance[5] += b * b;
+        }
+
+        float axis[3] = { 1.0f, 1.0f, 1.0f };
+        for (auto iteration = 0; iteration < POWER_ITERATIONS; iteration++)
+        {
+            const float next[3] = {
+                covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+                covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+                covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2]
+            };
+            const auto length = std::max(std::max(std::fabs(next[0]), std::fabs(next[1])), std::fabs(next[2]));
+            if (length < 1.0e-6f) {
+                break; // Flat block, any axis will do
+            }
+            for (auto c = 0; c < 3; c++) {
+                axis[c] = next[c] / length;
+            }
+        }
+
+        auto minIndex = 0;
+        auto maxIndex = 0;
+        auto minProjection = 0.0f;
+        auto maxProjection = 0.0f;
+        for (auto i = 0; i < 16; i++)
+        {
+            const auto projection = colors.r[i] * axis[0] + colors.g[i] * axis[1] + colors.b[i] * axis[2];
+            if (i == 0 || projection < minProjection)
+            {
+                minProjection = projection;
+                minIndex = i;
+            }
+            if (i == 0 || projection > maxProjection)
+            {
+                maxProjection = projection;
+                maxIndex = i;
+            }
+        }
+
+        first[0] = colors.r[maxIndex];
+        first[1] = colors.g[maxIndex];
+        first[2] = colors.b[maxIndex];
+        second[0] = colors.r[minIndex];
+        second[1] = colors.g[minIndex];
+        second[2] = colors.b[minIndex];
+    }
+
+    /**
+     * Gets 2-bit index of the nearest palette color of every pixel, pixel 0 in the lowest bits.
+     */
+    uint32_t selectColorIndices(const BlockColors& colors, const float palette[4][3])
+    {
+        alignas(16) int32_t nearest[16];
+#ifdef TEXTURE_COOKER_SSE2
+        for (auto group = 0; group < 16; group += 4)
+        {
+            const auto r = _mm_load_ps(colors.r + group);
+            const auto g = _mm_load_ps(colors.g + group);
+            const auto b = _mm_load_ps(colors.b + group);
+            auto bestDistance = _mm_set1_ps(1.0e30f);
+            auto bestIndex = _mm_setzero_si128();
+            for (auto k = 0; k < 4; k++)
+            {
+                const auto dr = _mm_sub_ps(r, _mm_set1_ps(palette[k][0]));
+                const auto dg = _mm_sub_ps(g, _mm_set1_ps(palette[k][1]));
+                const auto db = _mm_sub_ps(b, _mm_set1_ps(palette[k][2]));
+                const auto distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+                const auto isCloser = _mm_castps_si128(_mm_cmplt_ps(distance, bestDistance));
+                bestDistance = _mm_min_ps(distance, bestDistance);
+                bestIndex = _mm_or_si128(_mm_and_si128(isCloser, _mm_set1_epi32(k)), _mm_andnot_si128(isCloser, bestIndex));
+            }
+            _mm_store_si128(reinterpret_cast<__m128i*>(nearest + group), bestIndex);
+        }
+#else
+        for (auto i = 0; i < 16; i++)
+        {
+            auto bestDistance = 1.0e30f;
+            nearest[i] = 0;
+            for (auto k = 0; k < 4; k++)
+            {
+                const auto dr = colors.r[i] - palette[k][0];
+                const auto dg = colors.g[i] - palette[k][1];
+                const auto db = colors.b[i] - palette[k][2];
+                const auto distance = dr * dr + dg * dg + db * db;
+                if (distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    nearest[i] = k;
+                }
+            }
+        }
+#endif
+
+        uint32_t indices = 0;
+        for (auto i = 0; i < 16; i++) {
+            indices |= static_cast<uint32_t>(nearest[i]) << (2 * i);
+        }
+        return indices;
+    }
+
+    /**
+     * Writes 8 byte color block - two 565 endpoints and 16 2-bit indices, always in four-color mode.
+     */
+    void encodeColorBlock(const unsigned char* rgba, unsigned char* block)
+    {
+        BlockColors colors;
+        for (auto i = 0; i < 16; i++)
+        {
+            colors.r[i] = rgba[i * 4 + 0];
+            colors.g[i] = rgba[i * 4 + 1];
+            colors.b[i] = rgba[i * 4 + 2];
+        }
+
+        float first[3], second[3];
+        findEndpoints(colors, first, second);
+        auto color0 = packColor565(first);
+        auto color1 = packColor565(second);
+
+        // color0 > color1 selects four colors, equal endpoints mean a single color block
+        uint32_t indices = 0;
+        if (color0 != color1)
+        {
+            if (color0 < color1) {
+                std::swap(color0, color1);
+            }
+
+            float palette[4][3];
+            unpackColor565(color0, palette[0]);
+            unpackColor565(color1, palette[1]);
+            for (auto c = 0; c < 3; c++)
+            {
+                palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+                palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+            }
+            indices = selectColorIndices(colors, palette);
+        }
+
+        block[0] = static_cast<unsigned char>(color0 & 0xFF);
+        block[1] = static_cast<unsigned char>(color0 >> 8);
+        block[2] = static_cast<unsigned char>(color1 & 0xFF);
+        block[3] = static_cast<unsigned char>(color1 >> 8);
+        for (auto i = 0; i < 4; i++) {
+            block[4 + i] = static_cast<unsigned char>((indices >> (8 * i)) & 0xFF);
+        }
+    }
+
+    /**
+     * Writes 8 byte alpha block - the two extreme alphas and 16 3-bit indices into the 8 alphas between them.
+     */
+    void encodeAlphaBlock(const unsigned char* rgba, unsigned char* block)
+    {
+        int alpha0 = 0;
+        int alpha1 = 255;
+        for (auto i = 0; i < 16; i++)
+        {
+            alpha0 = std::max(alpha0, static_cast<int>(rgba[i * 4 + 3]));
+            alpha1 = std::min(alpha1, static_cast<int>(rgba[i * 4 + 3]));
+        }
+
+        uint64_t indices = 0;
+        if (alpha0 != alpha1)
+        {
+            // alpha0 > alpha1 selects eight alphas, codes 2..7 are the steps from alpha0 towards alpha1
+            for (auto i = 0; i < 16; i++)
+            {
+                const auto step = ((alpha0 - rgba[i * 4 + 3]) * 14 + (alpha0 - alpha1)) / (2 * (alpha0 - alpha1));
+                const uint64_t code = step == 0 ? 0 : step == 7 ? 1 : static_cast<uint64_t>(step + 1);
+                indices |= code << (3 * i);
+            }
+        }
+
+        block[0] = static_cast<unsigned char>(alpha0);
+        block[1] = static_cast<unsigned char>(alpha1);
+        for (auto i = 0; i < 6; i++) {
+            block[2 + i] = static_cast<unsigned char>((indices >> (8 * i)) & 0xFF);
+        }
+    }
+
+    const char* getFormatName(TextureFileFormat format)
+    {
+        switch (format)
+        {
+        case TextureFileFormat::BC1: return "BC1";
+        case TextureFileFormat::BC3: return "BC3";
+        default: return "RGBA8";
+        }
+    }
+
+} // namespace
+
+bool TextureCooker::cook(const std::string& sourcePath, const std::string& outputPath, TextureCookFormat format, uint32_t size, std::ostream& log)
+{
+    Image image;
+    int width, height, numComponents;
+    auto* pixels = stbi_load(sourcePath.c_str(), &width, &height, &numComponents, 4);
+    if (pixels == nullptr)
+    {
+        std::cerr << "Texture failed to load at path: " << sourcePath << std::endl;
+        return false;
+    }
+    image.width = static_cast<uint32_t>(width);
+    image.height = static_cast<uint32_t>(height);
+    if (size > 0 && (image.width != size || image.height != size))
+    {
+        image.pixels = resize(pixels, image.width, image.height, size, size);
+        image.width = image.height = size;
+    }
+    else {
+        image.pixels.assign(pixels, pixels + static_cast<size_t>(image.width) * image.height * 4);
+    }
+    stbi_image_free(pixels);
+
+    auto fileFormat = TextureFileFormat::RGBA8;
+    if (format == TextureCookFormat::Auto)
+    {
+        auto isOpaque = true;
+        for (size_t i = 3; isOpaque && i < image.pixels.size(); i += 4) {
+            isOpaque = image.pixels[i] == 255;
+        }
+        fileFormat = isOpaque ? TextureFileFormat::BC1 : TextureFileFormat::BC3;
+    }
+    else if (format == TextureCookFormat::BC1) {
+        fileFormat = TextureFileFormat::BC1;
+    }
+    else if (format == TextureCookFormat::BC3) {
+        fileFormat = TextureFileFormat::BC3;
+    }
+
+    // Whole chain down to 1x1, same as glGenerateMipmap would make
+    std::vector<Image> mipChain;
+    mipChain.push_back(std::move(image));
+    while (mipChain.back().width > 1 || mipChain.back().height > 1) {
+        mipChain.push_back(downsample(mipChain.back()));
+    }
+
+    TextureFileHeader header;
+    std::memcpy(header.magic, TEXTURE_FILE_MAGIC, sizeof(TEXTURE_FILE_MAGIC));
+    header.version = TEXTURE_FILE_VERSION;
+    header.format = fileFormat;
+    header.width = mipChain[0].width;
+    header.height = mipChain[0].height;
+    header.numLevels = static_cast<uint32_t>(mipChain.size());
+
+    std::vector<TextureFileLevel> levels(mipChain.size());
+    std::vector<std::vector<unsigned char>> levelData(mipChain.size());
+    auto offset = sizeof(TextureFileHeader) + levels.size() * sizeof(TextureFileLevel);
+    size_t uncompressedSize = 0;
+    for (size_t i = 0; i < mipChain.size(); i++)
+    {
+        levelData[i] = encodeLevel(mipChain[i], fileFormat);
+        offset = (offset + TEXTURE_FILE_DATA_ALIGNMENT - 1) / TEXTURE_FILE_DATA_ALIGNMENT * TEXTURE_FILE_DATA_ALIGNMENT;
+        levels[i].width = mipChain[i].width;
+        levels[i].height = mipChain[i].height;
+        levels[i].offset = offset;
+        levels[i].byteSize = levelData[i].size();
+        offset += levelData[i].size();
+        uncompressedSize += mipChain[i].pixels.size();
+    }
+
+    std::ofstream file(outputPath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        std::cerr << "Could not open " << outputPath << " for writing!" << std::endl;
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(levels.data()), levels.size() * sizeof(TextureFileLevel));
+    for (size_t i = 0; i < levels.size(); i++)
+    {
+        const char padding[TEXTURE_FILE_DATA_ALIGNMENT] = {};
+        file.write(padding, static_cast<std::streamsize>(levels[i].offset - static_cast<uint64_t>(file.tellp())));
+        file.write(reinterpret_cast<const char*>(levelData[i].data()), levelData[i].size());
+    }
+    if (!file.good())
+    {
+        std::cerr << "Writing " << outputPath << " failed!" << std::endl;
+        return false;
+    }
+
+    log << std::fixed << std::setprecision(1) << "Cooked " << sourcePath << " -> " << outputPath << ": " << header.width << "x" << header.height
+        << ", " << header.numLevels << " levels, " << getFormatName(fileFormat) << ", " << offset / 1024.0 << " KB (RGBA8 with mipmaps "
+        << uncompressedSize / 1024.0 << " KB)" << std::defaultfloat << std::endl;
+    return true;
+}
+
+bool TextureCooker::parseFormat(const std::string& name, TextureCookFormat& format)
+{
+    if (name == "auto") {
+        format = TextureCookFormat::Auto;
+    }
+    else if (name == "rgba8") {
+        format = TextureCookFormat::RGBA8;
+    }
+    else if (name == "bc1") {
+        format = TextureCookFormat::BC1;
+    }
+    else if (name == "bc3") {
+        format = TextureCookFormat::BC3;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+void TextureCooker::encodeBC1Block(const unsigned char* rgba, unsigned char* block)
+{
+    encodeColorBlock(rgba, block);
+}
+
+void TextureCooker::encodeBC3Block(const unsigned char* rgba, unsigned char* block)
+{
+    encodeAlphaBlock(rgba, block);
+    encodeColorBlock(rgba, block + 8);
+}
+
+std::vector<unsigned char> TextureCooker::resize(const unsigned char* rgba, uint32_t width, uint32_t height, uint32_t newWidth, uint32_t newHeight)
+{
+    Image image;
+    image.width = width;
+    image.height = height;
+    image.pixels.assign(rgba, rgba + static_cast<size_t>(width) * height * 4);
+
+    // Bilinear alone would skip source pixels when shrinking a lot, box halving averages all of them first
+    while (image.width >= newWidth * 2 && image.height >= newHeight * 2) {
+        image = downsample(image);
+    }
+    if (image.width == newWidth && image.height == newHeight) {
+        return image.pixels;
+    }
+
+    std::vector<unsigned char> result(static_cast<size_t>(newWidth) * newHeight * 4);
+    const auto scaleX = static_cast<float>(image.width) / newWidth;
+    const auto scaleY = static_cast<float>(image.height) / newHeight;
+    for (uint32_t y = 0; y < newHeight; y++)
+    {
+        // Pixel centers of both images line up
+        const auto sourceY = std::max((y + 0.5f) * scaleY - 0.5f, 0.0f);
+        const auto y0 = std::min(static_cast<uint32_t>(sourceY), image.height - 1);
+        const auto y1 = std::min(y0 + 1, image.height - 1);
+        const auto fy = sourceY - y0;
+        for (uint32_t x = 0; x < newWidth; x++)
+        {
+            const auto sourceX = std::max((x + 0.5f) * scaleX - 0.5f, 0.0f);
+            const auto x0 = std::min(static_cast<uint32_t>(sourceX), image.width - 1);
+            const auto x1 = std::min(x0 + 1, image.width - 1);
+            const auto fx = sourceX - x0;
+            for (auto c = 0; c < 4; c++)
+            {
+                const auto top = image.pixels[(y0 * image.width + x0) * 4 + c] * (1.0f - fx) + image.pixels[(y0 * image.width + x1) * 4 + c] * fx;
+                const auto bottom = image.pixels[(y1 * image.width + x0) * 4 + c] * (1.0f - fx) + image.pixels[(y1 * image.width + x1) * 4 + c] * fx;
+                result[(y * newWidth + x) * 4 + c] = static_cast<unsigned char>(top * (1.0f - fy) + bottom * fy + 0.5f);
+            }
+        }
+    }
+
+    return result;
+}
+
+TextureCooker::Image TextureCooker::downsample(const Image& image)
+{
+    Image result;
+    result.width = std::max(image.width / 2, 1u);
+    result.height = std::max(image.height / 2, 1u);
+    result.pixels.resize(static_cast<size_t>(result.width) * result.height * 4);
+
+    // 2x2 box filter, the odd last row / column of the source is clamped to
+    for (uint32_t y = 0; y < result.height; y++)
+    {
+        const auto y0 = std::min(y * 2, image.height - 1);
+        const auto y1 = std::min(y * 2 + 1, image.height - 1);
+        for (uint32_t x = 0; x < result.width; x++)
+        {
+            const auto x0 = std::min(x * 2, image.width - 1);
+            const auto x1 = std::min(x * 2 + 1, image.width - 1);
+            for (auto c = 0; c < 4; c++)
+            {
+                const auto sum = image.pixels[(y0 * image.width + x0) * 4 + c] + image.pixels[(y0 * image.width + x1) * 4 + c]
+                    + image.pixels[(y1 * image.width + x0) * 4 + c] + image.pixels[(y1 * image.width + x1) * 4 + c];
+                result.pixels[(y * result.width + x) * 4 + c] = static_cast<unsigned char>((sum + 2) / 4);
+            }
+        }
+    }
+
+    return result;
+}
+
+std::vector<unsigned char> TextureCooker::encodeLevel(const Image& image, TextureFileFormat format)
+{
+    if (format == TextureFileFormat::RGBA8) {
+        return image.pixels;
+    }
+
+    const auto blockBytes = format == TextureFileFormat::BC1 ? 8u : 16u;
+    const auto blocksX = (image.width + 3) / 4;
+    const auto blocksY = (image.height + 3) / 4;
+    std::vector<unsigned char> blocks(getTextureLevelByteSize(format, image.width, image.height));
+
+    // Rows of blocks are independent, pixels past the edge repeat the last row / column
+    JobSystem::parallelFor(blocksY, BLOCK_ROWS_PER_JOB, [&](size_t firstRow, size_t lastRow) {
+        unsigned char rgba[16 * 4];
+        for (auto blockY = static_cast<uint32_t>(firstRow); blockY < lastRow; blockY++)
+        {
+            for (uint32_t blockX = 0; blockX < blocksX; blockX++)
+            {
+                for (uint32_t i = 0; i < 16; i++)
+                {
+                    const auto x = std::min(blockX * 4 + i % 4, image.width - 1);
+                    const auto y = std::min(blockY * 4 + i / 4, image.height - 1);
+                    std::memcpy(rgba + i * 4, &image.pixels[(y * image.width + x) * 4], 4);
+                }
+
+                auto* block = &blocks[(blockY * blocksX + blockX) * blockBytes];
+                if (format == TextureFileFormat::BC1) {
+                    encodeBC1Block(rgba, block);
+                }
+                else {
+                    encodeBC3Block(rgba, block);
+                }
+            }
+        }
+    });
+
+    return blocks;
+}
@@ -0,0 +1,84 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code cooks source images into .ctex files offline: precomputed mip chains, optionally BC1 / BC3 compressed
+
+#pragma once
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Project
+#include "textureFile.h"
+
+/**
+ * Format a texture is cooked to, Auto picks BC1 for opaque images and BC3 for images with alpha.
+ */
+enum class TextureCookFormat
+{
+    Auto,
+    RGBA8,
+    BC1,
+    BC3
+};
+
+/**
+ * Offline texture preprocessing (the --texcook mode). Builds the whole mip chain with a box filter,
+ * compresses every level on the job system and writes a .ctex file the renderer maps and uploads as is.
+ * The block encoder fits endpoints along the principal axis of the block colors and picks indices
+ * four pixels at a time with SSE2 (plain C++ where SSE2 is not available).
+ */
+class TextureCooker
+{
+public:
+    /**
+     * Cooks one image.
+     *
+     * @param sourcePath  Any image stb_image reads (jpg, png...)
+     * @param outputPath  Cooked file to write
+     * @param format      Format of the cooked levels
+     * @param size        Width and height the image is resized to (layers of a MaterialArray must match), 0 keeps the image size
+     * @param log         Stream the summary line is printed to
+     *
+     * @return True, if the file was written.
+     */
+    static bool cook(const std::string& sourcePath, const std::string& outputPath, TextureCookFormat format, uint32_t size, std::ostream& log);
+
+    /**
+     * Parses format name of the command line (auto, rgba8, bc1, bc3).
+     *
+     * @return True, if the name is known.
+     */
+    static bool parseFormat(const std::string& name, TextureCookFormat& format);
+
+    /**
+     * Compresses one 4x4 block.
+     *
+     * @param rgba   16 RGBA8 pixels, row by row
+     * @param block  Output, 8 bytes for BC1 and 16 bytes for BC3
+     */
+    static void encodeBC1Block(const unsigned char* rgba, unsigned char* block);
+    static void encodeBC3Block(const unsigned char* rgba, unsigned char* block);
+
+    /**
+     * Resizes RGBA8 pixels - halves with the box filter while the image is at least twice the new size,
+     * then resamples bilinearly to the exact size.
+     *
+     * @return Pixels of the resized image.
+     */
+    static std::vector<unsigned char> resize(const unsigned char* rgba, uint32_t width, uint32_t height, uint32_t newWidth, uint32_t newHeight);
+
+private:
+    /**
+     * Pixels of one mip level, RGBA8.
+     */
+    struct Image
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<unsigned char> pixels;
+    };
+
+    static Image downsample(const Image& image);
+    static std::vector<unsigned char> encodeLevel(const Image& image, TextureFileFormat format);
+};
@@ -0,0 +1,272 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code reads cooked texture files (.ctex) - mip chains ready for the GPU, uploaded straight from the mapped file
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Project
+#include "textureFile.h"
+#include "glStateCache.h"
+
+static_assert(sizeof(TextureFileHeader) == 24, "Texture file header must match the file layout");
+static_assert(sizeof(TextureFileLevel) == 24, "Texture file level must match the file layout");
+
+namespace {
+
+    // S3TC formats come from EXT_texture_compression_s3tc, which the GL loader was not generated with
+    const GLenum COMPRESSED_RGB_S3TC_DXT1 = 0x83F0;
+    const GLenum COMPRESSED_RGBA_S3TC_DXT5 = 0x83F3;
+
+    const uint32_t MAX_LEVELS = 32;
+
+} // namespace
+
+size_t getTextureLevelByteSize(TextureFileFormat format, uint32_t width, uint32_t height)
+{
+    const size_t numBlocks = static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4);
+    switch (format)
+    {
+    case TextureFileFormat::BC1: return numBlocks * 8;
+    case TextureFileFormat::BC3: return numBlocks * 16;
+    default: return static_cast<size_t>(width) * height * 4;
+    }
+}
+
+GLenum getTextureInternalFormat(TextureFileFormat format)
+{
+    switch (format)
+    {
+    case TextureFileFormat::BC1: return COMPRESSED_RGB_S3TC_DXT1;
+    case TextureFileFormat::BC3: return COMPRESSED_RGBA_S3TC_DXT5;
+    default: return GL_RGBA8;
+    }
+}
+
+std::string getCookedTexturePath(const std::string& sourcePath)
+{
+    const auto dot = sourcePath.find_last_of('.');
+    const auto slash = sourcePath.find_last_of("/\\");
+    const auto hasExtension = dot != std::string::npos && (slash == std::string::npos || dot > slash);
+    return (hasExtension ? sourcePath.substr(0, dot) : sourcePath) + TEXTURE_FILE_EXTENSION;
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string& path)
+{
+    close();
+
+#ifdef _WIN32
+    const auto file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    const auto mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const auto* view = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (view == nullptr)
+    {
+        if (mapping != nullptr) {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        return false;
+    }
+
+    fileHandle_ = file;
+    mappingHandle_ = mapping;
+    data_ = static_cast<const unsigned char*>(view);
+    size_ = static_cast<size_t>(fileSize.QuadPart);
+#else
+    const auto file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0)
+    {
+        ::close(file);
+        return false;
+    }
+
+    // The mapping keeps its own reference to the file, the descriptor is not needed any more
+    const auto view = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    ::close(file);
+    if (view == MAP_FAILED) {
+        return false;
+    }
+
+    data_ = static_cast<const unsigned char*>(view);
+    size_ = static_cast<size_t>(fileStat.st_size);
+#endif
+
+    return true;
+}
+
+const unsigned char* MappedFile::getData() const
+{
+    return data_;
+}
+
+size_t MappedFile::getSize() const
+{
+    return size_;
+}
+
+void MappedFile::close()
+{
+    if (data_ == nullptr) {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(data_);
+    CloseHandle(mappingHandle_);
+    CloseHandle(fileHandle_);
+    mappingHandle_ = fileHandle_ = nullptr;
+#else
+    munmap(const_cast<unsigned char*>(data_), size_);
+#endif
+    data_ = nullptr;
+    size_ = 0;
+}
+
+bool TextureFile::open(const std::string& path)
+{
+    close();
+    if (!file_.open(path)) {
+        return false;
+    }
+
+    const auto* data = file_.getData();
+    const auto size = file_.getSize();
+    const auto* header = reinterpret_cast<const TextureFileHeader*>(data);
+    if (size < sizeof(TextureFileHeader) || std::memcmp(header->magic, TEXTURE_FILE_MAGIC, sizeof(TEXTURE_FILE_MAGIC)) != 0
+        || header->version != TEXTURE_FILE_VERSION || header->numLevels == 0 || header->numLevels > MAX_LEVELS
+        || header->format > TextureFileFormat::BC3)
+    {
+        std::cerr << "Texture file " << path << " is not a cooked texture of version " << TEXTURE_FILE_VERSION << "!" << std::endl;
+        close();
+        return false;
+    }
+
+    const auto levelTableEnd = sizeof(TextureFileHeader) + header->numLevels * sizeof(TextureFileLevel);
+    const auto* levels = reinterpret_cast<const TextureFileLevel*>(data + sizeof(TextureFileHeader));
+    auto isValid = levelTableEnd <= size;
+    for (uint32_t i = 0; isValid && i < header->numLevels; i++)
+    {
+        const auto& level = levels[i];
+        isValid = level.byteSize == getTextureLevelByteSize(header->format, level.width, level.height)
+            && level.offset >= levelTableEnd && level.offset <= size && level.byteSize <= size - level.offset;
+    }
+    if (!isValid)
+    {
+        std::cerr << "Texture file " << path << " is truncated or its level table is broken!" << std::endl;
+        close();
+        return false;
+    }
+
+    header_ = header;
+    levels_ = levels;
+    return true;
+}
+
+bool TextureFile::isFormatSupported() const
+{
+    if (header_ == nullptr) {
+        return false;
+    }
+    if (header_->format == TextureFileFormat::RGBA8) {
+        return true;
+    }
+
+    GLint numFormats = 0;
+    glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &numFormats);
+    std::vector<GLint> formats(static_cast<size_t>(std::max(numFormats, 0)));
+    if (!formats.empty()) {
+        glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, formats.data());
+    }
+    const auto format = static_cast<GLint>(getTextureInternalFormat(header_->format));
+    return std::find(formats.begin(), formats.end(), format) != formats.end();
+}
+
+void TextureFile::upload(GLuint textureID) const
+{
+    if (header_ == nullptr) {
+        return;
+    }
+
+    GLStateCache::bindTexture(GL_TEXTURE_2D, textureID);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(header_->numLevels - 1));
+    for (uint32_t i = 0; i < header_->numLevels; i++)
+    {
+        const auto& level = levels_[i];
+        if (header_->format == TextureFileFormat::RGBA8)
+        {
+            glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i), GL_RGBA8, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, getLevelData(i));
+        }
+        else
+        {
+            glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i), getTextureInternalFormat(header_->format), level.width, level.height, 0,
+                static_cast<GLsizei>(level.byteSize), getLevelData(i));
+        }
+    }
+}
+
+const TextureFileHeader& TextureFile::getHeader() const
+{
+    return *header_;
+}
+
+const TextureFileLevel& TextureFile::getLevel(uint32_t level) const
+{
+    return levels_[level];
+}
+
+const unsigned char* TextureFile::getLevelData(uint32_t level) const
+{
+    return file_.getData() + levels_[level].offset;
+}
+
+size_t TextureFile::getVideoMemorySize() const
+{
+    size_t byteSize = 0;
+    for (uint32_t i = 0; header_ != nullptr && i < header_->numLevels; i++) {
+        byteSize += static_cast<size_t>(levels_[i].byteSize);
+    }
+    return byteSize;
+}
+
+void TextureFile::close()
+{
+    file_.close();
+    header_ = nullptr;
+    levels_ = nullptr;
+}
@@ -0,0 +1,145 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code reads cooked texture files (.ctex) - mip chains ready for the GPU, uploaded straight from the mapped file
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// GLAD
+#include <glad/glad.h>
+
+/**
+ * Pixel format of all levels of a cooked texture.
+ */
+enum class TextureFileFormat : uint32_t
+{
+    RGBA8 = 0, // Uncompressed, 4 bytes per pixel
+    BC1 = 1, // 4x4 blocks of 8 bytes, opaque color (DXT1)
+    BC3 = 2 // 4x4 blocks of 16 bytes, color with interpolated alpha (DXT5)
+};
+
+/**
+ * Start of a .ctex file, followed by numLevels TextureFileLevel entries (level 0 is the biggest).
+ * All numbers are little-endian, level data starts at TEXTURE_FILE_DATA_ALIGNMENT aligned offsets.
+ */
+struct TextureFileHeader
+{
+    char magic[4]; // "CTEX"
+    uint32_t version;
+    TextureFileFormat format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t numLevels;
+};
+
+/**
+ * Where one mip level lies in the file.
+ */
+struct TextureFileLevel
+{
+    uint32_t width;
+    uint32_t height;
+    uint64_t offset; // From the start of the file
+    uint64_t byteSize;
+};
+
+const char TEXTURE_FILE_MAGIC[4] = { 'C', 'T', 'E', 'X' };
+const uint32_t TEXTURE_FILE_VERSION = 1;
+const size_t TEXTURE_FILE_DATA_ALIGNMENT = 16;
+const char* const TEXTURE_FILE_EXTENSION = ".ctex";
+
+/**
+ * Gets size of one level of a texture in given format.
+ */
+size_t getTextureLevelByteSize(TextureFileFormat format, uint32_t width, uint32_t height);
+
+/**
+ * Gets OpenGL internal format of levels in given format (GL_RGBA8 or an S3TC format).
+ */
+GLenum getTextureInternalFormat(TextureFileFormat format);
+
+/**
+ * Gets path of the cooked file belonging to a source image ("wood.jpg" -> "wood.ctex").
+ */
+std::string getCookedTexturePath(const std::string& sourcePath);
+
+/**
+ * Read-only memory mapping of a whole file, the OS pages it in on demand instead of copying it.
+ */
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    /**
+     * Maps a file.
+     *
+     * @return True, if the file exists and was mapped.
+     */
+    bool open(const std::string& path);
+
+    const unsigned char* getData() const;
+    size_t getSize() const;
+
+    /**
+     * Unmaps the file.
+     */
+    void close();
+
+private:
+    const unsigned char* data_{ nullptr };
+    size_t size_{ 0 };
+#ifdef _WIN32
+    void* fileHandle_{ nullptr };
+    void* mappingHandle_{ nullptr };
+#endif
+};
+
+/**
+ * Cooked texture mapped from disk, the level table points straight into the mapping.
+ */
+class TextureFile
+{
+public:
+    /**
+     * Maps a .ctex file and checks its header and level table.
+     *
+     * @return True, if the file is a valid cooked texture.
+     */
+    bool open(const std::string& path);
+
+    /**
+     * Checks if the current OpenGL context can sample the format of this file.
+     */
+    bool isFormatSupported() const;
+
+    /**
+     * Uploads all levels to a texture, compressed levels go through glCompressedTexImage2D.
+     * Mipmaps come from the file, so nothing is generated by the driver.
+     *
+     * @param textureID  Texture to fill, it is bound to GL_TEXTURE_2D of the active unit
+     */
+    void upload(GLuint textureID) const;
+
+    const TextureFileHeader& getHeader() const;
+    const TextureFileLevel& getLevel(uint32_t level) const;
+    const unsigned char* getLevelData(uint32_t level) const;
+
+    /**
+     * Gets the size all levels take in video memory.
+     */
+    size_t getVideoMemorySize() const;
+
+    void close();
+
+private:
+    MappedFile file_;
+    const TextureFileHeader* header_{ nullptr };
+    const TextureFileLevel* levels_{ nullptr };
+};
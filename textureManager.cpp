@@ -0,0 +1,335 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code loads textures in the background: images decode on the job system and upload a few at a time every frame
+
+#include <cstring>
+#include <iostream>
+
+// Project
+#include "textureManager.h"
+#include "glStateCache.h"
+#include "gpuResourceTracker.h"
+#include "profiler.h"
+#include "streamingBuffer.h"
+#include "stb_image.h"
+#include "textureFile.h"
+
+const int TextureManager::NUM_STAGING_SEGMENTS = 3;
+const size_t TextureManager::DEFAULT_UPLOAD_BUDGET = 8 * 1024 * 1024;
+
+namespace {
+
+    const size_t STAGING_ALIGNMENT = 16; // Images start at aligned offsets of a segment, so copies stay fast
+
+    const GLubyte PLACEHOLDER_PIXEL[] = { 128, 128, 128, 255 };
+
+    size_t alignUp(size_t value, size_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    GLenum getPixelFormat(int numComponents)
+    {
+        switch (numComponents)
+        {
+        case 1: return GL_RED;
+        case 2: return GL_RG;
+        case 3: return GL_RGB;
+        default: return GL_RGBA;
+        }
+    }
+
+    void setSamplerParameters()
+    {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+
+    /**
+     * Replaces the placeholder with the image.
+     *
+     * @param pixels  Client memory, or byte offset into the bound pixel unpack buffer
+     */
+    void uploadImage(GLuint textureID, int width, int height, int numComponents, const void* pixels)
+    {
+        const auto format = getPixelFormat(numComponents);
+        GLStateCache::bindTexture(GL_TEXTURE_2D, textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, pixels);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        GLStateCache::bindTexture(GL_TEXTURE_2D, 0);
+    }
+
+} // namespace
+
+TextureManager::~TextureManager()
+{
+    deleteTextures();
+}
+
+bool TextureManager::create(size_t uploadBudgetBytes)
+{
+    if (stagingBufferID_ != 0)
+    {
+        std::cerr << "This texture manager is already created! You need to delete it before re-creating it!" << std::endl;
+        return false;
+    }
+
+    segmentSize_ = alignUp(uploadBudgetBytes, STAGING_ALIGNMENT);
+    const auto ringSize = segmentSize_ * NUM_STAGING_SEGMENTS;
+    segmentFences_.assign(NUM_STAGING_SEGMENTS, nullptr);
+    currentSegment_ = 0;
+
+    GpuResourceTracker::genBuffers(1, &stagingBufferID_);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stagingBufferID_);
+    // glad stops at GL 4.3, glBufferStorage comes from StreamingBuffer::loadEntryPoints (nullptr on 3.3 contexts)
+    const auto bufferStorage = StreamingBuffer::getBufferStorage();
+    if (bufferStorage != nullptr)
+    {
+        // Mapped once for the whole run, fences keep the CPU off segments the GPU still reads
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        bufferStorage(GL_PIXEL_UNPACK_BUFFER, ringSize, nullptr, flags);
+        persistentMemory_ = static_cast<unsigned char*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, ringSize, flags));
+        if (persistentMemory_ == nullptr)
+        {
+            // Immutable storage cannot be respecified, the ring gets a fresh buffer for glBufferData below
+            std::cerr << "Texture upload ring could not be mapped persistently, mapping it per upload instead!" << std::endl;
+            GpuResourceTracker::deleteBuffers(1, &stagingBufferID_);
+            GpuResourceTracker::genBuffers(1, &stagingBufferID_);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stagingBufferID_);
+        }
+    }
+    if (persistentMemory_ == nullptr) {
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, ringSize, nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    return true;
+}
+
+GLuint TextureManager::load(const std::string& path)
+{
+    const auto existing = entriesByPath_.find(path);
+    if (existing != entriesByPath_.end()) {
+        return existing->second->textureID;
+    }
+
+    entries_.push_back(std::unique_ptr<Entry>(new Entry()));
+    auto* entry = entries_.back().get();
+    entry->path = path;
+    entriesByPath_[path] = entry;
+    GpuResourceTracker::genTextures(1, &entry->textureID);
+
+    // A cooked file next to the image already has its mip chain in the GPU format, it goes up right from the mapping
+    TextureFile cookedFile;
+    if (cookedFile.open(getCookedTexturePath(path)) && cookedFile.isFormatSupported())
+    {
+        cookedFile.upload(entry->textureID);
+        setSamplerParameters();
+        GLStateCache::bindTexture(GL_TEXTURE_2D, 0);
+        return entry->textureID;
+    }
+
+    numPending_++;
+    GLStateCache::bindTexture(GL_TEXTURE_2D, entry->textureID);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, PLACEHOLDER_PIXEL);
+    setSamplerParameters();
+    GLStateCache::bindTexture(GL_TEXTURE_2D, 0);
+
+    // Decoding touches only the entry, the texture is replaced later by update on the main thread
+    JobSystem::submit([this, entry]() {
+        entry->pixels = stbi_load(entry->path.c_str(), &entry->width, &entry->height, &entry->numComponents, 0);
+        std::lock_guard<std::mutex> lock(decodedMutex_);
+        decodedEntries_.push_back(entry);
+    }, &decodeJobs_);
+
+    return entry->textureID;
+}
+
+void TextureManager::update()
+{
+    if (numPending_ > 0) {
+        uploadReady(false);
+    }
+}
+
+void TextureManager::finishLoading()
+{
+    JobSystem::wait(decodeJobs_);
+    while (numPending_ > 0)
+    {
+        const auto numPendingBefore = numPending_;
+        uploadReady(true);
+        if (numPending_ == numPendingBefore) {
+            break;
+        }
+    }
+}
+
+size_t TextureManager::getNumPending() const
+{
+    return numPending_;
+}
+
+void TextureManager::deleteTextures()
+{
+    // Jobs still decoding would write into deleted entries
+    JobSystem::wait(decodeJobs_);
+
+    for (const auto& entry : entries_)
+    {
+        GpuResourceTracker::deleteTextures(1, &entry->textureID);
+        stbi_image_free(entry->pixels);
+    }
+    entries_.clear();
+    entriesByPath_.clear();
+    decodedEntries_.clear();
+    uploadQueue_.clear();
+    numPending_ = 0;
+
+    for (auto& fence : segmentFences_)
+    {
+        if (fence != nullptr) {
+            glDeleteSync(fence);
+        }
+    }
+    segmentFences_.clear();
+
+    if (stagingBufferID_ != 0)
+    {
+        if (persistentMemory_ != nullptr)
+        {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stagingBufferID_);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            persistentMemory_ = nullptr;
+        }
+        GpuResourceTracker::deleteBuffers(1, &stagingBufferID_);
+        stagingBufferID_ = 0;
+    }
+}
+
+void TextureManager::uploadReady(bool isBlocking)
+{
+    {
+        std::lock_guard<std::mutex> lock(decodedMutex_);
+        uploadQueue_.insert(uploadQueue_.end(), decodedEntries_.begin(), decodedEntries_.end());
+        decodedEntries_.clear();
+    }
+    if (uploadQueue_.empty() || stagingBufferID_ == 0) {
+        return;
+    }
+
+    auto& fence = segmentFences_[currentSegment_];
+    if (fence != nullptr)
+    {
+        // GPU still reads this segment - the upload waits for a later frame rather than stalling this one
+        const auto status = glClientWaitSync(fence, 0, isBlocking ? GL_TIMEOUT_IGNORED : 0);
+        if (status == GL_TIMEOUT_EXPIRED) {
+            return;
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    // Take images in request order while they fit into the segment, an image bigger than a whole segment
+    // goes alone straight from client memory
+    struct StagedImage
+    {
+        Entry* entry;
+        size_t offset;
+    };
+    std::vector<StagedImage> staged;
+    Entry* oversized = nullptr;
+    size_t usedBytes = 0;
+    size_t numTaken = 0;
+    for (; numTaken < uploadQueue_.size(); numTaken++)
+    {
+        auto* entry = uploadQueue_[numTaken];
+        if (entry->pixels == nullptr)
+        {
+            std::cerr << "Texture failed to load at path: " << entry->path << std::endl;
+            continue;
+        }
+
+        const auto byteSize = getImageByteSize(*entry);
+        if (byteSize > segmentSize_)
+        {
+            if (staged.empty())
+            {
+                oversized = entry;
+                numTaken++;
+            }
+            break;
+        }
+        if (usedBytes + byteSize > segmentSize_) {
+            break;
+        }
+
+        staged.push_back({ entry, usedBytes });
+        usedBytes = alignUp(usedBytes + byteSize, STAGING_ALIGNMENT);
+    }
+
+    const auto segmentOffset = segmentSize_ * currentSegment_;
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stagingBufferID_);
+    if (!staged.empty())
+    {
+        // Unsynchronized is safe, the fence above says the GPU is done with the segment
+        auto* segmentMemory = persistentMemory_ != nullptr ? persistentMemory_ + segmentOffset
+            : static_cast<unsigned char*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, segmentOffset, segmentSize_,
+                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+        if (segmentMemory == nullptr)
+        {
+            std::cerr << "Texture upload segment could not be mapped!" << std::endl;
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            return;
+        }
+
+        for (const auto& image : staged) {
+            std::memcpy(segmentMemory + image.offset, image.entry->pixels, getImageByteSize(*image.entry));
+        }
+        if (persistentMemory_ == nullptr) {
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        }
+    }
+
+    // Decoded rows are tightly packed, RGB rows are not 4-byte aligned in general
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (const auto& image : staged)
+    {
+        const auto& entry = *image.entry;
+        uploadImage(entry.textureID, entry.width, entry.height, entry.numComponents, reinterpret_cast<const void*>(segmentOffset + image.offset));
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if (oversized != nullptr) {
+        uploadImage(oversized->textureID, oversized->width, oversized->height, oversized->numComponents, oversized->pixels);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    if (!staged.empty())
+    {
+        fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        currentSegment_ = (currentSegment_ + 1) % NUM_STAGING_SEGMENTS;
+    }
+
+    // Everything taken is done - uploaded, or failed and left with the placeholder
+    auto uploadedBytes = static_cast<double>(usedBytes);
+    if (oversized != nullptr) {
+        uploadedBytes += static_cast<double>(getImageByteSize(*oversized));
+    }
+    for (size_t i = 0; i < numTaken; i++)
+    {
+        stbi_image_free(uploadQueue_[i]->pixels);
+        uploadQueue_[i]->pixels = nullptr;
+    }
+    uploadQueue_.erase(uploadQueue_.begin(), uploadQueue_.begin() + numTaken);
+    numPending_ -= numTaken;
+    Profiler::addCounter("texture upload KB", uploadedBytes / 1024.0);
+}
+
+size_t TextureManager::getImageByteSize(const Entry& entry)
+{
+    return static_cast<size_t>(entry.width) * entry.height * entry.numComponents;
+}
@@ -0,0 +1,112 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code loads textures in the background: images decode on the job system and upload a few at a time every frame
+
+#pragma once
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// GLAD
+#include <glad/glad.h>
+
+// Project
+#include "jobSystem.h"
+
+/**
+ * Owner of all 2D textures of the scene. Images with a cooked .ctex file next to them (see TextureCooker)
+ * are uploaded right in load, straight from the mapped file. Otherwise load returns a texture name right away - the texture holds
+ * a 1x1 grey placeholder until the real image is in. Every path is decoded only once, on the job system,
+ * and update uploads decoded images through a ring of pixel unpack buffer segments, at most one segment
+ * per frame, so a frame never waits for a file or for a big upload. The ring is persistently mapped
+ * when the context has buffer storage (4.4), otherwise every segment is mapped unsynchronized while uploading.
+ */
+class TextureManager
+{
+public:
+    static const int NUM_STAGING_SEGMENTS; // Segments of the upload ring, one per frame in flight (3)
+    static const size_t DEFAULT_UPLOAD_BUDGET; // Default size of one segment - bytes uploaded per frame (8 MB)
+
+    TextureManager() = default;
+    TextureManager(const TextureManager&) = delete;
+    TextureManager& operator=(const TextureManager&) = delete;
+    ~TextureManager();
+
+    /**
+     * Creates the upload ring. Must be called once the OpenGL context exists.
+     *
+     * @param uploadBudgetBytes  Bytes of pixels uploaded per frame, bigger images are uploaded alone
+     *
+     * @return True, if the ring was created.
+     */
+    bool create(size_t uploadBudgetBytes = DEFAULT_UPLOAD_BUDGET);
+
+    /**
+     * Gets texture of an image file and starts loading it, if it is not loaded yet.
+     *
+     * @param path  Image file, same path always gives the same texture
+     *
+     * @return Texture name, usable immediately (shows the placeholder until the image is uploaded).
+     */
+    GLuint load(const std::string& path);
+
+    /**
+     * Uploads decoded images within the per-frame budget. Call once per frame.
+     */
+    void update();
+
+    /**
+     * Waits until every requested image is decoded and uploaded (benchmark runs want the final textures from the first frame).
+     */
+    void finishLoading();
+
+    /**
+     * Gets number of textures still showing the placeholder.
+     */
+    size_t getNumPending() const;
+
+    /**
+     * Waits for decoding jobs and deletes all textures and the upload ring.
+     */
+    void deleteTextures();
+
+private:
+    /**
+     * One image file and its texture.
+     */
+    struct Entry
+    {
+        std::string path;
+        GLuint textureID = 0;
+        int width = 0;
+        int height = 0;
+        int numComponents = 0;
+        unsigned char* pixels = nullptr; // Decoded image waiting for upload, nullptr when decoding failed
+    };
+
+    /**
+     * Uploads what fits into the current segment.
+     *
+     * @param isBlocking  True to wait for the GPU to release the segment, otherwise the frame skips uploading
+     */
+    void uploadReady(bool isBlocking);
+
+    static size_t getImageByteSize(const Entry& entry);
+
+    std::vector<std::unique_ptr<Entry>> entries_; // Pointers stay valid for decoding jobs
+    std::unordered_map<std::string, Entry*> entriesByPath_;
+    std::mutex decodedMutex_;
+    std::vector<Entry*> decodedEntries_; // Filled by decoding jobs
+    std::vector<Entry*> uploadQueue_; // Decoded entries taken over by the main thread, oldest first
+    JobCounter decodeJobs_;
+    size_t numPending_{ 0 };
+
+    GLuint stagingBufferID_{ 0 };
+    unsigned char* persistentMemory_{ nullptr }; // Whole ring, nullptr without buffer storage
+    size_t segmentSize_{ 0 };
+    std::vector<GLsync> segmentFences_; // Signaled when the GPU is done reading a segment
+    int currentSegment_{ 0 };
+};
@@ -0,0 +1,58 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code creates and updates uniform buffer objects shared by all of our shader programs
+
+#include <iostream>
+
+// Project
+#include "uniformBlocks.h"
+#include "gpuResourceTracker.h"
+
+UniformBuffer::~UniformBuffer()
+{
+    deleteUBO();
+}
+
+void UniformBuffer::createUBO(GLsizeiptr sizeBytes, GLuint bindingPoint)
+{
+    if (bufferID_ != 0)
+    {
+        std::cerr << "This uniform buffer is already created! You need to delete it before re-creating it!" << std::endl;
+        return;
+    }
+
+    GpuResourceTracker::genBuffers(1, &bufferID_);
+    glBindBuffer(GL_UNIFORM_BUFFER, bufferID_);
+    glBufferData(GL_UNIFORM_BUFFER, sizeBytes, nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, bufferID_);
+    sizeBytes_ = sizeBytes;
+}
+
+void UniformBuffer::update(const void* ptrData, GLsizeiptr dataSizeBytes, GLintptr offset) const
+{
+    if (bufferID_ == 0 || offset + dataSizeBytes > sizeBytes_)
+    {
+        std::cerr << "Uniform buffer update out of range (offset " << offset << ", size " << dataSizeBytes << ")!" << std::endl;
+        return;
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, bufferID_);
+    glBufferSubData(GL_UNIFORM_BUFFER, offset, dataSizeBytes, ptrData);
+}
+
+GLuint UniformBuffer::getBufferID() const
+{
+    return bufferID_;
+}
+
+void UniformBuffer::deleteUBO()
+{
+    if (bufferID_ == 0) {
+        return;
+    }
+
+    GpuResourceTracker::deleteBuffers(1, &bufferID_);
+    bufferID_ = 0;
+    sizeBytes_ = 0;
+}
@@ -0,0 +1,151 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code mirrors the std140 uniform blocks shared by our shaders and wraps the buffers holding them
+
+#pragma once
+
+// GLAD
+#include <glad/glad.h>
+
+// GLM
+#include <glm/glm.hpp>
+
+// Fixed binding points of the shared uniform blocks, every program compiled by Shader uses these
+const GLuint CAMERA_BLOCK_BINDING = 0;
+const GLuint LIGHTS_BLOCK_BINDING = 1;
+const GLuint CLUSTERS_BLOCK_BINDING = 2;
+
+// Names of the blocks as declared in the shader files
+const char* const CAMERA_BLOCK_NAME = "Camera";
+const char* const LIGHTS_BLOCK_NAME = "Lights";
+const char* const CLUSTERS_BLOCK_NAME = "Clusters";
+
+/**
+ * Camera uniform block (std140) - matrices and position of the camera.
+ */
+struct CameraBlock
+{
+    glm::mat4 projection;
+    glm::mat4 view;
+    glm::vec3 viewPos;
+    float padding;
+};
+
+/**
+ * Directional light as laid out in the Lights block (std140, every vec3 takes 16 bytes).
+ */
+struct DirLightBlock
+{
+    glm::vec3 direction;
+    float padding0;
+    glm::vec3 ambient;
+    float padding1;
+    glm::vec3 diffuse;
+    float padding2;
+    glm::vec3 specular;
+    float padding3;
+};
+
+/**
+ * Point light as read from the clustered light data texture buffer - four RGBA32F texels per light,
+ * scalars fill the gaps after vec3s.
+ */
+struct PointLightBlock
+{
+    glm::vec3 position;
+    float constant;
+    glm::vec3 ambient;
+    float linear;
+    glm::vec3 diffuse;
+    float quadratic;
+    glm::vec3 specular;
+    float radius; // Distance, after which the light is ignored (see ClusteredLightGrid::computeLightRadius)
+};
+
+/**
+ * Spot light as laid out in the Lights block, scalars fill the gaps after vec3s.
+ */
+struct SpotLightBlock
+{
+    glm::vec3 position;
+    float cutOff;
+    glm::vec3 direction;
+    float outerCutOff;
+    glm::vec3 ambient;
+    float constant;
+    glm::vec3 diffuse;
+    float linear;
+    glm::vec3 specular;
+    float quadratic;
+};
+
+/**
+ * Lights uniform block (std140) - lights affecting every fragment. Point lights are not here,
+ * they are binned into clusters by ClusteredLightGrid.
+ */
+struct LightsBlock
+{
+    DirLightBlock dirLight;
+    SpotLightBlock spotLight;
+};
+
+/**
+ * Clusters uniform block (std140) - how fragments find their cluster of the light grid.
+ */
+struct ClustersBlock
+{
+    glm::uvec4 gridSize; // Number of clusters along x, y (screen tiles) and z (depth slices), w is unused
+    glm::vec4 depthParams; // zNear, zFar, slice scale and slice bias (slice = log(depth) * scale - bias)
+    glm::vec2 screenSize; // Size of the viewport in pixels
+    glm::vec2 padding;
+};
+
+static_assert(sizeof(CameraBlock) == 144, "CameraBlock must match std140 layout of the Camera block");
+static_assert(sizeof(PointLightBlock) == 64, "PointLightBlock must be exactly four vec4 texels");
+static_assert(sizeof(SpotLightBlock) == 80, "SpotLightBlock must match std140 layout of SpotLight");
+static_assert(sizeof(LightsBlock) == 144, "LightsBlock must match std140 layout of the Lights block");
+static_assert(sizeof(ClustersBlock) == 48, "ClustersBlock must match std140 layout of the Clusters block");
+
+/**
+ * Wraps uniform buffer object attached to a fixed binding point.
+ */
+class UniformBuffer
+{
+public:
+    UniformBuffer() = default;
+    UniformBuffer(const UniformBuffer&) = delete;
+    UniformBuffer& operator=(const UniformBuffer&) = delete;
+    ~UniformBuffer();
+
+    /**
+     * Creates the buffer with given size and attaches it to the binding point.
+     *
+     * @param sizeBytes     Size of the whole block, in bytes
+     * @param bindingPoint  Uniform block binding point (CAMERA_BLOCK_BINDING, LIGHTS_BLOCK_BINDING...)
+     */
+    void createUBO(GLsizeiptr sizeBytes, GLuint bindingPoint);
+
+    /**
+     * Uploads new block contents with a single glBufferSubData call.
+     *
+     * @param ptrData        Pointer to the block data (usually one of the *Block structs)
+     * @param dataSizeBytes  Size of the data, in bytes
+     * @param offset         Byte offset in the buffer where to start
+     */
+    void update(const void* ptrData, GLsizeiptr dataSizeBytes, GLintptr offset = 0) const;
+
+    /**
+     * Gets OpenGL-assigned buffer ID.
+     */
+    GLuint getBufferID() const;
+
+    /**
+     * Deletes the buffer and frees GPU memory.
+     */
+    void deleteUBO();
+
+private:
+    GLuint bufferID_{ 0 }; // OpenGL assigned buffer ID
+    GLsizeiptr sizeBytes_{ 0 }; // Size of the buffer in bytes
+};
@@ -3,11 +3,13 @@
 //version 2.1
 //This class encapsulates the functionality related to creating, managing, and uploading data to VBOs in OpenGL applications. It provides methods for creating, binding, adding data, uploading data to the GPU, mapping buffers to memory, and deleting VBOs, among other operation
 
+#include <algorithm>
 #include <iostream>
 #include <cstring>
 
 // Project
 #include "vertexBufferObject.h"
+#include "gpuResourceTracker.h"
 
 void VertexBufferObject::createVBO(size_t reserveSizeBytes)
 {
@@ -17,9 +19,13 @@ void VertexBufferObject::createVBO(size_t reserveSizeBytes)
         return;
     }
 
-    glGenBuffers(1, &bufferID_);
-    rawData_.reserve(reserveSizeBytes > 0 ? reserveSizeBytes : 1024);
-    std::cout << "Created vertex buffer object with ID " << bufferID_ << " and initial reserved size " << rawData_.capacity() << " bytes" << std::endl;
+    GpuResourceTracker::genBuffers(1, &bufferID_);
+
+    // Data may have been gathered on a worker thread before the buffer existed, reserving again would drop it
+    if (bytesAdded_ == 0) {
+        reallocateRawData(reserveSizeBytes > 0 ? reserveSizeBytes : 1024);
+    }
+    std::cout << "Created vertex buffer object with ID " << bufferID_ << " and initial reserved size " << rawDataCapacity_ << " bytes" << std::endl;
 }
 
 void VertexBufferObject::bindVBO(GLenum bufferType)
@@ -36,36 +42,56 @@ void VertexBufferObject::bindVBO(GLenum bufferType)
 
 void VertexBufferObject::addRawData(const void* ptrData, size_t dataSizeBytes, size_t repeat)
 {
-    const auto bytesToAdd = dataSizeBytes * repeat;
+    // Repeated data is written by the byte writer doubling the copied run, not one memcpy per repeat
+    auto writer = appendWriter<unsigned char>(dataSizeBytes * repeat);
+    if (repeat > 0 && writer.append(static_cast<const unsigned char*>(ptrData), dataSizeBytes))
+    {
+        const auto* first = static_cast<const unsigned char*>(writer.getData());
+        while (writer.getCount() < writer.getCapacity()) {
+            writer.append(first, std::min(writer.getCount(), writer.getCapacity() - writer.getCount()));
+        }
+    }
+}
+
+void* VertexBufferObject::appendRawData(size_t dataSizeBytes)
+{
+    ensureCapacity(dataSizeBytes);
+
+    const auto result = rawData_.get() + bytesAdded_;
+    bytesAdded_ += dataSizeBytes;
+    return result;
+}
+
+void VertexBufferObject::ensureCapacity(size_t bytesToAdd)
+{
     const auto requiredCapacity = bytesAdded_ + bytesToAdd;
 
-    // If the current capacity isn't sufficient, let's resize the internal vector of raw data
-    if (requiredCapacity > rawData_.capacity())
+    // If the current capacity isn't sufficient, let's enlarge the internal raw data buffer
+    if (requiredCapacity > rawDataCapacity_)
     {
         // Determine new raw data buffer capacity - enlarge by a factor of two until it becomes big enough
-        auto newCapacity = rawData_.capacity() * 2;
+        auto newCapacity = std::max(rawDataCapacity_ * 2, size_t(1024));
         while (newCapacity < requiredCapacity) {
             newCapacity *= 2;
         }
-
-        // Reserve new vector with higher capacity (which will replace member rawData_) and copy existing data over
-        std::vector<unsigned char> newRawData;
-        newRawData.reserve(newCapacity);
-        memcpy(newRawData.data(), rawData_.data(), bytesAdded_);
-        rawData_ = std::move(newRawData);
+        reallocateRawData(newCapacity);
     }
+}
 
-    // Add the data now that we are sure that capacity is sufficient
-    for (size_t i = 0; i < repeat; i++)
-    {
-        memcpy(rawData_.data() + bytesAdded_, ptrData, dataSizeBytes);
-        bytesAdded_ += dataSizeBytes;
+void VertexBufferObject::reallocateRawData(size_t newCapacity)
+{
+    // Plain array, not a vector - a vector would have to be resized (and zeroed) for writes past its size to be valid
+    std::unique_ptr<unsigned char[]> newRawData(new unsigned char[newCapacity]);
+    if (bytesAdded_ > 0) {
+        memcpy(newRawData.get(), rawData_.get(), bytesAdded_);
     }
+    rawData_ = std::move(newRawData);
+    rawDataCapacity_ = newCapacity;
 }
 
 void* VertexBufferObject::getRawDataPointer()
 {
-    return rawData_.data();
+    return rawData_.get();
 }
 
 void VertexBufferObject::uploadDataToGPU(GLenum usageHint)
@@ -76,11 +102,32 @@ void VertexBufferObject::uploadDataToGPU(GLenum usageHint)
         return;
     }
 
-    glBufferData(bufferType_, bytesAdded_, rawData_.data(), usageHint);
+    glBufferData(bufferType_, bytesAdded_, rawData_.get(), usageHint);
     uploadedDataSize_ = bytesAdded_;
     bytesAdded_ = 0;
 }
 
+void* VertexBufferObject::mapNewBufferToMemory(size_t dataSizeBytes, GLenum usageHint)
+{
+    if (!isBufferCreated() || bufferType_ == 0 || dataSizeBytes == 0)
+    {
+        std::cerr << "This buffer is not created and bound yet! Call createVBO and bindVBO before mapping new data!" << std::endl;
+        return nullptr;
+    }
+
+    // Whole old contents are dropped, so the driver never has to wait for the GPU or copy them
+    glBufferData(bufferType_, dataSizeBytes, nullptr, usageHint);
+    auto* result = glMapBufferRange(bufferType_, 0, dataSizeBytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (result == nullptr)
+    {
+        std::cerr << "Could not map " << dataSizeBytes << " bytes of vertex buffer object with ID " << bufferID_ << "!" << std::endl;
+        return nullptr;
+    }
+
+    uploadedDataSize_ = dataSizeBytes;
+    return result;
+}
+
 void* VertexBufferObject::mapBufferToMemory(GLenum usageHint) const
 {
     if (!isDataUploaded()) {
@@ -121,7 +168,7 @@ void VertexBufferObject::deleteVBO()
     }
 
     std::cout << "Deleting vertex buffer object with ID " << bufferID_ << "..." << std::endl;
-    glDeleteBuffers(1, &bufferID_);
+    GpuResourceTracker::deleteBuffers(1, &bufferID_);
     bufferID_ = 0;
     bytesAdded_ = 0;
     uploadedDataSize_ = 0;
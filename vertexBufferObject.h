@@ -4,11 +4,14 @@
 // this code Wraps OpenGL's vertex buffer object to a convenient higher level class and loads data to the gpu. 
 
 #pragma once
-#include <vector>
+#include <memory>
 
 // GLAD
 #include <glad/glad.h>
 
+// Project
+#include "vertexWriter.h"
+
 /**
  * Wraps OpenGL's vertex buffer object to a convenient higher level class.
  */
@@ -16,7 +19,8 @@ class VertexBufferObject
 {
 public:
     /**
-     * Creates a new VBO, with optional reserved buffer size.
+     * Creates a new VBO, with optional reserved buffer size. Data may also be added before the VBO
+     * is created (mesh generation on a worker thread), then the reservation is skipped.
      *
      * @param reserveSizeBytes  Buffer size reservation, in bytes (so that no memory allocations happen while preparing buffer data)
      */
@@ -38,6 +42,49 @@ public:
      */
     void addRawData(const void* ptrData, size_t dataSizeBytes, size_t repeat = 1);
 
+    /**
+     * Appends given number of bytes to the in-memory buffer without filling them, so that mesh generators
+     * can write vertices straight into their final place. The pointer is valid until more data is added.
+     *
+     * @param dataSizeBytes  Size of the appended block (in bytes)
+     *
+     * @return Pointer to the start of the appended block.
+     */
+    void* appendRawData(size_t dataSizeBytes);
+
+    /**
+     * Appends space for given number of values to the in-memory buffer and returns a writer over it.
+     * The writer is valid until more data is added.
+     *
+     * @param count  Number of values of type T
+     */
+    template<typename T>
+    VertexWriter<T> appendWriter(size_t count)
+    {
+        return VertexWriter<T>(appendRawData(sizeof(T) * count), count);
+    }
+
+    /**
+     * Allocates GPU storage of given size and maps it for writing, so data can be written straight to the GPU
+     * buffer without gathering them in memory first. The buffer must be bound, unmapBuffer finishes the upload.
+     *
+     * @param dataSizeBytes  Size of the buffer, in bytes
+     * @param usageHint      Hint for OpenGL, how is the data intended to be used (GL_STATIC_DRAW, GL_DYNAMIC_DRAW)
+     *
+     * @return Pointer to the mapped buffer, or nullptr, if something fails.
+     */
+    void* mapNewBufferToMemory(size_t dataSizeBytes, GLenum usageHint);
+
+    /**
+     * Same as mapNewBufferToMemory, but returns a writer of given number of values over the mapped buffer.
+     * The writer is invalid, if mapping fails.
+     */
+    template<typename T>
+    VertexWriter<T> mapNewBufferWriter(size_t count, GLenum usageHint)
+    {
+        return VertexWriter<T>(mapNewBufferToMemory(sizeof(T) * count, usageHint), count);
+    }
+
     /**
      * Adds arbitrary data to the in-memory buffer, before they get uploaded.
      *
@@ -106,10 +153,21 @@ private:
     GLuint bufferID_{ 0 }; // OpenGL assigned buffer ID
     GLenum bufferType_{ 0 }; // Buffer type (GL_ARRAY_BUFFER, GL_ELEMENT_BUFFER...)
 
-    std::vector<unsigned char> rawData_; // In-memory raw data buffer, used to gather the data for VBO
+    std::unique_ptr<unsigned char[]> rawData_; // In-memory raw data buffer, used to gather the data for VBO
+    size_t rawDataCapacity_{ 0 }; // Bytes allocated for rawData_
     size_t bytesAdded_{ 0 }; // Number of bytes added to the buffer so far
     size_t uploadedDataSize_{ 0 }; // Holds buffer data size after uploading to GPU (if it's not null, then data have been uploaded)
 
+    /**
+     * Makes sure the in-memory buffer can hold given number of additional bytes.
+     */
+    void ensureCapacity(size_t bytesToAdd);
+
+    /**
+     * Reallocates the in-memory buffer with given capacity, keeping the bytes added so far.
+     */
+    void reallocateRawData(size_t newCapacity);
+
     /**
      * Checks if the buffer has been created and has OpenGL-assigned ID.
      */
@@ -0,0 +1,144 @@
+//Christopher Rode
+//Date: 10/17/26
+//version 2.2
+//this code writes vertices (or any trivial values) into a block of memory sized up front, with bounds checks
+
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <type_traits>
+
+/**
+ * Typed writer over a block of memory sized up front - a part of the in-memory buffer of a VertexBufferObject,
+ * or a mapped GPU buffer. Writes never allocate, and the ones that would run past the block are refused as a whole.
+ * Values are copied with memcpy, so the block does not have to be aligned for T (arena blocks follow
+ * whatever was added before them). appendN and fill copy an already written run of values to double it, so
+ * bulk writes cost a logarithmic number of memcpy calls instead of one per value.
+ */
+template<typename T>
+class VertexWriter
+{
+    static_assert(std::is_trivially_copyable<T>::value, "VertexWriter copies values with memcpy, T must be trivially copyable");
+
+public:
+    VertexWriter() = default;
+
+    /**
+     * @param ptrData   Start of the block, nullptr makes the writer invalid
+     * @param capacity  Number of values that fit into the block
+     */
+    VertexWriter(void* ptrData, size_t capacity)
+        : data_(static_cast<unsigned char*>(ptrData))
+        , capacity_(ptrData != nullptr ? capacity : 0) {}
+
+    /**
+     * Appends one value.
+     *
+     * @return True, if the value fit.
+     */
+    bool append(const T& value)
+    {
+        if (!checkSpace(1)) {
+            return false;
+        }
+
+        memcpy(data_ + count_ * sizeof(T), &value, sizeof(T));
+        count_++;
+        return true;
+    }
+
+    /**
+     * Appends an array of values with one memcpy.
+     *
+     * @return True, if all values fit (otherwise nothing is written).
+     */
+    bool append(const T* values, size_t count)
+    {
+        if (!checkSpace(count)) {
+            return false;
+        }
+
+        if (count > 0) {
+            memcpy(data_ + count_ * sizeof(T), values, sizeof(T) * count);
+        }
+        count_ += count;
+        return true;
+    }
+
+    /**
+     * Appends the same value given number of times.
+     *
+     * @return True, if all values fit (otherwise nothing is written).
+     */
+    bool appendN(const T& value, size_t count)
+    {
+        if (count == 0) {
+            return true;
+        }
+        if (!checkSpace(count)) {
+            return false;
+        }
+
+        auto* first = data_ + count_ * sizeof(T);
+        memcpy(first, &value, sizeof(T));
+
+        // Written run doubles with every copy, the last copy takes only what is left
+        size_t written = 1;
+        while (written < count)
+        {
+            const auto toCopy = written < count - written ? written : count - written;
+            memcpy(first + written * sizeof(T), first, toCopy * sizeof(T));
+            written += toCopy;
+        }
+        count_ += count;
+        return true;
+    }
+
+    /**
+     * Fills the rest of the block with a value.
+     */
+    void fill(const T& value)
+    {
+        appendN(value, capacity_ - count_);
+    }
+
+    /**
+     * Overwrites an already appended value.
+     *
+     * @return True, if the index was appended before.
+     */
+    bool set(size_t index, const T& value)
+    {
+        if (index >= count_)
+        {
+            std::cerr << "Vertex writer index " << index << " is out of range (" << count_ << " values written)!" << std::endl;
+            return false;
+        }
+
+        memcpy(data_ + index * sizeof(T), &value, sizeof(T));
+        return true;
+    }
+
+    bool isValid() const { return data_ != nullptr; }
+    bool isFull() const { return count_ == capacity_; }
+    size_t getCount() const { return count_; }
+    size_t getCapacity() const { return capacity_; }
+    size_t getBytesWritten() const { return count_ * sizeof(T); }
+    void* getData() const { return data_; }
+
+private:
+    bool checkSpace(size_t count) const
+    {
+        if (count > capacity_ - count_)
+        {
+            std::cerr << "Vertex writer is full (" << count_ << " of " << capacity_ << " values written, " << count << " more requested)!" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    unsigned char* data_{ nullptr };
+    size_t capacity_{ 0 };
+    size_t count_{ 0 };
+};